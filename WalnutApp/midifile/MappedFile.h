@@ -0,0 +1,134 @@
+//
+// Creation Date: Sat Oct 17 2026
+// Filename:      midifile/include/MappedFile.h
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab
+//
+// Description:   Read-only memory mapping of a file for the SMF readers.
+//
+
+#ifndef _MAPPEDFILE_H_INCLUDED
+#define _MAPPEDFILE_H_INCLUDED
+
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace smf {
+
+typedef unsigned char  uchar;
+
+//////////////////////////////
+//
+// MappedFile -- Read-only memory mapping of a whole file, used by the
+//     MidiFile and SmfEventStream reading functions to decode SMF bytes
+//     without going through an istream.  An empty file is reported as
+//     open with no data.
+//
+
+class MappedFile {
+	public:
+		MappedFile(const std::string& filename) {
+#ifdef _WIN32
+			m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+					NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (m_file == INVALID_HANDLE_VALUE) {
+				return;
+			}
+			LARGE_INTEGER filesize;
+			if (!GetFileSizeEx(m_file, &filesize)) {
+				return;
+			}
+			m_size = (size_t)filesize.QuadPart;
+			if (m_size > 0) {
+				m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (m_mapping == NULL) {
+					return;
+				}
+				m_data = (const uchar*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+				if (m_data == NULL) {
+					return;
+				}
+			}
+#else
+			m_file = open(filename.c_str(), O_RDONLY);
+			if (m_file < 0) {
+				return;
+			}
+			struct stat info;
+			if (fstat(m_file, &info) != 0) {
+				return;
+			}
+			m_size = (size_t)info.st_size;
+			if (m_size > 0) {
+				void* mapped = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+				if (mapped == MAP_FAILED) {
+					return;
+				}
+				madvise(mapped, m_size, MADV_SEQUENTIAL);
+				m_data = (const uchar*)mapped;
+			}
+#endif
+			m_open = true;
+		}
+
+		~MappedFile() {
+#ifdef _WIN32
+			if (m_data != NULL) {
+				UnmapViewOfFile(m_data);
+			}
+			if (m_mapping != NULL) {
+				CloseHandle(m_mapping);
+			}
+			if (m_file != INVALID_HANDLE_VALUE) {
+				CloseHandle(m_file);
+			}
+#else
+			if (m_data != NULL) {
+				munmap((void*)m_data, m_size);
+			}
+			if (m_file >= 0) {
+				close(m_file);
+			}
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool         isOpen (void) const { return m_open; }
+		const uchar* data   (void) const { return m_data; }
+		size_t       size   (void) const { return m_size; }
+
+	private:
+#ifdef _WIN32
+		HANDLE       m_file    = INVALID_HANDLE_VALUE;
+		HANDLE       m_mapping = NULL;
+#else
+		int          m_file    = -1;
+#endif
+		const uchar* m_data    = NULL;
+		size_t       m_size    = 0;
+		bool         m_open    = false;
+};
+
+} // end of namespace smf
+
+#endif /* _MAPPEDFILE_H_INCLUDED */
+
+
+
@@ -44,7 +44,7 @@ MidiEvent::MidiEvent(int command, int p1, int p2)
 }
 
 
-MidiEvent::MidiEvent(int aTime, int aTrack, vector<uchar>& message)
+MidiEvent::MidiEvent(int aTime, int aTrack, std::vector<uchar>& message)
 		: MidiMessage(message) {
 	track       = aTrack;
 	tick        = aTime;
@@ -133,7 +133,7 @@ MidiEvent& MidiEvent::operator=(const MidiMessage& message) {
 }
 
 
-MidiEvent& MidiEvent::operator=(const vector<uchar>& bytes) {
+MidiEvent& MidiEvent::operator=(const std::vector<uchar>& bytes) {
 	clearVariables();
 	this->resize(bytes.size());
 	for (int i=0; i<(int)this->size(); i++) {
@@ -143,14 +143,14 @@ MidiEvent& MidiEvent::operator=(const vector<uchar>& bytes) {
 }
 
 
-MidiEvent& MidiEvent::operator=(const vector<char>& bytes) {
+MidiEvent& MidiEvent::operator=(const std::vector<char>& bytes) {
 	clearVariables();
 	setMessage(bytes);
 	return *this;
 }
 
 
-MidiEvent& MidiEvent::operator=(const vector<int>& bytes) {
+MidiEvent& MidiEvent::operator=(const std::vector<int>& bytes) {
 	clearVariables();
 	setMessage(bytes);
 	return *this;
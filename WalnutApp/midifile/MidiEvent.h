@@ -61,6 +61,8 @@ class MidiEvent : public MidiMessage {
 	private:
 		MidiEvent* m_eventlink;  // used to match note-ons and note-offs
 
+	// MidiEventList::linkNotePairs() sets links directly
+	friend class MidiEventList;
 };
 
 } // end of namespace smf
@@ -0,0 +1,177 @@
+//
+// Creation Date: Sat Oct 17 2026
+// Filename:      midifile/src/MidiEventArena.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab
+//
+// Description:   Slab storage for the MidiEvents of a MidiFile.
+//
+
+#include "MidiEventArena.h"
+
+#include <new>
+#include <algorithm>
+
+namespace smf {
+
+//////////////////////////////
+//
+// MidiEventArena::MidiEventArena -- Constructor.  No storage is allocated
+//     until the first event is created (or reserve() is called).
+//
+
+MidiEventArena::MidiEventArena(void) {
+	// do nothing
+}
+
+
+
+//////////////////////////////
+//
+// MidiEventArena::~MidiEventArena -- Deconstructor.  Destroys all events
+//     created in the arena.
+//
+
+MidiEventArena::~MidiEventArena() {
+	clear();
+}
+
+
+
+//////////////////////////////
+//
+// MidiEventArena::create -- Construct a new event in the arena.  The event
+//     is owned by the arena and must not be deleted; it is destroyed by
+//     clear() or when the arena is deallocated.
+//
+
+MidiEvent* MidiEventArena::create(void) {
+	return new (allocate()) MidiEvent;
+}
+
+
+MidiEvent* MidiEventArena::create(const MidiEvent& event) {
+	return new (allocate()) MidiEvent(event);
+}
+
+
+
+//////////////////////////////
+//
+// MidiEventArena::reserve -- Make sure that the next count events are
+//     stored contiguously in a single slab.
+//
+
+void MidiEventArena::reserve(int count) {
+	if (count <= 0) {
+		return;
+	}
+	if (!m_slabs.empty() && (m_slabs.back().capacity - m_slabs.back().used >= count)) {
+		return;
+	}
+	addSlab(count);
+}
+
+
+
+//////////////////////////////
+//
+// MidiEventArena::adopt -- Take over all events of another arena, which
+//     is left empty.  Used to merge the arenas filled by separate threads.
+//
+
+void MidiEventArena::adopt(MidiEventArena& other) {
+	if (&other == this) {
+		return;
+	}
+	if (m_slabs.empty()) {
+		m_slabs.swap(other.m_slabs);
+	} else {
+		// keep the slab with free space at the end of the list.
+		_Slab current = m_slabs.back();
+		m_slabs.pop_back();
+		m_slabs.insert(m_slabs.end(), other.m_slabs.begin(), other.m_slabs.end());
+		m_slabs.push_back(current);
+		other.m_slabs.clear();
+	}
+	m_nextSlabSize = std::max(m_nextSlabSize, other.m_nextSlabSize);
+}
+
+
+
+//////////////////////////////
+//
+// MidiEventArena::clear -- Destroy all events and release the slabs.
+//     Events are visited slab by slab in memory order, and each slab is
+//     returned to the system with a single deallocation.
+//
+
+void MidiEventArena::clear(void) {
+	for (int i=0; i<(int)m_slabs.size(); i++) {
+		_Slab& slab = m_slabs[i];
+		for (int j=0; j<slab.used; j++) {
+			slab.events[j].~MidiEvent();
+		}
+		::operator delete(slab.events);
+	}
+	m_slabs.clear();
+	m_nextSlabSize = 1024;
+}
+
+
+
+//////////////////////////////
+//
+// MidiEventArena::getEventCount -- Return the number of events that have
+//     been created in the arena.
+//
+
+int MidiEventArena::getEventCount(void) const {
+	int output = 0;
+	for (int i=0; i<(int)m_slabs.size(); i++) {
+		output += m_slabs[i].used;
+	}
+	return output;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+//////////////////////////////
+//
+// MidiEventArena::allocate -- Return uninitialized storage for one event.
+//
+
+MidiEvent* MidiEventArena::allocate(void) {
+	if (m_slabs.empty() || (m_slabs.back().used == m_slabs.back().capacity)) {
+		addSlab(m_nextSlabSize);
+		m_nextSlabSize = std::min(m_nextSlabSize * 2, 1 << 20);
+	}
+	_Slab& slab = m_slabs.back();
+	return slab.events + slab.used++;
+}
+
+
+
+//////////////////////////////
+//
+// MidiEventArena::addSlab -- Append a slab with storage for the given
+//     number of events.
+//
+
+void MidiEventArena::addSlab(int capacity) {
+	_Slab slab;
+	slab.events   = (MidiEvent*)::operator new(sizeof(MidiEvent) * capacity);
+	slab.capacity = capacity;
+	slab.used     = 0;
+	m_slabs.push_back(slab);
+}
+
+
+} // end namespace smf
+
+
+
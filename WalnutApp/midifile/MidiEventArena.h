@@ -0,0 +1,62 @@
+//
+// Creation Date: Sat Oct 17 2026
+// Filename:      midifile/include/MidiEventArena.h
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab
+//
+// Description:   Slab storage for the MidiEvents of a MidiFile.  Events
+//                are constructed in large contiguous blocks and are all
+//                released together when the arena is cleared.
+//
+
+#ifndef _MIDIEVENTARENA_H_INCLUDED
+#define _MIDIEVENTARENA_H_INCLUDED
+
+#include "MidiEvent.h"
+#include <vector>
+
+namespace smf {
+
+class MidiEventArena {
+	public:
+		                 MidiEventArena     (void);
+		                ~MidiEventArena     ();
+
+		                 MidiEventArena     (const MidiEventArena& other) = delete;
+		MidiEventArena&  operator=          (const MidiEventArena& other) = delete;
+
+		MidiEvent*       create             (void);
+		MidiEvent*       create             (const MidiEvent& event);
+		void             reserve            (int count);
+		void             adopt              (MidiEventArena& other);
+		void             clear              (void);
+		int              getEventCount      (void) const;
+
+	protected:
+		class _Slab {
+			public:
+				MidiEvent* events;
+				int        capacity;
+				int        used;
+		};
+
+		// m_slabs == Blocks of raw MidiEvent storage.  Only the last slab
+		// has free space, new events are constructed at its end.
+		std::vector<_Slab> m_slabs;
+
+		// m_nextSlabSize == Capacity of the next slab added when the current
+		// one is full.  Grows geometrically so that songs of any length need
+		// only a handful of slabs.
+		int m_nextSlabSize = 1024;
+
+	private:
+		MidiEvent*       allocate           (void);
+		void             addSlab            (int capacity);
+};
+
+} // end of namespace smf
+
+#endif /* _MIDIEVENTARENA_H_INCLUDED */
+
+
+
@@ -12,12 +12,14 @@
 
 
 #include "MidiEventList.h"
+#include "MidiEventArena.h"
 
 #include <vector>
 #include <algorithm>
 #include <iterator>
 #include <utility>
 
+#include <stdint.h>
 #include <stdlib.h>
 
 namespace smf {
@@ -56,6 +58,7 @@ MidiEventList::MidiEventList(const MidiEventList& other) {
 MidiEventList::MidiEventList(MidiEventList&& other) {
    list = std::move(other.list);
    other.list.clear();
+   m_arena = other.m_arena;
 }
 
 
@@ -137,10 +140,15 @@ const MidiEvent& MidiEventList::getEvent(int index) const {
 //////////////////////////////
 //
 // MidiEventList::clear -- De-allocate any MidiEvents present in the list
-//    and set the size of the list to 0.
+//    and set the size of the list to 0.  Events stored in an arena are
+//    left to the arena, which releases them all at once.
 //
 
 void MidiEventList::clear(void) {
+	if (m_arena) {
+		list.resize(0);
+		return;
+	}
 	for (int i=0; i<(int)list.size(); i++) {
 		if (list[i] != NULL) {
 			delete list[i];
@@ -213,7 +221,7 @@ int MidiEventList::getEventCount(void) const {
 //
 
 int MidiEventList::append(MidiEvent& event) {
-	MidiEvent* ptr = new MidiEvent(event);
+	MidiEvent* ptr = m_arena ? m_arena->create(event) : new MidiEvent(event);
 	list.push_back(ptr);
 	return (int)list.size()-1;
 }
@@ -247,7 +255,9 @@ void MidiEventList::removeEmpties(void) {
 	int count = 0;
 	for (int i=0; i<(int)list.size(); i++) {
 		if (list[i]->empty()) {
-			delete list[i];
+			if (!m_arena) {
+				delete list[i];
+			}
 			list[i] = NULL;
 			count++;
 		}
@@ -286,15 +296,21 @@ int MidiEventList::linkEventPairs(void) {
 
 int MidiEventList::linkNotePairs(void) {
 
-	// Note-on states:
-	// dimension 1: MIDI channel (0-15)
-	// dimension 2: MIDI key     (0-127)  (but 0 not used for note-ons)
-	// dimension 3: List of active note-ons or note-offs.
-	std::vector<std::vector<std::vector<MidiEvent*>>> noteons;
-	noteons.resize(16);
-	for (int i=0; i<(int)noteons.size(); i++) {
-		noteons[i].resize(128);
-	}
+	// Note-on states: a stack of active note-ons for each MIDI channel
+	// (0-15) and key (0-127), indexed by channel * 128 + key.  The
+	// stacks are linked lists through one pool of slots, so nothing is
+	// allocated per key:
+	// noteontop[i]   == slot of the last unmatched note-on, or -1.
+	// noteonpool[s]  == note-on stored in the slot.
+	// noteonnext[s]  == slot of the note-on below it on the stack (or
+	//                   the next unused slot when the slot is free).
+	int noteontop[16 * 128];
+	std::fill(noteontop, noteontop + 16 * 128, -1);
+	std::vector<MidiEvent*> noteonpool;
+	std::vector<int> noteonnext;
+	noteonpool.reserve(256);
+	noteonnext.reserve(256);
+	int freeslot = -1;
 
 	// Controller linking: The following General MIDI controller numbers are
 	// also monitored for linking within the track (but not between tracks).
@@ -318,48 +334,31 @@ int MidiEventList::linkNotePairs(void) {
 	// 5A  90   Undefined on/off                        0..63=off  64..127=on
 	// 7A 122   Local Keyboard On/Off                   0..63=off  64..127=on
 
-	// first keep track of whether the controller is an on/off switch:
-	std::vector<std::pair<int, int>> contmap;
-	contmap.resize(128);
-	std::pair<int, int> zero(0, 0);
-	std::fill(contmap.begin(), contmap.end(), zero);
-	contmap[64].first  = 1;   contmap[64].second = 0;
-	contmap[65].first  = 1;   contmap[65].second = 1;
-	contmap[66].first  = 1;   contmap[66].second = 2;
-	contmap[67].first  = 1;   contmap[67].second = 3;
-	contmap[68].first  = 1;   contmap[68].second = 4;
-	contmap[69].first  = 1;   contmap[69].second = 5;
-	contmap[80].first  = 1;   contmap[80].second = 6;
-	contmap[81].first  = 1;   contmap[81].second = 7;
-	contmap[82].first  = 1;   contmap[82].second = 8;
-	contmap[83].first  = 1;   contmap[83].second = 9;
-	contmap[84].first  = 1;   contmap[84].second = 10;
-	contmap[85].first  = 1;   contmap[85].second = 11;
-	contmap[86].first  = 1;   contmap[86].second = 12;
-	contmap[87].first  = 1;   contmap[87].second = 13;
-	contmap[88].first  = 1;   contmap[88].second = 14;
-	contmap[89].first  = 1;   contmap[89].second = 15;
-	contmap[90].first  = 1;   contmap[90].second = 16;
-	contmap[122].first = 1;   contmap[122].second = 17;
+	// map each on/off switch controller to its state index (-1 = not mapped):
+	int contmap[128];
+	std::fill(contmap, contmap + 128, -1);
+	contmap[64]  = 0;    contmap[65]  = 1;    contmap[66]  = 2;
+	contmap[67]  = 3;    contmap[68]  = 4;    contmap[69]  = 5;
+	contmap[80]  = 6;    contmap[81]  = 7;    contmap[82]  = 8;
+	contmap[83]  = 9;    contmap[84]  = 10;   contmap[85]  = 11;
+	contmap[86]  = 12;   contmap[87]  = 13;   contmap[88]  = 14;
+	contmap[89]  = 15;   contmap[90]  = 16;   contmap[122] = 17;
 
 	// dimensions:
 	// 1: mapped controller (0 to 17)
 	// 2: channel (0 to 15)
-	std::vector<std::vector<MidiEvent*>> contevents;
-	contevents.resize(18);
-	std::vector<std::vector<int>> oldstates;
-	oldstates.resize(18);
+	MidiEvent* contevents[18][16];
+	int oldstates[18][16];
 	for (int i=0; i<18; i++) {
-		contevents[i].resize(16);
-		std::fill(contevents[i].begin(), contevents[i].end(), nullptr);
-		oldstates[i].resize(16);
-		std::fill(oldstates[i].begin(), oldstates[i].end(), -1);
+		std::fill(contevents[i], contevents[i] + 16, nullptr);
+		std::fill(oldstates[i], oldstates[i] + 16, -1);
 	}
 
 	// Now iterate through the MidiEventList keeping track of note and
 	// select controller states and linking notes/controllers as needed.
 	int channel;
 	int key;
+	int slot;
 	int contnum;
 	int contval;
 	int conti;
@@ -367,29 +366,57 @@ int MidiEventList::linkNotePairs(void) {
 	int counter = 0;
 	MidiEvent* mev;
 	MidiEvent* noteon;
-	for (int i=0; i<getSize(); i++) {
-		mev = &getEvent(i);
-		mev->unlinkEvent();
-		if (mev->isNoteOn()) {
+	int command;
+	int count = getSize();
+	for (int i=0; i<count; i++) {
+		mev = list[i];
+		if (mev->m_eventlink != NULL) {
+			mev->unlinkEvent();
+		}
+		if (mev->size() != 3) {
+			continue;
+		}
+		command = (*mev)[0] & 0xf0;
+		if ((command == 0x90) && ((*mev)[2] != 0)) {
 			// store the note-on to pair later with a note-off message.
-			key = mev->getKeyNumber();
-			channel = mev->getChannel();
-			noteons[channel][key].push_back(mev);
-		} else if (mev->isNoteOff()) {
-			key = mev->getKeyNumber();
-			channel = mev->getChannel();
-			if (noteons[channel][key].size() > 0) {
-				noteon = noteons[channel][key].back();
-				noteons[channel][key].pop_back();
-				noteon->linkEvent(mev);
+			key = (*mev)[1];
+			channel = (*mev)[0] & 0x0f;
+			if (key > 127) {
+				continue;
+			}
+			if (freeslot >= 0) {
+				slot = freeslot;
+				freeslot = noteonnext[slot];
+				noteonpool[slot] = mev;
+				noteonnext[slot] = noteontop[channel * 128 + key];
+			} else {
+				slot = (int)noteonpool.size();
+				noteonpool.push_back(mev);
+				noteonnext.push_back(noteontop[channel * 128 + key]);
+			}
+			noteontop[channel * 128 + key] = slot;
+		} else if ((command == 0x80) || (command == 0x90)) {
+			// note-off (or note-on with zero velocity):
+			key = (*mev)[1];
+			channel = (*mev)[0] & 0x0f;
+			slot = key > 127 ? -1 : noteontop[channel * 128 + key];
+			if (slot >= 0) {
+				noteon = noteonpool[slot];
+				noteontop[channel * 128 + key] = noteonnext[slot];
+				noteonnext[slot] = freeslot;
+				freeslot = slot;
+				// Both events were unlinked when they were reached, and a
+				// note-on on the stack is not linked to anything else.
+				noteon->m_eventlink = mev;
+				mev->m_eventlink = noteon;
 				counter++;
 			}
-		} else if (mev->isController()) {
-			contnum = mev->getP1();
-			if (contmap[contnum].first) {
-				conti     = contmap[contnum].second;
-				channel   = mev->getChannel();
-				contval   = mev->getP2();
+		} else if (command == 0xb0) {
+			contnum = (*mev)[1];
+			conti   = contnum < 128 ? contmap[contnum] : -1;
+			if (conti >= 0) {
+				channel   = (*mev)[0] & 0x0f;
+				contval   = (*mev)[2];
 				contstate = contval < 64 ? 0 : 1;
 				if ((oldstates[conti][channel] == -1) && contstate) {
 					// a newly initialized onstate was detected, so store for
@@ -503,6 +530,20 @@ int MidiEventList::push_back_no_copy(MidiEvent* event) {
 
 
 
+//////////////////////////////
+//
+// MidiEventList::newEvent -- Allocate an empty MidiEvent from the same
+//     storage as the other events in the list (the arena if the list
+//     has one, otherwise the heap).  The event is not added to the list;
+//     use push_back_no_copy() to store it.
+//
+
+MidiEvent* MidiEventList::newEvent(void) {
+	return m_arena ? m_arena->create() : new MidiEvent;
+}
+
+
+
 //////////////////////////////
 //
 // MidiEventList::operator=(MidiEventList) -- Assignment.
@@ -510,6 +551,7 @@ int MidiEventList::push_back_no_copy(MidiEvent* event) {
 
 MidiEventList& MidiEventList::operator=(MidiEventList& other) {
 	list.swap(other.list);
+	std::swap(m_arena, other.m_arena);
 	return *this;
 }
 
@@ -528,7 +570,81 @@ MidiEventList& MidiEventList::operator=(MidiEventList& other) {
 //
 
 void MidiEventList::sort(void) {
-	qsort(data(), getEventCount(), sizeof(MidiEvent*), eventcompare);
+	int count = getEventCount();
+	if ((count < 2) || isSorted()) {
+		return;
+	}
+	if (count < 64) {
+		std::stable_sort(list.begin(), list.end(), eventless);
+		return;
+	}
+
+	// Stable LSD radix sort on the tick, one byte per pass, skipping
+	// the bytes which are the same in all ticks of the list.
+	int mintick = list[0]->tick;
+	int maxtick = list[0]->tick;
+	for (int i=1; i<count; i++) {
+		mintick = std::min(mintick, list[i]->tick);
+		maxtick = std::max(maxtick, list[i]->tick);
+	}
+	uint32_t range = (uint32_t)maxtick - (uint32_t)mintick;
+
+	std::vector<uint32_t>   key(count);
+	std::vector<uint32_t>   keytemp(count);
+	std::vector<MidiEvent*> listtemp(count);
+	for (int i=0; i<count; i++) {
+		key[i] = (uint32_t)list[i]->tick - (uint32_t)mintick;
+	}
+
+	for (int shift=0; (shift < 32) && ((range >> shift) != 0); shift += 8) {
+		int bucket[257] = {0};
+		for (int i=0; i<count; i++) {
+			bucket[((key[i] >> shift) & 0xff) + 1]++;
+		}
+		if (bucket[((key[0] >> shift) & 0xff) + 1] == count) {
+			continue;
+		}
+		for (int i=0; i<256; i++) {
+			bucket[i+1] += bucket[i];
+		}
+		for (int i=0; i<count; i++) {
+			int target = bucket[(key[i] >> shift) & 0xff]++;
+			keytemp[target]  = key[i];
+			listtemp[target] = list[i];
+		}
+		key.swap(keytemp);
+		list.swap(listtemp);
+	}
+
+	// Order the events within each tick by the rest of eventcompare():
+	int start = 0;
+	while (start < count) {
+		int end = start + 1;
+		while ((end < count) && (key[end] == key[start])) {
+			end++;
+		}
+		if (end - start > 1) {
+			std::stable_sort(list.begin() + start, list.begin() + end, eventless);
+		}
+		start = end;
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MidiEventList::isSorted -- Returns true if the events are already
+//    in eventcompare() order.
+//
+
+bool MidiEventList::isSorted(void) const {
+	for (int i=1; i<(int)list.size(); i++) {
+		if (eventcompare(&list[i], &list[i-1]) < 0) {
+			return false;
+		}
+	}
+	return true;
 }
 
 
@@ -538,6 +654,18 @@ void MidiEventList::sort(void) {
 // external functions
 //
 
+//////////////////////////////
+//
+// eventless -- Strict ordering version of eventcompare(), for use with
+//    the standard library sorting functions.
+//
+
+bool eventless(const MidiEvent* a, const MidiEvent* b) {
+	return eventcompare(&a, &b) < 0;
+}
+
+
+
 //////////////////////////////
 //
 // eventcompare -- Event comparison function for sorting tracks.
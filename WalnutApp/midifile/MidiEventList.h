@@ -18,6 +18,8 @@
 
 namespace smf {
 
+class MidiEventArena;
+
 class MidiEventList {
 	public:
 		                 MidiEventList      (void);
@@ -55,6 +57,7 @@ class MidiEventList {
 		// careful when using these, intended for internal use in MidiFile class:
 		void             detach             (void);
 		int              push_back_no_copy  (MidiEvent* event);
+		MidiEvent*       newEvent           (void);
 
 		// access to the list of MidiEvents for sorting with an external function:
 		MidiEvent**      data               (void);
@@ -62,15 +65,22 @@ class MidiEventList {
 	protected:
 		std::vector<MidiEvent*> list;
 
+		// m_arena == Storage owning the events of the list.  NULL if the
+		// events are individually allocated on the heap (and owned by the
+		// list).  Set by MidiFile when it uses an event arena.
+		MidiEventArena* m_arena = NULL;
+
 	private:
 		void             sort                (void);
+		bool             isSorted            (void) const;
 
 	// MidiFile class calls sort()
 	friend class MidiFile;
 };
 
 
-int eventcompare(const void* a, const void* b);
+int  eventcompare(const void* a, const void* b);
+bool eventless   (const MidiEvent* a, const MidiEvent* b);
 
 } // end of namespace smf
 
@@ -14,15 +14,18 @@
 
 #include "MidiFile.h"
 #include "Binasc.h"
+#include "MappedFile.h"
 
 #include <string>
 #include <vector>
 #include <iostream>
 #include <iomanip>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <thread>
 
 
 namespace smf {
@@ -69,6 +72,9 @@ const char* MidiFile::GMinstrument[128] = {
 
 
 
+
+
+
 //////////////////////////////
 //
 // MidiFile::MidiFile -- Constuctor.
@@ -126,6 +132,10 @@ MidiFile::~MidiFile() {
 		m_events[0] = NULL;
 	}
 	m_events.resize(0);
+	if (m_arena != NULL) {
+		delete m_arena;
+		m_arena = NULL;
+	}
 	m_rwstatus = false;
 	m_timemap.clear();
 	m_timemapvalid = 0;
@@ -146,7 +156,16 @@ MidiFile& MidiFile::operator=(const MidiFile& other) {
 	auto it = other.m_events.begin();
 	std::generate_n(std::back_inserter(m_events), other.m_events.size(),
 		[&]()->MidiEventList* {
-			return new MidiEventList(**it++);
+			const MidiEventList& source = **it++;
+			if (m_arena == NULL) {
+				return new MidiEventList(source);
+			}
+			MidiEventList* copy = newEventList();
+			copy->reserve(source.size());
+			for (int i=0; i<source.size(); i++) {
+				copy->push_back_no_copy(m_arena->create(source[i]));
+			}
+			return copy;
 		}
 	);
 	m_ticksPerQuarterNote = other.m_ticksPerQuarterNote;
@@ -155,7 +174,9 @@ MidiFile& MidiFile::operator=(const MidiFile& other) {
 	m_readFileName        = other.m_readFileName;
 	m_timemapvalid        = other.m_timemapvalid;
 	m_timemap             = other.m_timemap;
-	m_rwstatus            = other.m_rwstatus;
+	m_rwstatus            = other.m_rwstatus.load();
+	m_readThreadCount     = other.m_readThreadCount;
+	m_useArena            = other.m_useArena;
 	if (other.m_linkedEventsQ) {
 		linkEventPairs();
 	}
@@ -168,6 +189,10 @@ MidiFile& MidiFile::operator=(MidiFile&& other) {
 	m_linkedEventsQ = other.m_linkedEventsQ;
 	other.m_linkedEventsQ = false;
 	other.m_events.clear();
+	// the event storage moves along with the events.
+	delete m_arena;
+	m_arena = other.m_arena;
+	other.m_arena = NULL;
 	other.m_events.emplace_back(new MidiEventList);
 	m_ticksPerQuarterNote = other.m_ticksPerQuarterNote;
 	m_theTrackState       = other.m_theTrackState;
@@ -175,7 +200,9 @@ MidiFile& MidiFile::operator=(MidiFile&& other) {
 	m_readFileName        = other.m_readFileName;
 	m_timemapvalid        = other.m_timemapvalid;
 	m_timemap             = other.m_timemap;
-	m_rwstatus            = other.m_rwstatus;
+	m_rwstatus            = other.m_rwstatus.load();
+	m_readThreadCount     = other.m_readThreadCount;
+	m_useArena            = other.m_useArena;
 	return *this;
 }
 
@@ -197,15 +224,19 @@ bool MidiFile::read(const std::string& filename) {
 	setFilename(filename);
 	m_rwstatus = true;
 
-	std::fstream input;
-	input.open(filename.c_str(), std::ios::binary | std::ios::in);
-
-	if (!input.is_open()) {
+	MappedFile mapped(filename);
+	if (!mapped.isOpen()) {
 		m_rwstatus = false;
 		return m_rwstatus;
 	}
 
-	m_rwstatus = read(input);
+	if ((mapped.size() > 0) && (mapped.data()[0] == 'M')) {
+		m_rwstatus = readSmf(mapped.data(), mapped.size());
+	} else {
+		// binasc content: decode it through the istream version of read().
+		std::stringstream input(std::string((const char*)mapped.data(), mapped.size()));
+		m_rwstatus = read(input);
+	}
 	return m_rwstatus;
 }
 
@@ -269,20 +300,7 @@ bool MidiFile::readBase64(std::istream& instream) {
 //
 
 bool MidiFile::readSmf(const std::string& filename) {
-	m_timemapvalid = 0;
-	setFilename(filename);
-	m_rwstatus = true;
-
-	std::fstream input;
-	input.open(filename.c_str(), std::ios::binary | std::ios::in);
-
-	if (!input.is_open()) {
-		m_rwstatus = false;
-		return m_rwstatus;
-	}
-
-	m_rwstatus = readSmf(input);
-	return m_rwstatus;
+	return readMapped(filename);
 }
 
 
@@ -290,71 +308,41 @@ bool MidiFile::readSmf(const std::string& filename) {
 //////////////////////////////
 //
 // MidiFile::readSmf -- Parse a Standard MIDI File and store its contents in the object.
+//     The istream version slurps the remaining stream contents into memory
+//     and decodes them with the byte-buffer version below.
 //
 
 bool MidiFile::readSmf(std::istream& input) {
+	std::vector<uchar> data((std::istreambuf_iterator<char>(input)),
+			std::istreambuf_iterator<char>());
+	return readSmf(data.data(), data.size());
+}
+
+//
+// Byte-buffer version of readSmf().  The data is decoded in place, so it
+// can point directly into a memory-mapped file (see readMapped()).
+//
+
+bool MidiFile::readSmf(const uchar* data, size_t size) {
 	m_rwstatus = true;
 
 	std::string filename = getFilename();
 
-	int    character;
-	// uchar  buffer[123456] = {0};
+	const uchar* ptr = data;
+	const uchar* end = data + size;
+
 	ulong  longdata;
 	ushort shortdata;
 
 	// Read the MIDI header (4 bytes of ID, 4 byte data size,
 	// anticipated 6 bytes of data.
 
-	character = input.get();
-	if (character == EOF) {
-		std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
-		std::cerr << "Expecting 'M' at first byte, but found nothing." << std::endl;
-		m_rwstatus = false; return m_rwstatus;
-	} else if (character != 'M') {
-		std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
-		std::cerr << "Expecting 'M' at first byte but got '"
-		     << (char)character << "'" << std::endl;
-		m_rwstatus = false; return m_rwstatus;
-	}
-
-	character = input.get();
-	if (character == EOF) {
-		std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
-		std::cerr << "Expecting 'T' at second byte, but found nothing." << std::endl;
-		m_rwstatus = false; return m_rwstatus;
-	} else if (character != 'T') {
-		std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
-		std::cerr << "Expecting 'T' at second byte but got '"
-		     << (char)character << "'" << std::endl;
-		m_rwstatus = false; return m_rwstatus;
-	}
-
-	character = input.get();
-	if (character == EOF) {
-		std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
-		std::cerr << "Expecting 'h' at third byte, but found nothing." << std::endl;
-		m_rwstatus = false; return m_rwstatus;
-	} else if (character != 'h') {
-		std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
-		std::cerr << "Expecting 'h' at third byte but got '"
-		     << (char)character << "'" << std::endl;
-		m_rwstatus = false; return m_rwstatus;
-	}
-
-	character = input.get();
-	if (character == EOF) {
-		std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
-		std::cerr << "Expecting 'd' at fourth byte, but found nothing." << std::endl;
-		m_rwstatus = false; return m_rwstatus;
-	} else if (character != 'd') {
-		std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
-		std::cerr << "Expecting 'd' at fourth byte but got '"
-		     << (char)character << "'" << std::endl;
+	if (!checkChunkId(ptr, end, "MThd", "")) {
 		m_rwstatus = false; return m_rwstatus;
 	}
 
 	// read header size (allow larger header size?)
-	longdata = readLittleEndian4Bytes(input);
+	longdata = readBigEndian4Bytes(ptr, end);
 	if (longdata != 6) {
 		std::cerr << "File " << filename
 		     << " is not a MIDI 1.0 Standard MIDI file." << std::endl;
@@ -364,7 +352,7 @@ bool MidiFile::readSmf(std::istream& input) {
 
 	// Header parameter #1: format type
 	int type;
-	shortdata = readLittleEndian2Bytes(input);
+	shortdata = readBigEndian2Bytes(ptr, end);
 	switch (shortdata) {
 		case 0:
 			type = 0;
@@ -383,7 +371,7 @@ bool MidiFile::readSmf(std::istream& input) {
 
 	// Header parameter #2: track count
 	int tracks;
-	shortdata = readLittleEndian2Bytes(input);
+	shortdata = readBigEndian2Bytes(ptr, end);
 	if (type == 0 && shortdata != 1) {
 		std::cerr << "Error: Type 0 MIDI file can only contain one track" << std::endl;
 		std::cerr << "Instead track count is: " << shortdata << std::endl;
@@ -397,13 +385,11 @@ bool MidiFile::readSmf(std::istream& input) {
 	}
 	m_events.resize(tracks);
 	for (int z=0; z<tracks; z++) {
-		m_events[z] = new MidiEventList;
-		m_events[z]->reserve(10000);   // Initialize with 10,000 event storage.
-		m_events[z]->clear();
+		m_events[z] = newEventList();
 	}
 
 	// Header parameter #3: Ticks per quarter note
-	shortdata = readLittleEndian2Bytes(input);
+	shortdata = readBigEndian2Bytes(ptr, end);
 	if (shortdata >= 0x8000) {
 		int framespersecond = 255 - ((shortdata >> 8) & 0x00ff) + 1;
 		int subframes       = shortdata & 0x00ff;
@@ -417,10 +403,6 @@ bool MidiFile::readSmf(std::istream& input) {
 					std::cerr << "Using non-standard FPS: " << framespersecond << std::endl;
 		}
 		m_ticksPerQuarterNote = framespersecond * subframes;
-
-		// std::cerr << "SMPTE ticks: " << m_ticksPerQuarterNote << " ticks/sec" << std::endl;
-		// std::cerr << "SMPTE frames per second: " << framespersecond << std::endl;
-		// std::cerr << "SMPTE subframes per frame: " << subframes << std::endl;
 	}  else {
 		m_ticksPerQuarterNote = shortdata;
 	}
@@ -431,67 +413,31 @@ bool MidiFile::readSmf(std::istream& input) {
 	// now read individual tracks:
 	//
 
-	uchar runningCommand;
-	MidiEvent event;
-	std::vector<uchar> bytes;
-	int xstatus;
-
-	for (int i=0; i<tracks; i++) {
-		runningCommand = 0;
-
-		// std::cout << "\nReading Track: " << i + 1 << flush;
-
-		// read track header...
-
-		character = input.get();
-		if (character == EOF) {
-			std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
-			std::cerr << "Expecting 'M' at first byte in track, but found nothing."
-			     << std::endl;
-			m_rwstatus = false; return m_rwstatus;
-		} else if (character != 'M') {
-			std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
-			std::cerr << "Expecting 'M' at first byte in track but got '"
-			     << (char)character << "'" << std::endl;
-			m_rwstatus = false; return m_rwstatus;
-		}
-
-		character = input.get();
-		if (character == EOF) {
-			std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
-			std::cerr << "Expecting 'T' at second byte in track, but found nothing."
-			     << std::endl;
-			m_rwstatus = false; return m_rwstatus;
-		} else if (character != 'T') {
-			std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
-			std::cerr << "Expecting 'T' at second byte in track but got '"
-			     << (char)character << "'" << std::endl;
-			m_rwstatus = false; return m_rwstatus;
+	// Each MTrk chunk header carries its byte length, so when the chunk
+	// table is consistent the tracks can be decoded independently.  The
+	// serial reader below is used otherwise, and whenever a track fails
+	// to decode from its chunk, since it tolerates wrong chunk sizes by
+	// relying on the end-of-track messages.
+	int threads = m_readThreadCount;
+	if (threads <= 0) {
+		threads = (int)std::thread::hardware_concurrency();
+	}
+	threads = std::min(threads, tracks);
+	if (threads > 1) {
+		std::vector<std::pair<const uchar*, const uchar*>> chunks;
+		if (scanTrackChunks(ptr, end, tracks, chunks) &&
+				extractTracksParallel(chunks, threads)) {
+			tracks = 0;    // all tracks decoded; skip the serial reader.
 		}
+	}
 
-		character = input.get();
-		if (character == EOF) {
-			std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
-			std::cerr << "Expecting 'r' at third byte in track, but found nothing."
-			     << std::endl;
-			m_rwstatus = false; return m_rwstatus;
-		} else if (character != 'r') {
-			std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
-			std::cerr << "Expecting 'r' at third byte in track but got '"
-			     << (char)character << "'" << std::endl;
-			m_rwstatus = false; return m_rwstatus;
-		}
+	if (m_arena && (tracks > 0)) {
+		// roughly three bytes per event with running status.
+		m_arena->reserve((int)((end - ptr) / 3) + 16);
+	}
 
-		character = input.get();
-		if (character == EOF) {
-			std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
-			std::cerr << "Expecting 'k' at fourth byte in track, but found nothing."
-			     << std::endl;
-			m_rwstatus = false; return m_rwstatus;
-		} else if (character != 'k') {
-			std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
-			std::cerr << "Expecting 'k' at fourth byte in track but got '"
-			     << (char)character << "'" << std::endl;
+	for (int i=0; i<tracks; i++) {
+		if (!checkChunkId(ptr, end, "MTrk", " in track")) {
 			m_rwstatus = false; return m_rwstatus;
 		}
 
@@ -499,39 +445,10 @@ bool MidiFile::readSmf(std::istream& input) {
 		// not really necessary since the track MUST end with an
 		// end of track meta event, and many MIDI files found in the wild
 		// do not correctly give the track size.
-		longdata = readLittleEndian4Bytes(input);
-
-		// Set the size of the track allocation so that it might
-		// approximately fit the data.
-		m_events[i]->reserve((int)longdata/2);
-		m_events[i]->clear();
-
-		// Read MIDI events in the track, which are pairs of VLV values
-		// and then the bytes for the MIDI message.  Running status messags
-		// will be filled in with their implicit command byte.
-		// The timestamps are converted from delta ticks to absolute ticks,
-		// with the absticks variable accumulating the VLV tick values.
-		int absticks = 0;
-		while (!input.eof()) {
-			longdata = readVLValue(input);
-			absticks += longdata;
-			xstatus = extractMidiData(input, bytes, runningCommand);
-			if (xstatus == 0) {
-				m_rwstatus = false; return m_rwstatus;
-			}
-			event.setMessage(bytes);
-			event.tick = absticks;
-			event.track = i;
-
-			if (bytes[0] == 0xff && bytes[1] == 0x2f) {
-				// end-of-track message
-				// comment out the following line if you don't want to see the
-				// end of track message (which is always required, and will added
-				// automatically when a MIDI is written, so it is not necessary.
-				m_events[i]->push_back(event);
-				break;
-			}
-			m_events[i]->push_back(event);
+		longdata = readBigEndian4Bytes(ptr, end);
+
+		if (!extractTrackData(ptr, end, i, (int)longdata, m_arena)) {
+			m_rwstatus = false; return m_rwstatus;
 		}
 	}
 
@@ -547,6 +464,30 @@ bool MidiFile::readSmf(std::istream& input) {
 
 
 
+//////////////////////////////
+//
+// MidiFile::readMapped -- Memory-map a Standard MIDI File and decode it
+//      directly from the mapped bytes.  This is the fast path used by
+//      read(const std::string&) and readSmf(const std::string&).
+//
+
+bool MidiFile::readMapped(const std::string& filename) {
+	m_timemapvalid = 0;
+	setFilename(filename);
+	m_rwstatus = true;
+
+	MappedFile mapped(filename);
+	if (!mapped.isOpen()) {
+		m_rwstatus = false;
+		return m_rwstatus;
+	}
+
+	m_rwstatus = readSmf(mapped.data(), mapped.size());
+	return m_rwstatus;
+}
+
+
+
 //////////////////////////////
 //
 // MidiFile::write -- write a standard MIDI file to a file or an output
@@ -885,6 +826,33 @@ bool MidiFile::status(void) const {
 }
 
 
+
+//////////////////////////////
+//
+// MidiFile::setReadThreadCount -- Set the number of threads used to
+//    decode track chunks when reading a file and to link note pairs.
+//    1 (the default) handles the tracks serially; 0 uses one thread per
+//    hardware core.
+//
+
+void MidiFile::setReadThreadCount(int count) {
+	m_readThreadCount = count < 0 ? 1 : count;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFile::getReadThreadCount -- Return the number of threads used to
+//    decode track chunks when reading a file (0 = one per hardware core).
+//
+
+int MidiFile::getReadThreadCount(void) const {
+	return m_readThreadCount;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////
 //
 // track-related functions --
@@ -1026,7 +994,7 @@ void MidiFile::joinTracks(void) {
 	}
 
 	MidiEventList* joinedTrack;
-	joinedTrack = new MidiEventList;
+	joinedTrack = newEventList();
 
 	int messagesum = 0;
 	int length = getNumTracks();
@@ -1040,9 +1008,75 @@ void MidiFile::joinTracks(void) {
 	if (oldTimeState == TIME_STATE_DELTA) {
 		makeAbsoluteTicks();
 	}
+
+	// Each track is normally already in order, so merge the tracks
+	// rather than sorting the joined list.  The heap holds the tracks
+	// which still have events, ordered by eventcompare() on their next
+	// event and then by track index, so the merge is stable.  The tick
+	// and sequence number of the next event are cached to avoid most
+	// of the calls to eventcompare().
+	std::vector<MidiEvent**> cursor(length);
+	std::vector<MidiEvent**> cursorEnd(length);
+	std::vector<int> cursorTick(length);
+	std::vector<int> cursorSeq(length);
+	auto before = [&](int a, int b) {
+		if (cursorTick[a] != cursorTick[b]) {
+			return cursorTick[a] < cursorTick[b];
+		}
+		if ((cursorSeq[a] != 0) && (cursorSeq[b] != 0) && (cursorSeq[a] != cursorSeq[b])) {
+			return cursorSeq[a] < cursorSeq[b];
+		}
+		int order = eventcompare(cursor[a], cursor[b]);
+		return order != 0 ? order < 0 : a < b;
+	};
+	auto siftDown = [&](std::vector<int>& heap, int index) {
+		int count = (int)heap.size();
+		int value = heap[index];
+		while (true) {
+			int child = 2 * index + 1;
+			if (child >= count) {
+				break;
+			}
+			if ((child + 1 < count) && before(heap[child+1], heap[child])) {
+				child++;
+			}
+			if (!before(heap[child], value)) {
+				break;
+			}
+			heap[index] = heap[child];
+			index = child;
+		}
+		heap[index] = value;
+	};
+
+	std::vector<int> heap;
+	heap.reserve(length);
 	for (i=0; i<length; i++) {
-		for (j=0; j<(int)m_events[i]->size(); j++) {
-			joinedTrack->push_back_no_copy(&(*m_events[i])[j]);
+		MidiEventList& track = *m_events[i];
+		track.sort();
+		cursor[i]    = track.data();
+		cursorEnd[i] = track.data() + track.size();
+		if (cursor[i] != cursorEnd[i]) {
+			cursorTick[i] = (*cursor[i])->tick;
+			cursorSeq[i]  = (*cursor[i])->seq;
+			heap.push_back(i);
+		}
+	}
+	for (i=(int)heap.size()/2-1; i>=0; i--) {
+		siftDown(heap, i);
+	}
+	while (!heap.empty()) {
+		j = heap[0];
+		joinedTrack->push_back_no_copy(*cursor[j]++);
+		if (cursor[j] != cursorEnd[j]) {
+			cursorTick[j] = (*cursor[j])->tick;
+			cursorSeq[j]  = (*cursor[j])->seq;
+		} else {
+			heap[0] = heap.back();
+			heap.pop_back();
+		}
+		if (!heap.empty()) {
+			siftDown(heap, 0);
 		}
 	}
 
@@ -1051,7 +1085,6 @@ void MidiFile::joinTracks(void) {
 	delete m_events[0];
 	m_events.resize(0);
 	m_events.push_back(joinedTrack);
-	sortTracks();
 	if (oldTimeState == TIME_STATE_DELTA) {
 		makeDeltaTicks();
 	}
@@ -1094,7 +1127,7 @@ void MidiFile::splitTracks(void) {
 	m_events[0] = NULL;
 	m_events.resize(trackCount);
 	for (i=0; i<trackCount; i++) {
-		m_events[i] = new MidiEventList;
+		m_events[i] = newEventList();
 	}
 
 	for (i=0; i<length; i++) {
@@ -1158,7 +1191,7 @@ void MidiFile::splitTracksByChannel(void) {
 	m_events[0] = NULL;
 	m_events.resize(trackCount);
 	for (i=0; i<trackCount; i++) {
-		m_events[i] = new MidiEventList;
+		m_events[i] = newEventList();
 	}
 
 	for (i=0; i<length; i++) {
@@ -1503,25 +1536,12 @@ double MidiFile::getTimeInSeconds(int tickvalue) {
 			return -1.0;    // something went wrong
 		}
 	}
-
-	_TickTime key;
-	key.tick    = tickvalue;
-	key.seconds = -1;
-
-	void* ptr = bsearch(&key, m_timemap.data(), m_timemap.size(),
-			sizeof(_TickTime), ticksearch);
-
-	if (ptr == NULL) {
-		// The specific tick value was not found, so do a linear
-		// search for the two tick values which occur before and
-		// after the tick value, and do a linear interpolation of
-		// the time in seconds values to figure out the final
-		// time in seconds.
-		// Since the code is not yet written, kill the program at this point:
-		return linearSecondInterpolationAtTick(tickvalue);
-	} else {
-		return ((_TickTime*)ptr)->seconds;
+	if (tickvalue < 0) {
+		return -1.0;
 	}
+
+	const _TickTime& segment = m_timemap[findTempoSegment(tickvalue)];
+	return segment.seconds + (tickvalue - segment.tick) * segment.secondsPerTick;
 }
 
 
@@ -1529,8 +1549,8 @@ double MidiFile::getTimeInSeconds(int tickvalue) {
 //////////////////////////////
 //
 // MidiFile::getAbsoluteTickTime -- return the tick value represented
-//    by the input time in seconds.  If there is not tick entry at
-//    the given time in seconds, then interpolate between two values.
+//    by the input time in seconds.  Times which fall between two ticks
+//    return a fractional tick value.
 //
 
 double MidiFile::getAbsoluteTickTime(double starttime) {
@@ -1540,24 +1560,15 @@ double MidiFile::getAbsoluteTickTime(double starttime) {
 			return -1.0;    // something went wrong
 		}
 	}
-
-	_TickTime key;
-	key.tick    = -1;
-	key.seconds = starttime;
-
-	void* ptr = bsearch(&key, m_timemap.data(), m_timemap.size(),
-			sizeof(_TickTime), secondsearch);
-
-	if (ptr == NULL) {
-		// The specific seconds value was not found, so do a linear
-		// search for the two time values which occur before and
-		// after the given time value, and do a linear interpolation of
-		// the time in tick values to figure out the final time in ticks.
-		return linearTickInterpolationAtSecond(starttime);
-	} else {
-		return ((_TickTime*)ptr)->tick;
+	if (starttime < 0.0) {
+		return -1.0;
 	}
 
+	const _TickTime& segment = m_timemap[findTempoSegmentAtSecond(starttime)];
+	if (segment.secondsPerTick <= 0.0) {
+		return segment.tick;
+	}
+	return segment.tick + (starttime - segment.seconds) / segment.secondsPerTick;
 }
 
 
@@ -1571,17 +1582,63 @@ double MidiFile::getAbsoluteTickTime(double starttime) {
 //
 // MidiFile::linkNotePairs --  Link note-ons to note-offs separately
 //     for each track.  Returns the total number of note message pairs
-//     that were linked.
+//     that were linked.  The tracks are linked on the same number of
+//     threads as are used for reading (see setReadThreadCount()).
 //
 
 int MidiFile::linkNotePairs(void) {
 	int i;
 	int sum = 0;
-	for (i=0; i<getTrackCount(); i++) {
-		if (m_events[i] == NULL) {
-			continue;
+	int tracks = getTrackCount();
+	int threads = m_readThreadCount;
+	if (threads <= 0) {
+		threads = (int)std::thread::hardware_concurrency();
+	}
+	threads = std::min(threads, tracks);
+
+	if (threads <= 1) {
+		for (i=0; i<tracks; i++) {
+			if (m_events[i] == NULL) {
+				continue;
+			}
+			sum += m_events[i]->linkNotePairs();
 		}
-		sum += m_events[i]->linkNotePairs();
+		m_linkedEventsQ = true;
+		return sum;
+	}
+
+	// Existing links may cross tracks (if they were made while the
+	// tracks were joined), so remove them before the tracks are
+	// handled independently.
+	for (i=0; i<tracks; i++) {
+		if (m_events[i] != NULL) {
+			m_events[i]->clearLinks();
+		}
+	}
+
+	std::atomic<int> next(0);
+	std::vector<int> counts(tracks, 0);
+	auto worker = [&]() {
+		int track;
+		while ((track = next++) < tracks) {
+			if (m_events[track] != NULL) {
+				counts[track] = m_events[track]->linkNotePairs();
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+	for (int t=1; t<threads; t++) {
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : pool) {
+		thread.join();
+	}
+
+	for (i=0; i<tracks; i++) {
+		sum += counts[i];
 	}
 	m_linkedEventsQ = true;
 	return sum;
@@ -1638,7 +1695,7 @@ const char* MidiFile::getFilename(void) const {
 MidiEvent* MidiFile::addEvent(int aTrack, int aTick,
 		std::vector<uchar>& midiData) {
 	m_timemapvalid = 0;
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->tick = aTick;
 	me->track = aTrack;
 	me->setMessage(midiData);
@@ -1729,7 +1786,7 @@ MidiEvent* MidiFile::addMetaEvent(int aTrack, int aTick, int aType,
 //
 
 MidiEvent* MidiFile::addText(int aTrack, int aTick, const std::string& text) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeText(text);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1744,7 +1801,7 @@ MidiEvent* MidiFile::addText(int aTrack, int aTick, const std::string& text) {
 //
 
 MidiEvent* MidiFile::addCopyright(int aTrack, int aTick, const std::string& text) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeCopyright(text);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1759,7 +1816,7 @@ MidiEvent* MidiFile::addCopyright(int aTrack, int aTick, const std::string& text
 //
 
 MidiEvent* MidiFile::addTrackName(int aTrack, int aTick, const std::string& name) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeTrackName(name);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1775,7 +1832,7 @@ MidiEvent* MidiFile::addTrackName(int aTrack, int aTick, const std::string& name
 
 MidiEvent* MidiFile::addInstrumentName(int aTrack, int aTick,
 		const std::string& name) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeInstrumentName(name);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1790,7 +1847,7 @@ MidiEvent* MidiFile::addInstrumentName(int aTrack, int aTick,
 //
 
 MidiEvent* MidiFile::addLyric(int aTrack, int aTick, const std::string& text) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeLyric(text);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1805,7 +1862,7 @@ MidiEvent* MidiFile::addLyric(int aTrack, int aTick, const std::string& text) {
 //
 
 MidiEvent* MidiFile::addMarker(int aTrack, int aTick, const std::string& text) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeMarker(text);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1820,7 +1877,7 @@ MidiEvent* MidiFile::addMarker(int aTrack, int aTick, const std::string& text) {
 //
 
 MidiEvent* MidiFile::addCue(int aTrack, int aTick, const std::string& text) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeCue(text);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1835,7 +1892,7 @@ MidiEvent* MidiFile::addCue(int aTrack, int aTick, const std::string& text) {
 //
 
 MidiEvent* MidiFile::addTempo(int aTrack, int aTick, double aTempo) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeTempo(aTempo);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1869,7 +1926,7 @@ MidiEvent* MidiFile::addTempo(int aTrack, int aTick, double aTempo) {
 
 MidiEvent* MidiFile::addTimeSignature(int aTrack, int aTick, int top, int bottom,
 		int clocksPerClick, int num32ndsPerQuarter) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeTimeSignature(top, bottom, clocksPerClick, num32ndsPerQuarter);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1961,7 +2018,7 @@ int MidiFile::makeVLV(uchar *buffer, int number) {
 //
 
 MidiEvent* MidiFile::addNoteOn(int aTrack, int aTick, int aChannel, int key, int vel) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeNoteOn(aChannel, key, vel);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1977,7 +2034,7 @@ MidiEvent* MidiFile::addNoteOn(int aTrack, int aTick, int aChannel, int key, int
 
 MidiEvent* MidiFile::addNoteOff(int aTrack, int aTick, int aChannel, int key,
 		int vel) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeNoteOff(aChannel, key, vel);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -1993,7 +2050,7 @@ MidiEvent* MidiFile::addNoteOff(int aTrack, int aTick, int aChannel, int key,
 //
 
 MidiEvent* MidiFile::addNoteOff(int aTrack, int aTick, int aChannel, int key) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeNoteOff(aChannel, key);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -2010,7 +2067,7 @@ MidiEvent* MidiFile::addNoteOff(int aTrack, int aTick, int aChannel, int key) {
 
 MidiEvent* MidiFile::addController(int aTrack, int aTick, int aChannel,
 		int num, int value) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makeController(aChannel, num, value);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -2027,7 +2084,7 @@ MidiEvent* MidiFile::addController(int aTrack, int aTick, int aChannel,
 
 MidiEvent* MidiFile::addPatchChange(int aTrack, int aTick, int aChannel,
 		int patchnum) {
-	MidiEvent* me = new MidiEvent;
+	MidiEvent* me = m_events[aTrack]->newEvent();
 	me->makePatchChange(aChannel, patchnum);
 	me->tick = aTick;
 	m_events[aTrack]->push_back_no_copy(me);
@@ -2199,7 +2256,7 @@ MidiEvent* MidiFile::addSustainPedalOff(int aTrack, int aTick, int aChannel) {
 int MidiFile::addTrack(void) {
 	int length = getNumTracks();
 	m_events.resize(length+1);
-	m_events[length] = new MidiEventList;
+	m_events[length] = newEventList();
 	m_events[length]->reserve(10000);
 	m_events[length]->clear();
 	return length;
@@ -2210,7 +2267,7 @@ int MidiFile::addTrack(int count) {
 	m_events.resize(length+count);
 	int i;
 	for (i=0; i<count; i++) {
-		m_events[length + i] = new MidiEventList;
+		m_events[length + i] = newEventList();
 		m_events[length + i]->reserve(10000);
 		m_events[length + i]->clear();
 	}
@@ -2279,8 +2336,19 @@ void MidiFile::clear(void) {
 		delete m_events[i];
 		m_events[i] = NULL;
 	}
+	// The track lists do not delete arena events, so release them all here.
+	if (m_arena != NULL) {
+		if (m_useArena) {
+			m_arena->clear();
+		} else {
+			delete m_arena;
+			m_arena = NULL;
+		}
+	} else if (m_useArena) {
+		m_arena = new MidiEventArena;
+	}
 	m_events.resize(1);
-	m_events[0] = new MidiEventList;
+	m_events[0] = newEventList();
 	m_timemapvalid=0;
 	m_timemap.clear();
 	m_theTrackState = TRACK_STATE_SPLIT;
@@ -2294,6 +2362,35 @@ void MidiFile::erase(void) {
 
 
 
+//////////////////////////////
+//
+// MidiFile::setEventArena -- Store the events of the file in a single
+//     slab arena instead of allocating each one separately.  All events
+//     of a song are then released at once by clear() or by the
+//     destructor.  Takes effect at the next clear() (and so at the next
+//     read).  Events added by push_back_no_copy() to an arena-backed track
+//     must be allocated with MidiEventList::newEvent().
+//     default value: state = true.
+//
+
+void MidiFile::setEventArena(bool state) {
+	m_useArena = state;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFile::hasEventArena -- Returns true if the current events are
+//     stored in an arena.
+//
+
+bool MidiFile::hasEventArena(void) const {
+	return m_arena != NULL;
+}
+
+
+
 //////////////////////////////
 //
 // MidiFile::getEvent -- return the event at the given index in the
@@ -2368,7 +2465,7 @@ int MidiFile::getNumEvents(int aTrack) const {
 
 void MidiFile::mergeTracks(int aTrack1, int aTrack2) {
 	MidiEventList* mergedTrack;
-	mergedTrack = new MidiEventList;
+	mergedTrack = newEventList();
 	int oldTimeState = getTickState();
 	if (oldTimeState == TIME_STATE_DELTA) {
 		makeAbsoluteTicks();
@@ -2529,257 +2626,333 @@ void MidiFile::clearLinks(void) {
 
 //////////////////////////////
 //
-// MidiFile::linearTickInterpolationAtSecond -- return the tick value at the
-//    given input time.
+// MidiFile::buildTimeMap -- build the tempo segment index of the file and
+//      assign the time in seconds to every event.  A segment starts at
+//      tick 0 (at 120 beats per minute until a tempo is given) and at each
+//      tempo change, and stores the seconds at its first tick along with
+//      the seconds per tick up to the next segment.  Events are timed
+//      track by track, so the tracks are not joined and sorted.  If SMPTE
+//      time code is used, then ticks are actually time values (1000 ticks
+//      per second SMPTE is the only mode tested (25 frames per second and
+//      40 subframes per frame).
 //
 
-double MidiFile::linearTickInterpolationAtSecond(double seconds) {
-	if (m_timemapvalid == 0) {
-		buildTimeMap();
-		if (m_timemapvalid == 0) {
-			return -1.0;    // something went wrong
+void MidiFile::buildTimeMap(void) {
+
+	// convert the MIDI file to absolute time representation
+	// (and undo if the MIDI file was not in that state when this
+	// function was called).
+	//
+	int timestate = getTickState();
+	makeAbsoluteTicks();
+
+	int tpq = getTicksPerQuarterNote();
+	double defaultTempo = 120.0;
+
+	// collect the tempo changes of all tracks in tick order:
+	std::vector<std::pair<int, double>> tempos;
+	for (int i=0; i<getTrackCount(); i++) {
+		MidiEventList& track = *m_events[i];
+		for (int j=0; j<track.size(); j++) {
+			if (track[j].isTempo()) {
+				tempos.emplace_back(track[j].tick, track[j].getTempoSPT(tpq));
+			}
 		}
 	}
+	std::stable_sort(tempos.begin(), tempos.end(),
+			[](const std::pair<int, double>& a, const std::pair<int, double>& b) {
+				return a.first < b.first;
+			});
 
-	int i;
-	double lasttime = m_timemap[m_timemap.size()-1].seconds;
-	// give an error value of -1 if time is out of range of data.
-	if (seconds < 0.0) {
-		return -1.0;
-	}
-	if (seconds > m_timemap[m_timemap.size()-1].seconds) {
-		return -1.0;
+	m_timemap.clear();
+	m_timemap.reserve(tempos.size() + 1);
+
+	_TickTime value;
+	value.tick           = 0;
+	value.seconds        = 0.0;
+	value.secondsPerTick = 60.0 / (defaultTempo * tpq);
+	m_timemap.push_back(value);
+
+	for (int i=0; i<(int)tempos.size(); i++) {
+		_TickTime& last = m_timemap.back();
+		if (tempos[i].first <= last.tick) {
+			// later tempo at the same tick overrides the earlier one
+			last.secondsPerTick = tempos[i].second;
+			continue;
+		}
+		value.seconds        = last.seconds + (tempos[i].first - last.tick) * last.secondsPerTick;
+		value.tick           = tempos[i].first;
+		value.secondsPerTick = tempos[i].second;
+		m_timemap.push_back(value);
 	}
 
-	// Guess which side of the list is closest to target:
-	// Could do a more efficient algorithm since time values are sorted,
-	// but good enough for now...
-	int startindex = -1;
-	if (seconds < lasttime / 2) {
-		for (i=0; i<(int)m_timemap.size(); i++) {
-			if (m_timemap[i].seconds > seconds) {
-				startindex = i-1;
-				break;
-			} else if (m_timemap[i].seconds == seconds) {
-				startindex = i;
-				break;
+	// assign the time in seconds to each event.  Events are usually
+	// in tick order, so step the segment forwards and only search
+	// when a track goes back in time.
+	for (int i=0; i<getTrackCount(); i++) {
+		MidiEventList& track = *m_events[i];
+		int segment = 0;
+		for (int j=0; j<track.size(); j++) {
+			int tick = track[j].tick;
+			if (tick < m_timemap[segment].tick) {
+				segment = findTempoSegment(tick);
 			}
-		}
-	} else {
-		for (i=(int)m_timemap.size()-1; i>0; i--) {
-			if (m_timemap[i].seconds < seconds) {
-				startindex = i+1;
-				break;
-			} else if (m_timemap[i].seconds == seconds) {
-				startindex = i;
-				break;
+			while ((segment + 1 < (int)m_timemap.size()) &&
+					(m_timemap[segment+1].tick <= tick)) {
+				segment++;
 			}
+			const _TickTime& entry = m_timemap[segment];
+			track[j].seconds = entry.seconds + (tick - entry.tick) * entry.secondsPerTick;
 		}
 	}
 
-	if (startindex < 0) {
-		return -1.0;
-	}
-	if (startindex >= (int)m_timemap.size()-1) {
-		return -1.0;
+	// reset the time values if necessary here:
+	if (timestate == TIME_STATE_DELTA) {
+		deltaTicks();
 	}
 
-	double x1 = m_timemap[startindex].seconds;
-	double x2 = m_timemap[startindex+1].seconds;
-	double y1 = m_timemap[startindex].tick;
-	double y2 = m_timemap[startindex+1].tick;
-	double xi = seconds;
+	m_timemapvalid = 1;
 
-	return (xi-x1) * ((y2-y1)/(x2-x1)) + y1;
 }
 
 
 
 //////////////////////////////
 //
-// MidiFile::linearSecondInterpolationAtTick -- return the time in seconds
-//    value at the given input tick time. (Ticks input could be made double).
+// MidiFile::findTempoSegment -- return the index of the tempo segment
+//    which contains the given tick.  Ticks before the first segment
+//    are given the first one.
 //
 
-double MidiFile::linearSecondInterpolationAtTick(int ticktime) {
-	if (m_timemapvalid == 0) {
-		buildTimeMap();
-		if (m_timemapvalid == 0) {
-			return -1.0;    // something went wrong
-		}
+int MidiFile::findTempoSegment(int tick) const {
+	auto it = std::upper_bound(m_timemap.begin(), m_timemap.end(), tick,
+			[](int value, const _TickTime& entry) { return value < entry.tick; });
+	if (it == m_timemap.begin()) {
+		return 0;
 	}
+	return (int)(it - m_timemap.begin()) - 1;
+}
 
-	int i;
-	double lasttick = m_timemap[m_timemap.size()-1].tick;
-	// give an error value of -1 if time is out of range of data.
-	if (ticktime < 0.0) {
-		return -1;
-	}
-	if (ticktime > m_timemap.back().tick) {
-		return -1;  // don't try to extrapolate
-	}
-
-	// Guess which side of the list is closest to target:
-	// Could do a more efficient algorithm since time values are sorted,
-	// but good enough for now...
-	int startindex = -1;
-	if (ticktime < lasttick / 2) {
-		for (i=0; i<(int)m_timemap.size(); i++) {
-			if (m_timemap[i].tick > ticktime) {
-				startindex = i-1;
-				break;
-			} else if (m_timemap[i].tick == ticktime) {
-				startindex = i;
-				break;
-			}
-		}
-	} else {
-		for (i=(int)m_timemap.size()-1; i>0; i--) {
-			if (m_timemap[i].tick < ticktime) {
-				startindex = i;
-				break;
-			} else if (m_timemap[i].tick == ticktime) {
-				startindex = i;
-				break;
-			}
-		}
-	}
 
-	if (startindex < 0) {
-		return -1;
-	}
-	if (startindex >= (int)m_timemap.size()-1) {
-		return -1;
-	}
 
-	if (m_timemap[startindex].tick == ticktime) {
-		return m_timemap[startindex].seconds;
+//////////////////////////////
+//
+// MidiFile::findTempoSegmentAtSecond -- return the index of the tempo
+//    segment which contains the given time in seconds.
+//
+
+int MidiFile::findTempoSegmentAtSecond(double seconds) const {
+	auto it = std::upper_bound(m_timemap.begin(), m_timemap.end(), seconds,
+			[](double value, const _TickTime& entry) { return value < entry.seconds; });
+	if (it == m_timemap.begin()) {
+		return 0;
 	}
+	return (int)(it - m_timemap.begin()) - 1;
+}
 
-	double x1 = m_timemap[startindex].tick;
-	double x2 = m_timemap[startindex+1].tick;
-	double y1 = m_timemap[startindex].seconds;
-	double y2 = m_timemap[startindex+1].seconds;
-	double xi = ticktime;
 
-	return (xi-x1) * ((y2-y1)/(x2-x1)) + y1;
+
+//////////////////////////////
+//
+// MidiFile::newEventList -- Allocate an empty track list which stores
+//    its events in the file's arena (if there is one).
+//
+
+MidiEventList* MidiFile::newEventList(void) {
+	MidiEventList* output = new MidiEventList;
+	output->m_arena = m_arena;
+	return output;
 }
 
 
 
 //////////////////////////////
 //
-// MidiFile::buildTimeMap -- build an index of the absolute tick values
-//      found in a MIDI file, and their corresponding time values in
-//      seconds, taking into consideration tempo change messages.  If no
-//      tempo messages are given (or untill they are given, then the
-//      tempo is set to 120 beats per minute).  If SMPTE time code is
-//      used, then ticks are actually time values.  So don't build
-//      a time map for SMPTE ticks, and just calculate the time in
-//      seconds from the tick value (1000 ticks per second SMPTE
-//      is the only mode tested (25 frames per second and 40 subframes
-//      per frame).
+// MidiFile::extractTrackData -- Decode the MIDI events of one MTrk chunk
+//    into the given track.  The cursor is left after the end-of-track
+//    message (or at the end of the data).  The chunk size is only used as
+//    an allocation hint.  Events are created in the given arena, or on the
+//    heap if it is NULL.  Return value is 0 if failure; otherwise, returns 1.
 //
 
-void MidiFile::buildTimeMap(void) {
+int MidiFile::extractTrackData(const uchar*& ptr, const uchar* end,
+		int track, int chunksize, MidiEventArena* arena) {
 
-	// convert the MIDI file to absolute time representation
-	// in single track mode (and undo if the MIDI file was not
-	// in that state when this function was called.
-	//
-	int trackstate = getTrackState();
-	int timestate  = getTickState();
+	MidiEventList& eventlist = *m_events[track];
 
-	makeAbsoluteTicks();
-	joinTracks();
+	// Set the size of the track allocation so that it might
+	// approximately fit the data.
+	eventlist.reserve(chunksize/2);
+	eventlist.clear();
 
-	int allocsize = getNumEvents(0);
-	m_timemap.reserve(allocsize+10);
-	m_timemap.clear();
+	// Read MIDI events in the track, which are pairs of VLV values
+	// and then the bytes for the MIDI message.  Running status messags
+	// will be filled in with their implicit command byte.
+	// The timestamps are converted from delta ticks to absolute ticks,
+	// with the absticks variable accumulating the VLV tick values.
+	// Events are decoded directly into their final storage, so the
+	// message bytes are only copied once.
+	uchar runningCommand = 0;
+	int absticks = 0;
+	while (true) {
+		absticks += readVLValue(ptr, end);
+		if (!status()) {
+			return 0;
+		}
+		MidiEvent* event = arena ? arena->create() : new MidiEvent;
+		if (!extractMidiData(ptr, end, *event, runningCommand)) {
+			if (!arena) {
+				delete event;
+			}
+			return 0;
+		}
+		event->tick = absticks;
+		event->track = track;
+		eventlist.push_back_no_copy(event);
 
-	_TickTime value;
+		if (event->isEndOfTrack()) {
+			break;
+		}
+	}
+	return 1;
+}
 
-	int lasttick = 0;
-	int tickinit = 0;
 
-	int i;
-	int tpq = getTicksPerQuarterNote();
-	double defaultTempo = 120.0;
-	double secondsPerTick = 60.0 / (defaultTempo * tpq);
-
-	double lastsec = 0.0;
-	double cursec = 0.0;
-
-	for (i=0; i<getNumEvents(0); i++) {
-		int curtick = getEvent(0, i).tick;
-		getEvent(0, i).seconds = cursec;
-		if ((curtick > lasttick) || !tickinit) {
-			tickinit = 1;
-
-			// calculate the current time in seconds:
-			cursec = lastsec + (curtick - lasttick) * secondsPerTick;
-			getEvent(0, i).seconds = cursec;
-
-			// store the new tick to second mapping
-			value.tick = curtick;
-			value.seconds = cursec;
-			m_timemap.push_back(value);
-			lasttick   = curtick;
-			lastsec    = cursec;
-		}
 
-		// update the tempo if needed:
-		if (getEvent(0,i).isTempo()) {
-			secondsPerTick = getEvent(0,i).getTempoSPT(getTicksPerQuarterNote());
+//////////////////////////////
+//
+// MidiFile::scanTrackChunks -- Collect the data range of every MTrk
+//    chunk from the chunk sizes in their headers.  Returns false (without
+//    printing errors) if the chunk table does not describe the expected
+//    number of tracks within the data.
+//
+
+bool MidiFile::scanTrackChunks(const uchar* ptr, const uchar* end, int tracks,
+		std::vector<std::pair<const uchar*, const uchar*>>& chunks) {
+	chunks.clear();
+	chunks.reserve(tracks);
+	for (int i=0; i<tracks; i++) {
+		if ((end - ptr < 8) || (std::memcmp(ptr, "MTrk", 4) != 0)) {
+			return false;
+		}
+		ptr += 4;
+		ulong length = readBigEndian4Bytes(ptr, end);
+		if ((ulong)(end - ptr) < length) {
+			return false;
 		}
+		chunks.emplace_back(ptr, ptr + length);
+		ptr += length;
 	}
+	return true;
+}
 
-	// reset the states of the tracks or time values if necessary here:
-	if (timestate == TIME_STATE_DELTA) {
-		deltaTicks();
+
+
+//////////////////////////////
+//
+// MidiFile::extractTracksParallel -- Decode the given MTrk chunks into
+//    their tracks on a pool of worker threads.  Each worker takes the
+//    next undecoded track, so the results are identical to the serial
+//    reader.  Returns false if a track could not be decoded or did not
+//    end exactly at its chunk boundary (the chunk sizes cannot be trusted,
+//    so the serial reader must be used); the tracks are then left empty
+//    and the read status is reset.
+//
+
+bool MidiFile::extractTracksParallel(
+		const std::vector<std::pair<const uchar*, const uchar*>>& chunks,
+		int threads) {
+	std::atomic<int>  next(0);
+	std::atomic<bool> mismatch(false);
+	int tracks = (int)chunks.size();
+
+	// The arena is not thread-safe, so each track gets its own one which
+	// is merged into the file's arena after decoding.
+	std::vector<MidiEventArena> arenas(m_arena ? tracks : 0);
+
+	auto worker = [&]() {
+		int i;
+		while (!mismatch && ((i = next++) < tracks)) {
+			const uchar* ptr = chunks[i].first;
+			const uchar* end = chunks[i].second;
+			MidiEventArena* arena = NULL;
+			if (m_arena) {
+				arena = &arenas[i];
+				arena->reserve((int)((end - ptr) / 3) + 16);
+			}
+			if (!extractTrackData(ptr, end, i, (int)(end - ptr), arena) ||
+					(ptr != end)) {
+				mismatch = true;
+			}
+		}
+	};
+
+	m_quietRead = true;
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+	for (int t=1; t<threads; t++) {
+		pool.emplace_back(worker);
 	}
-	if (trackstate == TRACK_STATE_SPLIT) {
-		splitTracks();
+	worker();
+	for (auto& thread : pool) {
+		thread.join();
 	}
+	m_quietRead = false;
 
-	m_timemapvalid = 1;
+	if (mismatch) {
+		// The per-track arenas release their events when they go out of
+		// scope, so only the lists which point into them are emptied.
+		for (int i=0; i<tracks; i++) {
+			m_events[i]->clear();
+		}
+		m_rwstatus = true;
+		return false;
+	}
 
+	for (int i=0; i<(int)arenas.size(); i++) {
+		m_arena->adopt(arenas[i]);
+	}
+	return true;
 }
 
 
 
 //////////////////////////////
 //
-// MidiFile::extractMidiData -- Extract MIDI data from input
-//    stream.  Return value is 0 if failure; otherwise, returns 1.
+// MidiFile::extractMidiData -- Extract MIDI data from the byte cursor,
+//    which is advanced past the message.  Return value is 0 if failure;
+//    otherwise, returns 1.
 //
 
-int MidiFile::extractMidiData(std::istream& input, std::vector<uchar>& array,
-	uchar& runningCommand) {
+int MidiFile::extractMidiData(const uchar*& ptr, const uchar* end,
+	MidiMessage& array, uchar& runningCommand) {
 
-	int character;
 	uchar byte;
-	array.clear();
 	int runningQ;
 
-	character = input.get();
-	if (character == EOF) {
-		std::cerr << "Error: unexpected end of file." << std::endl;
+	if (ptr >= end) {
+		if (!m_quietRead) {
+			std::cerr << "Error: unexpected end of file." << std::endl;
+		}
 		return 0;
 	} else {
-		byte = (uchar)character;
+		byte = *ptr++;
 	}
 
 	if (byte < 0x80) {
 		runningQ = 1;
 		if (runningCommand == 0) {
-			std::cerr << "Error: running command with no previous command" << std::endl;
+			if (!m_quietRead) {
+				std::cerr << "Error: running command with no previous command" << std::endl;
+			}
 			return 0;
 		}
 		if (runningCommand >= 0xf0) {
-			std::cerr << "Error: running status not permitted with meta and sysex"
-			     << " event." << std::endl;
-			std::cerr << "Byte is 0x" << std::hex << (int)byte << std::dec << std::endl;
+			if (!m_quietRead) {
+				std::cerr << "Error: running status not permitted with meta and sysex"
+				     << " event." << std::endl;
+				std::cerr << "Byte is 0x" << std::hex << (int)byte << std::dec << std::endl;
+			}
 			return 0;
 		}
 	} else {
@@ -2787,9 +2960,13 @@ int MidiFile::extractMidiData(std::istream& input, std::vector<uchar>& array,
 		runningQ = 0;
 	}
 
-	array.push_back(runningCommand);
+	// Channel messages are at most three bytes, so assemble them on the
+	// stack and store them with a single allocation.
+	uchar message[3];
+	int   count = 0;
+	message[count++] = runningCommand;
 	if (runningQ) {
-		array.push_back(byte);
+		message[count++] = byte;
 	}
 
 	switch (runningCommand & 0xf0) {
@@ -2798,66 +2975,72 @@ int MidiFile::extractMidiData(std::istream& input, std::vector<uchar>& array,
 		case 0xA0:        // aftertouch (2 more bytes)
 		case 0xB0:        // cont. controller (2 more bytes)
 		case 0xE0:        // pitch wheel (2 more bytes)
-			byte = readByte(input);
+			byte = readByte(ptr, end);
 			if (!status()) { return m_rwstatus; }
 			if (byte > 0x7f) {
-				std::cerr << "MIDI data byte too large: " << (int)byte << std::endl;
+				if (!m_quietRead) {
+					std::cerr << "MIDI data byte too large: " << (int)byte << std::endl;
+				}
 				m_rwstatus = false; return m_rwstatus;
 			}
-			array.push_back(byte);
+			message[count++] = byte;
 			if (!runningQ) {
-				byte = readByte(input);
+				byte = readByte(ptr, end);
 				if (!status()) { return m_rwstatus; }
 				if (byte > 0x7f) {
-					std::cerr << "MIDI data byte too large: " << (int)byte << std::endl;
+					if (!m_quietRead) {
+						std::cerr << "MIDI data byte too large: " << (int)byte << std::endl;
+					}
 					m_rwstatus = false; return m_rwstatus;
 				}
-				array.push_back(byte);
+				message[count++] = byte;
 			}
+			array.assign(message, message + count);
 			break;
 		case 0xC0:        // patch change (1 more byte)
 		case 0xD0:        // channel pressure (1 more byte)
 			if (!runningQ) {
-				byte = readByte(input);
+				byte = readByte(ptr, end);
 				if (!status()) { return m_rwstatus; }
 				if (byte > 0x7f) {
-					std::cerr << "MIDI data byte too large: " << (int)byte << std::endl;
+					if (!m_quietRead) {
+						std::cerr << "MIDI data byte too large: " << (int)byte << std::endl;
+					}
 					m_rwstatus = false; return m_rwstatus;
 				}
-				array.push_back(byte);
+				message[count++] = byte;
 			}
+			array.assign(message, message + count);
 			break;
 		case 0xF0:
 			switch (runningCommand) {
 				case 0xff:                 // meta event
 					{
+					const uchar* start = ptr - 1;
 					if (!runningQ) {
-						byte = readByte(input); // meta type
+						byte = readByte(ptr, end); // meta type
 						if (!status()) { return m_rwstatus; }
-						array.push_back(byte);
 					}
 					ulong length = 0;
 					uchar byte1 = 0;
 					uchar byte2 = 0;
 					uchar byte3 = 0;
 					uchar byte4 = 0;
-					byte1 = readByte(input);
+					byte1 = readByte(ptr, end);
 					if (!status()) { return m_rwstatus; }
-					array.push_back(byte1);
 					if (byte1 >= 0x80) {
-						byte2 = readByte(input);
+						byte2 = readByte(ptr, end);
 						if (!status()) { return m_rwstatus; }
-						array.push_back(byte2);
 						if (byte2 > 0x80) {
-							byte3 = readByte(input);
+							byte3 = readByte(ptr, end);
 							if (!status()) { return m_rwstatus; }
-							array.push_back(byte3);
 							if (byte3 >= 0x80) {
-								byte4 = readByte(input);
+								byte4 = readByte(ptr, end);
 								if (!status()) { return m_rwstatus; }
-								array.push_back(byte4);
 								if (byte4 >= 0x80) {
-									std::cerr << "Error: cannot handle large VLVs" << std::endl;
+									if (!m_quietRead) {
+										std::cerr << "Error: cannot handle large VLVs" << std::endl;
+									}
 									m_rwstatus = false; return m_rwstatus;
 								} else {
 									length = unpackVLV(byte1, byte2, byte3, byte4);
@@ -2874,11 +3057,16 @@ int MidiFile::extractMidiData(std::istream& input, std::vector<uchar>& array,
 					} else {
 						length = byte1;
 					}
-					for (int j=0; j<(int)length; j++) {
-						byte = readByte(input); // meta type
-						if (!status()) { return m_rwstatus; }
-						array.push_back(byte);
+					if ((ulong)(end - ptr) < length) {
+						if (!m_quietRead) {
+							std::cerr << "Error: unexpected end of file." << std::endl;
+						}
+						m_rwstatus = false; return m_rwstatus;
 					}
+					// command, type, length VLV and content are stored
+					// exactly as they appear in the file.
+					ptr += length;
+					array.assign(start, ptr);
 					}
 					break;
 
@@ -2896,22 +3084,32 @@ int MidiFile::extractMidiData(std::istream& input, std::vector<uchar>& array,
 				             // that this is a raw byte message.
 				case 0xf0:   // System Exclusive message
 					{         // (complete, or start of message).
-					int length = (int)readVLValue(input);
-					for (int i=0; i<length; i++) {
-						byte = readByte(input);
-						if (!status()) { return m_rwstatus; }
-						array.push_back(byte);
+					ulong length = readVLValue(ptr, end);
+					if (!status()) { return m_rwstatus; }
+					if ((ulong)(end - ptr) < length) {
+						if (!m_quietRead) {
+							std::cerr << "Error: unexpected end of file." << std::endl;
+						}
+						m_rwstatus = false; return m_rwstatus;
 					}
+					array.reserve(length + 1);
+					array.assign(1, runningCommand);
+					array.insert(array.end(), ptr, ptr + length);
+					ptr += length;
 					}
 					break;
 
 				// other "F" MIDI commands are not expected, but can be
 				// handled here if they exist.
+				default:
+					array.assign(1, runningCommand);
 			}
 			break;
 		default:
-			std::cout << "Error reading midifile" << std::endl;
-			std::cout << "Command byte was " << (int)runningCommand << std::endl;
+			if (!m_quietRead) {
+				std::cout << "Error reading midifile" << std::endl;
+				std::cout << "Command byte was " << (int)runningCommand << std::endl;
+			}
 			return 0;
 	}
 	return 1;
@@ -2929,11 +3127,11 @@ int MidiFile::extractMidiData(std::istream& input, std::vector<uchar>& array,
 //   incorrectly as a MIDI command.
 //
 
-ulong MidiFile::readVLValue(std::istream& input) {
+ulong MidiFile::readVLValue(const uchar*& ptr, const uchar* end) {
 	uchar b[5] = {0};
 
 	for (int i=0; i<5; i++) {
-		b[i] = readByte(input);
+		b[i] = readByte(ptr, end);
 		if (!status()) { return m_rwstatus; }
 		if (b[i] < 0x80) {
 			break;
@@ -2945,6 +3143,94 @@ ulong MidiFile::readVLValue(std::istream& input) {
 
 
 
+//////////////////////////////
+//
+// MidiFile::readByte -- Read one byte from the byte cursor.  Set
+//     fail status error if the end of the data was reached (calling
+//     function has to check this status for an error after reading).
+//
+
+uchar MidiFile::readByte(const uchar*& ptr, const uchar* end) {
+	if (ptr >= end) {
+		if (!m_quietRead) {
+			std::cerr << "Error: unexpected end of file." << std::endl;
+		}
+		m_rwstatus = false;
+		return 0;
+	}
+	return *ptr++;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFile::readBigEndian4Bytes -- Read four bytes in big-endian order
+//      (most significant byte first) from the byte cursor.
+//
+
+ulong MidiFile::readBigEndian4Bytes(const uchar*& ptr, const uchar* end) {
+	if (end - ptr < 4) {
+		std::cerr << "Error: unexpected end of file." << std::endl;
+		ptr = end;
+		return 0;
+	}
+	ulong output = ((ulong)ptr[0] << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+	ptr += 4;
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFile::readBigEndian2Bytes -- Read two bytes in big-endian order
+//      (most significant byte first) from the byte cursor.
+//
+
+ushort MidiFile::readBigEndian2Bytes(const uchar*& ptr, const uchar* end) {
+	if (end - ptr < 2) {
+		std::cerr << "Error: unexpected end of file." << std::endl;
+		ptr = end;
+		return 0;
+	}
+	ushort output = (ushort)((ptr[0] << 8) | ptr[1]);
+	ptr += 2;
+	return output;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFile::checkChunkId -- Verify and skip a four-character chunk
+//    identifier such as "MThd" or "MTrk".  The context string is appended
+//    to the error messages (e.g., " in track").
+//
+
+bool MidiFile::checkChunkId(const uchar*& ptr, const uchar* end,
+		const char* id, const char* context) {
+	static const char* ordinal[4] = { "first", "second", "third", "fourth" };
+	std::string filename = getFilename();
+	for (int i=0; i<4; i++) {
+		if (ptr >= end) {
+			std::cerr << "In file " << filename << ": unexpected end of file." << std::endl;
+			std::cerr << "Expecting '" << id[i] << "' at " << ordinal[i]
+			     << " byte" << context << ", but found nothing." << std::endl;
+			return false;
+		} else if (*ptr != (uchar)id[i]) {
+			std::cerr << "File " << filename << " is not a MIDI file" << std::endl;
+			std::cerr << "Expecting '" << id[i] << "' at " << ordinal[i]
+			     << " byte" << context << " but got '" << (char)*ptr << "'" << std::endl;
+			return false;
+		}
+		ptr++;
+	}
+	return true;
+}
+
+
+
 //////////////////////////////
 //
 // MidiFile::unpackVLV -- converts a VLV value to an unsigned long value.
@@ -2961,7 +3247,9 @@ ulong MidiFile::unpackVLV(uchar a, uchar b, uchar c, uchar d, uchar e) {
 	}
 	count++;
 	if (count >= 6) {
-		std::cerr << "VLV number is too large" << std::endl;
+		if (!m_quietRead) {
+			std::cerr << "VLV number is too large" << std::endl;
+		}
 		m_rwstatus = false;
 		return 0;
 	}
@@ -3026,7 +3314,7 @@ void MidiFile::clear_no_deallocate(void) {
 		m_events[i] = NULL;
 	}
 	m_events.resize(1);
-	m_events[0] = new MidiEventList;
+	m_events[0] = newEventList();
 	m_timemapvalid=0;
 	m_timemap.clear();
 	// m_events.resize(0);   // causes a memory leak [20150205 Jorden Thatcher]
@@ -3034,43 +3322,6 @@ void MidiFile::clear_no_deallocate(void) {
 
 
 
-//////////////////////////////
-//
-// MidiFile::ticksearch -- for finding a tick entry in the time map.
-//
-
-int MidiFile::ticksearch(const void* A, const void* B) {
-	_TickTime& a = *((_TickTime*)A);
-	_TickTime& b = *((_TickTime*)B);
-
-	if (a.tick < b.tick) {
-		return -1;
-	} else if (a.tick > b.tick) {
-		return 1;
-	}
-	return 0;
-}
-
-
-
-//////////////////////////////
-//
-// MidiFile::secondsearch -- for finding a second entry in the time map.
-//
-
-int MidiFile::secondsearch(const void* A, const void* B) {
-	_TickTime& a = *((_TickTime*)A);
-	_TickTime& b = *((_TickTime*)B);
-
-	if (a.seconds < b.seconds) {
-		return -1;
-	} else if (a.seconds > b.seconds) {
-		return 1;
-	}
-	return 0;
-}
-
-
 ///////////////////////////////////////////////////////////////////////////
 //
 // Static functions:
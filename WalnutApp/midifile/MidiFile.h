@@ -15,11 +15,13 @@
 #define _MIDIFILE_H_INCLUDED
 
 #include "MidiEventList.h"
+#include "MidiEventArena.h"
 
 #include <vector>
 #include <string>
 #include <istream>
 #include <fstream>
+#include <atomic>
 
 #define TIME_STATE_DELTA       0
 #define TIME_STATE_ABSOLUTE    1
@@ -33,6 +35,7 @@ class _TickTime {
 	public:
 		int    tick;
 		double seconds;
+		double secondsPerTick;  // tempo from this tick until the next entry
 };
 
 
@@ -60,6 +63,8 @@ class MidiFile {
 		// Only allow Standard MIDI File input:
 		bool           readSmf                     (const std::string& filename);
 		bool           readSmf                     (std::istream& instream);
+		bool           readSmf                     (const uchar* data, size_t size);
+		bool           readMapped                  (const std::string& filename);
 
 		bool           write                       (const std::string& filename);
 		bool           write                       (std::ostream& out);
@@ -74,6 +79,10 @@ class MidiFile {
 		bool           writeBinascWithComments     (std::ostream& out);
 		bool           status                      (void) const;
 
+		// multi-threaded track decoding when reading:
+		void           setReadThreadCount          (int count);
+		int            getReadThreadCount          (void) const;
+
 		// track-related functions:
 		const MidiEventList& operator[]            (int aTrack) const;
 		MidiEventList&   operator[]                (int aTrack);
@@ -156,6 +165,10 @@ class MidiFile {
 		void             clear                     (void);
 		void             clear_no_deallocate       (void);
 
+		// event storage functions:
+		void             setEventArena             (bool state = true);
+		bool             hasEventArena             (void) const;
+
 		// MIDI message adding convenience functions:
 		MidiEvent*        addNoteOn               (int aTrack, int aTick,
 		                                           int aChannel, int key,
@@ -282,31 +295,76 @@ class MidiFile {
 		// m_timemapvalid ==
 		bool m_timemapvalid = false;
 
-		// m_timemap ==
+		// m_timemap == Tempo segment index: an entry at tick 0 and one at
+		// each tempo change, sorted by tick (and therefore by seconds).
 		std::vector<_TickTime> m_timemap;
 
 		// m_rwstatus == True if last read was successful, false if a problem.
-		bool m_rwstatus = true;
+		// Atomic because track chunks may be decoded by several threads.
+		std::atomic<bool> m_rwstatus{true};
+
+		// m_readThreadCount == Number of threads used to decode MTrk chunks
+		// when reading and to link note pairs.  1 is serial, 0 means one
+		// thread per hardware core.
+		int m_readThreadCount = 1;
+
+		// m_quietRead == True while tracks are decoded in parallel.  Decoding
+		// errors are not printed then, since a failed track is read again
+		// by the serial reader, which reports them.
+		bool m_quietRead = false;
 
 		// m_linkedEventQ == True if link analysis has been done.
 		bool m_linkedEventsQ = false;
 
+		// m_useArena == True if events should be stored in m_arena.  Takes
+		// effect at the next clear() (which is done by every read).
+		bool m_useArena = false;
+
+		// m_arena == Slab storage shared by all track lists, so that a
+		// whole song can be released at once.  NULL when events are
+		// individually allocated.
+		MidiEventArena* m_arena = NULL;
+
 	private:
-		int         extractMidiData                 (std::istream& inputfile,
-		                                             std::vector<uchar>& array,
+		// SmfEventStream decodes track data with the functions below.
+		friend class SmfEventStream;
+
+		MidiEventList* newEventList                 (void);
+		int         extractTrackData                (const uchar*& ptr,
+		                                             const uchar* end,
+		                                             int track, int chunksize,
+		                                             MidiEventArena* arena);
+		bool        scanTrackChunks                 (const uchar* ptr,
+		                                             const uchar* end,
+		                                             int tracks,
+		                                             std::vector<std::pair<const uchar*, const uchar*>>& chunks);
+		bool        extractTracksParallel           (const std::vector<std::pair<const uchar*, const uchar*>>& chunks,
+		                                             int threads);
+		int         extractMidiData                 (const uchar*& ptr,
+		                                             const uchar* end,
+		                                             MidiMessage& array,
 		                                             uchar& runningCommand);
-		ulong       readVLValue                     (std::istream& inputfile);
+		ulong       readVLValue                     (const uchar*& ptr,
+		                                             const uchar* end);
+		uchar       readByte                        (const uchar*& ptr,
+		                                             const uchar* end);
+		static ulong  readBigEndian4Bytes           (const uchar*& ptr,
+		                                             const uchar* end);
+		static ushort readBigEndian2Bytes           (const uchar*& ptr,
+		                                             const uchar* end);
+		bool        checkChunkId                    (const uchar*& ptr,
+		                                             const uchar* end,
+		                                             const char* id,
+		                                             const char* context);
 		ulong       unpackVLV                       (uchar a = 0, uchar b = 0,
 		                                             uchar c = 0, uchar d = 0,
 		                                             uchar e = 0);
 		void        writeVLValue                    (long aValue,
 		                                             std::vector<uchar>& data);
 		int         makeVLV                         (uchar *buffer, int number);
-		static int  ticksearch                      (const void* A, const void* B);
-		static int  secondsearch                    (const void* A, const void* B);
 		void        buildTimeMap                    (void);
-		double      linearTickInterpolationAtSecond (double seconds);
-		double      linearSecondInterpolationAtTick (int ticktime);
+		int         findTempoSegment                (int tick) const;
+		int         findTempoSegmentAtSecond        (double seconds) const;
 		std::string base64Encode                    (const std::string &input);
 		std::string base64Decode                    (const std::string &input);
 
@@ -27,45 +27,45 @@ namespace smf {
 // MidiMessage::MidiMessage -- Constructor.
 //
 
-MidiMessage::MidiMessage(void) : vector<uchar>() {
+MidiMessage::MidiMessage(void) : MidiMessageBuffer() {
 	// do nothing
 }
 
 
-MidiMessage::MidiMessage(int command) : vector<uchar>(1, (uchar)command) {
+MidiMessage::MidiMessage(int command) : MidiMessageBuffer(1, (uchar)command) {
 	// do nothing
 }
 
 
-MidiMessage::MidiMessage(int command, int p1) : vector<uchar>(2) {
+MidiMessage::MidiMessage(int command, int p1) : MidiMessageBuffer(2) {
 	(*this)[0] = (uchar)command;
 	(*this)[1] = (uchar)p1;
 }
 
 
-MidiMessage::MidiMessage(int command, int p1, int p2) : vector<uchar>(3) {
+MidiMessage::MidiMessage(int command, int p1, int p2) : MidiMessageBuffer(3) {
 	(*this)[0] = (uchar)command;
 	(*this)[1] = (uchar)p1;
 	(*this)[2] = (uchar)p2;
 }
 
 
-MidiMessage::MidiMessage(const MidiMessage& message) : vector<uchar>() {
+MidiMessage::MidiMessage(const MidiMessage& message) : MidiMessageBuffer() {
 	(*this) = message;
 }
 
 
-MidiMessage::MidiMessage(const std::vector<uchar>& message) : vector<uchar>() {
+MidiMessage::MidiMessage(const std::vector<uchar>& message) : MidiMessageBuffer() {
 	setMessage(message);
 }
 
 
-MidiMessage::MidiMessage(const std::vector<char>& message) : vector<uchar>() {
+MidiMessage::MidiMessage(const std::vector<char>& message) : MidiMessageBuffer() {
 	setMessage(message);
 }
 
 
-MidiMessage::MidiMessage(const std::vector<int>& message) : vector<uchar>() {
+MidiMessage::MidiMessage(const std::vector<int>& message) : MidiMessageBuffer() {
 	setMessage(message);
 }
 
@@ -91,15 +91,12 @@ MidiMessage& MidiMessage::operator=(const MidiMessage& message) {
 	if (this == &message) {
 		return *this;
 	}
-	std::vector<uchar>::operator=(static_cast<const std::vector<uchar> &>(message));
+	MidiMessageBuffer::operator=(static_cast<const MidiMessageBuffer&>(message));
 	return *this;
 }
 
 
 MidiMessage& MidiMessage::operator=(const std::vector<uchar>& bytes) {
-	if (this == &bytes) {
-		return *this;
-	}
 	setMessage(bytes);
 	return *this;
 }
@@ -1547,7 +1544,8 @@ void MidiMessage::setMetaContent(const std::string& content) {
 	for (int i=0; i<(int)vlv.size(); i++) {
 		this->push_back(vlv[i]);
 	}
-	std::copy(content.begin(), content.end(), std::back_inserter(*this));
+	this->insert(this->end(), (const uchar*)content.data(),
+			(const uchar*)content.data() + content.size());
 }
 
 
@@ -14,6 +14,8 @@
 #ifndef _MIDIMESSAGE_H_INCLUDED
 #define _MIDIMESSAGE_H_INCLUDED
 
+#include "MidiMessageBuffer.h"
+
 #include <string>
 #include <utility>
 #include <vector>
@@ -24,7 +26,7 @@ typedef unsigned char  uchar;
 typedef unsigned short ushort;
 typedef unsigned long  ulong;
 
-class MidiMessage : public std::vector<uchar> {
+class MidiMessage : public MidiMessageBuffer {
 
 	public:
 		               MidiMessage          (void);
@@ -0,0 +1,535 @@
+//
+// Creation Date: Sat Oct 17 2026
+// Filename:      midifile/include/MidiMessageBuffer.h
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab
+//
+// Description:   Byte storage for MidiMessage.  Up to INLINE_SIZE bytes
+//                are stored inside the object itself, so that channel
+//                messages and short meta messages need no heap block.
+//                Longer messages (SysEx, text meta messages) spill to
+//                the heap.  The interface is the subset of std::vector
+//                that is used on MIDI message bytes.
+//
+
+#ifndef _MIDIMESSAGEBUFFER_H_INCLUDED
+#define _MIDIMESSAGEBUFFER_H_INCLUDED
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <stdexcept>
+
+namespace smf {
+
+typedef unsigned char  uchar;
+
+class MidiMessageBuffer {
+	public:
+		typedef uchar        value_type;
+		typedef uchar&       reference;
+		typedef const uchar& const_reference;
+		typedef uchar*       iterator;
+		typedef const uchar* const_iterator;
+		typedef size_t       size_type;
+
+		static const int INLINE_SIZE = 12;
+
+		               MidiMessageBuffer    (void);
+		               MidiMessageBuffer    (size_t count, uchar value = 0);
+		               MidiMessageBuffer    (const MidiMessageBuffer& other);
+		               MidiMessageBuffer    (MidiMessageBuffer&& other) noexcept;
+		              ~MidiMessageBuffer    ();
+
+		MidiMessageBuffer& operator=        (const MidiMessageBuffer& other);
+		MidiMessageBuffer& operator=        (MidiMessageBuffer&& other) noexcept;
+
+		size_t         size                 (void) const;
+		bool           empty                (void) const;
+		size_t         capacity             (void) const;
+		bool           isInline             (void) const;
+
+		uchar*         data                 (void);
+		const uchar*   data                 (void) const;
+		uchar&         operator[]           (size_t index);
+		const uchar&   operator[]           (size_t index) const;
+		uchar&         at                   (size_t index);
+		const uchar&   at                   (size_t index) const;
+		uchar&         front                (void);
+		const uchar&   front                (void) const;
+		uchar&         back                 (void);
+		const uchar&   back                 (void) const;
+
+		uchar*         begin                (void);
+		const uchar*   begin                (void) const;
+		uchar*         end                  (void);
+		const uchar*   end                  (void) const;
+
+		void           clear                (void);
+		void           reserve              (size_t count);
+		void           resize               (size_t count);
+		void           resize               (size_t count, uchar value);
+		void           push_back            (uchar value);
+		void           pop_back             (void);
+		void           assign               (size_t count, uchar value);
+		void           assign               (const uchar* first, const uchar* last);
+		uchar*         insert               (const uchar* pos, const uchar* first,
+		                                     const uchar* last);
+		uchar*         insert               (const uchar* pos, uchar value);
+		uchar*         erase                (const uchar* first, const uchar* last);
+		uchar*         erase                (const uchar* pos);
+		void           swap                 (MidiMessageBuffer& other) noexcept;
+
+		std::vector<uchar> toVector         (void) const;
+
+	private:
+		// m_storage == The message bytes when stored inline.  Otherwise the
+		// first bytes hold the heap pointer, followed by the heap capacity.
+		alignas(8) uchar m_storage[INLINE_SIZE];
+
+		// m_size == Number of bytes in the message.  The top bit is set when
+		// the bytes are stored on the heap.
+		uint32_t m_size;
+
+		static const uint32_t HEAP_FLAG = 0x80000000u;
+
+		uchar*         heapData             (void) const;
+		uint32_t       heapCapacity         (void) const;
+		void           setHeap              (uchar* data, uint32_t capacity);
+		void           grow                 (size_t count);
+		void           release              (void);
+};
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::MidiMessageBuffer -- Constructors.
+//
+
+inline MidiMessageBuffer::MidiMessageBuffer(void) : m_size(0) {
+	// do nothing
+}
+
+
+inline MidiMessageBuffer::MidiMessageBuffer(size_t count, uchar value) : m_size(0) {
+	assign(count, value);
+}
+
+
+inline MidiMessageBuffer::MidiMessageBuffer(const MidiMessageBuffer& other) : m_size(0) {
+	assign(other.begin(), other.end());
+}
+
+
+inline MidiMessageBuffer::MidiMessageBuffer(MidiMessageBuffer&& other) noexcept {
+	m_size = other.m_size;
+	std::memcpy(m_storage, other.m_storage, INLINE_SIZE);
+	other.m_size = 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::~MidiMessageBuffer -- Deconstructor.
+//
+
+inline MidiMessageBuffer::~MidiMessageBuffer() {
+	release();
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::operator= --
+//
+
+inline MidiMessageBuffer& MidiMessageBuffer::operator=(const MidiMessageBuffer& other) {
+	if (this != &other) {
+		assign(other.begin(), other.end());
+	}
+	return *this;
+}
+
+
+inline MidiMessageBuffer& MidiMessageBuffer::operator=(MidiMessageBuffer&& other) noexcept {
+	if (this != &other) {
+		release();
+		m_size = other.m_size;
+		std::memcpy(m_storage, other.m_storage, INLINE_SIZE);
+		other.m_size = 0;
+	}
+	return *this;
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::size -- Return the number of bytes in the message.
+//
+
+inline size_t MidiMessageBuffer::size(void) const {
+	return m_size & ~HEAP_FLAG;
+}
+
+
+inline bool MidiMessageBuffer::empty(void) const {
+	return size() == 0;
+}
+
+
+inline size_t MidiMessageBuffer::capacity(void) const {
+	return isInline() ? (size_t)INLINE_SIZE : (size_t)heapCapacity();
+}
+
+
+inline bool MidiMessageBuffer::isInline(void) const {
+	return (m_size & HEAP_FLAG) == 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::data -- Return a pointer to the first byte.
+//
+
+inline uchar* MidiMessageBuffer::data(void) {
+	return isInline() ? m_storage : heapData();
+}
+
+
+inline const uchar* MidiMessageBuffer::data(void) const {
+	return isInline() ? m_storage : heapData();
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::operator[] -- Element access.  at() checks the index.
+//
+
+inline uchar& MidiMessageBuffer::operator[](size_t index) {
+	return data()[index];
+}
+
+
+inline const uchar& MidiMessageBuffer::operator[](size_t index) const {
+	return data()[index];
+}
+
+
+inline uchar& MidiMessageBuffer::at(size_t index) {
+	if (index >= size()) {
+		throw std::out_of_range("MidiMessageBuffer::at");
+	}
+	return data()[index];
+}
+
+
+inline const uchar& MidiMessageBuffer::at(size_t index) const {
+	if (index >= size()) {
+		throw std::out_of_range("MidiMessageBuffer::at");
+	}
+	return data()[index];
+}
+
+
+inline uchar& MidiMessageBuffer::front(void) {
+	return data()[0];
+}
+
+
+inline const uchar& MidiMessageBuffer::front(void) const {
+	return data()[0];
+}
+
+
+inline uchar& MidiMessageBuffer::back(void) {
+	return data()[size() - 1];
+}
+
+
+inline const uchar& MidiMessageBuffer::back(void) const {
+	return data()[size() - 1];
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::begin/end -- Iterators are plain byte pointers.
+//
+
+inline uchar* MidiMessageBuffer::begin(void) {
+	return data();
+}
+
+
+inline const uchar* MidiMessageBuffer::begin(void) const {
+	return data();
+}
+
+
+inline uchar* MidiMessageBuffer::end(void) {
+	return data() + size();
+}
+
+
+inline const uchar* MidiMessageBuffer::end(void) const {
+	return data() + size();
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::clear -- Set the size to zero.  Heap storage is
+//    kept for reuse.
+//
+
+inline void MidiMessageBuffer::clear(void) {
+	m_size &= HEAP_FLAG;
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::reserve -- Make room for at least count bytes.
+//
+
+inline void MidiMessageBuffer::reserve(size_t count) {
+	if (count > capacity()) {
+		grow(count);
+	}
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::resize -- Change the number of bytes.  New bytes are
+//    set to zero (or the given value).
+//
+
+inline void MidiMessageBuffer::resize(size_t count) {
+	resize(count, 0);
+}
+
+
+inline void MidiMessageBuffer::resize(size_t count, uchar value) {
+	size_t oldsize = size();
+	reserve(count);
+	if (count > oldsize) {
+		std::memset(data() + oldsize, value, count - oldsize);
+	}
+	m_size = (m_size & HEAP_FLAG) | (uint32_t)count;
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::push_back -- Append one byte.
+//
+
+inline void MidiMessageBuffer::push_back(uchar value) {
+	size_t oldsize = size();
+	if (oldsize == capacity()) {
+		grow(oldsize * 2);
+	}
+	data()[oldsize] = value;
+	m_size++;
+}
+
+
+inline void MidiMessageBuffer::pop_back(void) {
+	m_size--;
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::assign -- Replace the contents.
+//
+
+inline void MidiMessageBuffer::assign(size_t count, uchar value) {
+	clear();
+	resize(count, value);
+}
+
+
+inline void MidiMessageBuffer::assign(const uchar* first, const uchar* last) {
+	size_t count = (size_t)(last - first);
+	clear();
+	reserve(count);
+	if (count > 0) {
+		std::memmove(data(), first, count);
+	}
+	m_size = (m_size & HEAP_FLAG) | (uint32_t)count;
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::insert -- Insert bytes before pos.  Returns a pointer
+//    to the first inserted byte.
+//
+
+inline uchar* MidiMessageBuffer::insert(const uchar* pos, const uchar* first,
+		const uchar* last) {
+	size_t index  = (size_t)(pos - begin());
+	size_t count  = (size_t)(last - first);
+	size_t oldsize = size();
+	if (count == 0) {
+		return data() + index;
+	}
+	if (first >= begin() && first < end()) {
+		// inserting a copy of our own bytes.
+		std::vector<uchar> copy(first, last);
+		return insert(pos, copy.data(), copy.data() + copy.size());
+	}
+	if (oldsize + count > capacity()) {
+		grow(oldsize + count);
+	}
+	uchar* bytes = data();
+	std::memmove(bytes + index + count, bytes + index, oldsize - index);
+	std::memcpy(bytes + index, first, count);
+	m_size += (uint32_t)count;
+	return bytes + index;
+}
+
+
+inline uchar* MidiMessageBuffer::insert(const uchar* pos, uchar value) {
+	return insert(pos, &value, &value + 1);
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::erase -- Remove bytes.  Returns a pointer to the byte
+//    after the removed range.
+//
+
+inline uchar* MidiMessageBuffer::erase(const uchar* first, const uchar* last) {
+	uchar* bytes  = data();
+	size_t index  = (size_t)(first - bytes);
+	size_t count  = (size_t)(last - first);
+	std::memmove(bytes + index, bytes + index + count, size() - index - count);
+	m_size -= (uint32_t)count;
+	return bytes + index;
+}
+
+
+inline uchar* MidiMessageBuffer::erase(const uchar* pos) {
+	return erase(pos, pos + 1);
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::swap --
+//
+
+inline void MidiMessageBuffer::swap(MidiMessageBuffer& other) noexcept {
+	MidiMessageBuffer temp(std::move(other));
+	other = std::move(*this);
+	*this = std::move(temp);
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::toVector -- Return a copy of the bytes as a vector.
+//
+
+inline std::vector<uchar> MidiMessageBuffer::toVector(void) const {
+	return std::vector<uchar>(begin(), end());
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+inline uchar* MidiMessageBuffer::heapData(void) const {
+	uchar* output;
+	std::memcpy(&output, m_storage, sizeof(output));
+	return output;
+}
+
+
+inline uint32_t MidiMessageBuffer::heapCapacity(void) const {
+	uint32_t output;
+	std::memcpy(&output, m_storage + sizeof(uchar*), sizeof(output));
+	return output;
+}
+
+
+inline void MidiMessageBuffer::setHeap(uchar* data, uint32_t capacity) {
+	std::memcpy(m_storage, &data, sizeof(data));
+	std::memcpy(m_storage + sizeof(uchar*), &capacity, sizeof(capacity));
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::grow -- Move the bytes to a heap block that holds at
+//    least count bytes.
+//
+
+inline void MidiMessageBuffer::grow(size_t count) {
+	size_t oldsize = size();
+	size_t newcapacity = capacity() * 2;
+	if (newcapacity < count) {
+		newcapacity = count;
+	}
+	if (newcapacity < oldsize) {
+		newcapacity = oldsize;
+	}
+	uchar* newdata = (uchar*)std::malloc(newcapacity);
+	if (newdata == NULL) {
+		throw std::bad_alloc();
+	}
+	if (oldsize > 0) {
+		std::memcpy(newdata, data(), oldsize);
+	}
+	release();
+	setHeap(newdata, (uint32_t)newcapacity);
+	m_size = HEAP_FLAG | (uint32_t)oldsize;
+}
+
+
+
+//////////////////////////////
+//
+// MidiMessageBuffer::release -- Free heap storage (if any).
+//
+
+inline void MidiMessageBuffer::release(void) {
+	if (!isInline()) {
+		std::free(heapData());
+		m_size = 0;
+	}
+}
+
+} // end of namespace smf
+
+#endif /* _MIDIMESSAGEBUFFER_H_INCLUDED */
+
+
+
@@ -0,0 +1,461 @@
+//
+// Creation Date: Sat Oct 17 2026
+// Filename:      midifile/src/SmfEventStream.cpp
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab
+//
+// Description:   Pull-style reader which returns the events of a Standard
+//                MIDI File in time order across all tracks, without
+//                storing the tracks in memory.
+//
+
+#include "SmfEventStream.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+namespace smf {
+
+
+//////////////////////////////
+//
+// SmfEventStream::SmfEventStream -- Constructor.
+//
+
+SmfEventStream::SmfEventStream(void) {
+	// do nothing
+}
+
+
+SmfEventStream::SmfEventStream(const std::string& filename) {
+	open(filename);
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::~SmfEventStream -- Deconstructor.
+//
+
+SmfEventStream::~SmfEventStream() {
+	close();
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::open -- Prepare a Standard MIDI File for reading with
+//    next().  The filename version memory-maps the file; the buffer
+//    version reads from data which must stay valid until the stream
+//    is closed.  Only the header and the MTrk chunk boundaries are
+//    examined here.  Returns false if the data is not a readable SMF.
+//
+
+bool SmfEventStream::open(const std::string& filename) {
+	close();
+	m_mapped = new MappedFile(filename);
+	if (!m_mapped->isOpen()) {
+		std::cerr << "Error: cannot open " << filename << std::endl;
+		close();
+		return m_status;
+	}
+	open(m_mapped->data(), m_mapped->size());
+	return m_status;
+}
+
+
+bool SmfEventStream::open(const uchar* data, size_t size) {
+	if ((m_mapped != NULL) && (data != m_mapped->data())) {
+		close();
+	}
+	m_cursors.clear();
+	m_heap.clear();
+	m_status = false;
+
+	int tracks = 0;
+	if (!readHeader(data, size, tracks)) {
+		return m_status;
+	}
+	const uchar* ptr = data + 14;
+	const uchar* end = data + size;
+	if (!findTracks(ptr, end, tracks)) {
+		m_cursors.clear();
+		return m_status;
+	}
+	m_status = true;
+	return rewind();
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::close -- Release the file (if any).
+//
+
+void SmfEventStream::close(void) {
+	if (m_mapped != NULL) {
+		delete m_mapped;
+		m_mapped = NULL;
+	}
+	m_cursors.clear();
+	m_heap.clear();
+	m_status = false;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::rewind -- Restart reading at the beginning of the file.
+//
+
+bool SmfEventStream::rewind(void) {
+	if (m_cursors.empty()) {
+		return false;
+	}
+	m_status         = true;
+	m_tempoTick      = 0;
+	m_tempoSeconds   = 0.0;
+	m_secondsPerTick = 60.0 / (120.0 * m_ticksPerQuarterNote);
+	m_tick           = 0;
+	m_seconds        = 0.0;
+	m_eventCount     = 0;
+	m_heap.clear();
+	m_decoder.m_rwstatus = true;
+
+	for (int i=0; i<(int)m_cursors.size(); i++) {
+		_TrackCursor& cursor = m_cursors[i];
+		cursor.ptr            = cursor.begin;
+		cursor.tick           = 0;
+		cursor.runningCommand = 0;
+		if (advance(cursor)) {
+			heapPush(i);
+		}
+	}
+	return m_status;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::next -- Read the next event of the file, in order of
+//    absolute ticks.  Events at the same tick are returned in order of
+//    their track number, and in file order within a track.  The tick,
+//    track, seconds and seq variables of the event are set (seq counts
+//    the events returned so far).  Returns false at the end of the file
+//    or if the data is invalid (in which case status() is false).
+//
+
+bool SmfEventStream::next(MidiEvent& event) {
+	if (!m_status || m_heap.empty()) {
+		return false;
+	}
+
+	int track = heapPop();
+	_TrackCursor& cursor = m_cursors[track];
+
+	event.clearVariables();
+	if (!m_decoder.extractMidiData(cursor.ptr, cursor.end, event,
+			cursor.runningCommand)) {
+		m_status = false;
+		return m_status;
+	}
+
+	m_tick    = cursor.tick;
+	m_seconds = m_tempoSeconds + (m_tick - m_tempoTick) * m_secondsPerTick;
+
+	event.tick    = m_tick;
+	event.track   = track;
+	event.seconds = m_seconds;
+	event.seq     = m_eventCount++;
+
+	if (event.isTempo()) {
+		m_tempoTick      = m_tick;
+		m_tempoSeconds   = m_seconds;
+		m_secondsPerTick = event.getTempoSPT(m_ticksPerQuarterNote);
+	}
+
+	if (!event.isEndOfTrack() && advance(cursor)) {
+		heapPush(track);
+	}
+
+	return m_status;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::isOpen -- Returns true if a file has been opened
+//    successfully.
+//
+
+bool SmfEventStream::isOpen(void) const {
+	return !m_cursors.empty();
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::status -- Returns false if an error occurred while
+//    opening or reading.
+//
+
+bool SmfEventStream::status(void) const {
+	return m_status;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::getTrackCount -- Number of MTrk chunks in the file.
+//
+
+int SmfEventStream::getTrackCount(void) const {
+	return (int)m_cursors.size();
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::getTicksPerQuarterNote -- Time base of the file.
+//
+
+int SmfEventStream::getTicksPerQuarterNote(void) const {
+	return m_ticksPerQuarterNote;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::getCurrentTick -- Absolute tick of the last event
+//    returned by next().
+//
+
+int SmfEventStream::getCurrentTick(void) const {
+	return m_tick;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::getCurrentSeconds -- Time in seconds of the last event
+//    returned by next().
+//
+
+double SmfEventStream::getCurrentSeconds(void) const {
+	return m_seconds;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::getEventCount -- Number of events returned by next()
+//    since the file was opened or rewound.
+//
+
+int SmfEventStream::getEventCount(void) const {
+	return m_eventCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+//////////////////////////////
+//
+// SmfEventStream::readHeader -- Check the MThd chunk and read the track
+//    count and time base.  The same files as in MidiFile::readSmf() are
+//    accepted.
+//
+
+bool SmfEventStream::readHeader(const uchar* data, size_t size, int& tracks) {
+	const uchar* ptr = data;
+	const uchar* end = data + size;
+
+	if ((size < 14) || (std::memcmp(ptr, "MThd", 4) != 0)) {
+		std::cerr << "Error: not a Standard MIDI File" << std::endl;
+		return false;
+	}
+	ptr += 4;
+
+	if (MidiFile::readBigEndian4Bytes(ptr, end) != 6) {
+		std::cerr << "Error: not a MIDI 1.0 Standard MIDI file" << std::endl;
+		return false;
+	}
+
+	int type = MidiFile::readBigEndian2Bytes(ptr, end);
+	if ((type != 0) && (type != 1)) {
+		std::cerr << "Error: cannot handle a type-" << type
+		     << " MIDI file" << std::endl;
+		return false;
+	}
+
+	tracks = MidiFile::readBigEndian2Bytes(ptr, end);
+	if ((type == 0) && (tracks != 1)) {
+		std::cerr << "Error: Type 0 MIDI file can only contain one track" << std::endl;
+		return false;
+	}
+
+	int division = MidiFile::readBigEndian2Bytes(ptr, end);
+	if (division >= 0x8000) {
+		int framespersecond = 255 - ((division >> 8) & 0x00ff) + 1;
+		int subframes       = division & 0x00ff;
+		m_ticksPerQuarterNote = framespersecond * subframes;
+	} else {
+		m_ticksPerQuarterNote = division;
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::findTracks -- Set up a cursor for each MTrk chunk.  The
+//    chunk sizes are used when they describe the file consistently.
+//    Otherwise the tracks are located by skipping over their events up
+//    to the end-of-track message, as MidiFile::readSmf() does.
+//
+
+bool SmfEventStream::findTracks(const uchar* ptr, const uchar* end, int tracks) {
+	_TrackCursor cursor;
+	cursor.tick = 0;
+	cursor.runningCommand = 0;
+
+	std::vector<std::pair<const uchar*, const uchar*>> chunks;
+	if (m_decoder.scanTrackChunks(ptr, end, tracks, chunks)) {
+		m_cursors.reserve(tracks);
+		for (int i=0; i<tracks; i++) {
+			cursor.begin = cursor.ptr = chunks[i].first;
+			cursor.end   = chunks[i].second;
+			m_cursors.push_back(cursor);
+		}
+		return true;
+	}
+
+	m_decoder.m_rwstatus = true;
+	for (int i=0; i<tracks; i++) {
+		if (!m_decoder.checkChunkId(ptr, end, "MTrk", " in track")) {
+			return false;
+		}
+		MidiFile::readBigEndian4Bytes(ptr, end);
+		cursor.begin = cursor.ptr = ptr;
+		if (!skipTrack(ptr, end)) {
+			return false;
+		}
+		cursor.end = ptr;
+		m_cursors.push_back(cursor);
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::skipTrack -- Move past the events of a track, up to and
+//    including its end-of-track message.
+//
+
+bool SmfEventStream::skipTrack(const uchar*& ptr, const uchar* end) {
+	MidiMessage message;
+	uchar runningCommand = 0;
+	while (true) {
+		m_decoder.readVLValue(ptr, end);
+		if (!m_decoder.status()) {
+			return false;
+		}
+		if (!m_decoder.extractMidiData(ptr, end, message, runningCommand)) {
+			return false;
+		}
+		if (message.isEndOfTrack()) {
+			return true;
+		}
+	}
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::advance -- Read the delta time of the next event in a
+//    track.  Returns false when the track has no more events.
+//
+
+bool SmfEventStream::advance(_TrackCursor& cursor) {
+	if (cursor.ptr >= cursor.end) {
+		return false;
+	}
+	cursor.tick += (int)m_decoder.readVLValue(cursor.ptr, cursor.end);
+	if (!m_decoder.status()) {
+		m_status = false;
+		return false;
+	}
+	return true;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::heapLess -- Ordering of the track cursors: by the tick
+//    of their next event, then by track number.
+//
+
+bool SmfEventStream::heapLess(int a, int b) const {
+	if (m_cursors[a].tick != m_cursors[b].tick) {
+		return m_cursors[a].tick < m_cursors[b].tick;
+	}
+	return a < b;
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::heapPush -- Add a track to the merge heap.
+//
+
+void SmfEventStream::heapPush(int track) {
+	m_heap.push_back(track);
+	std::push_heap(m_heap.begin(), m_heap.end(),
+			[this](int a, int b) { return heapLess(b, a); });
+}
+
+
+
+//////////////////////////////
+//
+// SmfEventStream::heapPop -- Remove and return the track with the
+//    earliest next event.
+//
+
+int SmfEventStream::heapPop(void) {
+	std::pop_heap(m_heap.begin(), m_heap.end(),
+			[this](int a, int b) { return heapLess(b, a); });
+	int output = m_heap.back();
+	m_heap.pop_back();
+	return output;
+}
+
+
+} // end of namespace smf
+
+
+
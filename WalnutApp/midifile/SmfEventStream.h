@@ -0,0 +1,110 @@
+//
+// Creation Date: Sat Oct 17 2026
+// Filename:      midifile/include/SmfEventStream.h
+// Syntax:        C++11
+// vim:           ts=3 noexpandtab
+//
+// Description:   Pull-style reader which returns the events of a Standard
+//                MIDI File in time order across all tracks, without
+//                storing the tracks in memory.  One cursor is kept per
+//                MTrk chunk and the cursors are merged by their next
+//                tick.  Times in seconds are calculated from the tempo
+//                meta messages as the events are read.
+//
+
+#ifndef _SMFEVENTSTREAM_H_INCLUDED
+#define _SMFEVENTSTREAM_H_INCLUDED
+
+#include "MidiFile.h"
+
+#include <string>
+#include <vector>
+
+namespace smf {
+
+class MappedFile;
+
+class SmfEventStream {
+	public:
+		                SmfEventStream         (void);
+		                SmfEventStream         (const std::string& filename);
+		               ~SmfEventStream         ();
+
+		                SmfEventStream         (const SmfEventStream& other) = delete;
+		SmfEventStream& operator=              (const SmfEventStream& other) = delete;
+
+		bool            open                   (const std::string& filename);
+		bool            open                   (const uchar* data, size_t size);
+		void            close                  (void);
+		bool            rewind                 (void);
+		bool            next                   (MidiEvent& event);
+
+		bool            isOpen                 (void) const;
+		bool            status                 (void) const;
+		int             getTrackCount          (void) const;
+		int             getTicksPerQuarterNote (void) const;
+		int             getCurrentTick         (void) const;
+		double          getCurrentSeconds      (void) const;
+		int             getEventCount          (void) const;
+
+	protected:
+		struct _TrackCursor {
+			const uchar* begin;           // first byte of the MTrk data
+			const uchar* end;             // end of the MTrk data
+			const uchar* ptr;             // next event (after its delta time)
+			int          tick;            // absolute tick of the next event
+			uchar        runningCommand;  // running status of the track
+		};
+
+		// m_mapped == Mapping of the file given to open(filename).  NULL
+		// if the stream reads from a caller-owned buffer.
+		MappedFile* m_mapped = NULL;
+
+		// m_cursors == Read position in each track.
+		std::vector<_TrackCursor> m_cursors;
+
+		// m_heap == Indexes of the unfinished tracks, as a min-heap
+		// ordered by the next tick (then by track number).
+		std::vector<int> m_heap;
+
+		// m_decoder == Used for decoding the message bytes, so that the
+		// stream accepts exactly the data which MidiFile::read() accepts.
+		MidiFile m_decoder;
+
+		// m_ticksPerQuarterNote == Time base from the header.
+		int m_ticksPerQuarterNote = 120;
+
+		// m_tempoTick, m_tempoSeconds, m_secondsPerTick == The last tempo
+		// change.  Event times are extrapolated from it.
+		int    m_tempoTick      = 0;
+		double m_tempoSeconds   = 0.0;
+		double m_secondsPerTick = 0.0;
+
+		// m_tick, m_seconds == Time of the last event returned by next().
+		int    m_tick    = 0;
+		double m_seconds = 0.0;
+
+		// m_eventCount == Number of events returned since open/rewind.
+		int m_eventCount = 0;
+
+		// m_status == False if the data could not be parsed.
+		bool m_status = false;
+
+	private:
+		bool            readHeader             (const uchar* data, size_t size,
+		                                        int& tracks);
+		bool            findTracks             (const uchar* ptr, const uchar* end,
+		                                        int tracks);
+		bool            skipTrack              (const uchar*& ptr, const uchar* end);
+		bool            advance                (_TrackCursor& cursor);
+		bool            heapLess               (int a, int b) const;
+		void            heapPush               (int track);
+		int             heapPop                (void);
+};
+
+} // end of namespace smf
+
+#endif /* _SMFEVENTSTREAM_H_INCLUDED */
+
+
+
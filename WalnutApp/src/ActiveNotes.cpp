@@ -0,0 +1,107 @@
+#include "ActiveNotes.h"
+
+#include <algorithm>
+
+//
+// Interface
+//
+
+void ActiveNotes::Update(
+    const NoteTable & _Notes,
+    float             _Time,
+    float             _HalfWindow
+  )
+{
+  const bool IsSliding = m_IsValid && _Time >= m_Time && _HalfWindow == m_HalfWindow;
+
+  m_Time       = _Time;
+  m_HalfWindow = _HalfWindow;
+
+  if (IsSliding)
+    Advance(_Notes);
+  else
+    Rebuild(_Notes);
+}
+
+void ActiveNotes::Invalidate()
+{
+  m_IsValid = false;
+}
+
+const std::vector<std::size_t> & ActiveNotes::GetTrackNotes(
+    int _TrackIdx
+  ) const
+{
+  return m_TrackNotes[_TrackIdx];
+}
+
+//
+// Service
+//
+
+void ActiveNotes::Rebuild(
+    const NoteTable & _Notes
+  )
+{
+  const auto TrackCount = _Notes.GetTrackCount();
+
+  m_TrackNotes.resize(TrackCount);
+  m_NextNote.resize(TrackCount);
+
+  for (int TrackIdx = 0; TrackIdx < TrackCount; ++TrackIdx)
+  {
+    const auto TrackStart = _Notes.Start.begin() + _Notes.GetTrackBegin(TrackIdx);
+    const auto TrackEnd   = _Notes.Start.begin() + _Notes.GetTrackEnd(TrackIdx);
+
+    const std::size_t FirstNote = std::lower_bound(TrackStart, TrackEnd, m_Time - m_HalfWindow) - _Notes.Start.begin();
+    const std::size_t NextNote  = std::upper_bound(TrackStart, TrackEnd, m_Time + m_HalfWindow) - _Notes.Start.begin();
+
+    auto & Active = m_TrackNotes[TrackIdx];
+    Active.clear();
+
+    for (auto NoteIdx = FirstNote; NoteIdx < NextNote; ++NoteIdx)
+      if (!IsRetired(_Notes, NoteIdx))
+        Active.push_back(NoteIdx);
+
+    m_NextNote[TrackIdx] = NextNote;
+  }
+
+  m_IsValid = true;
+}
+
+void ActiveNotes::Advance(
+    const NoteTable & _Notes
+  )
+{
+  for (int TrackIdx = 0; TrackIdx < static_cast<int>(m_TrackNotes.size()); ++TrackIdx)
+  {
+    auto & Active = m_TrackNotes[TrackIdx];
+
+    Active.erase(
+        std::remove_if(Active.begin(), Active.end(), [&](std::size_t _NoteIdx) { return IsRetired(_Notes, _NoteIdx); }),
+        Active.end()
+      );
+
+    const auto TrackEnd = _Notes.GetTrackEnd(TrackIdx);
+
+    auto & Next = m_NextNote[TrackIdx];
+
+    for (; Next < TrackEnd && _Notes.Start[Next] <= m_Time + m_HalfWindow; ++Next)
+      if (!IsRetired(_Notes, Next))
+        Active.push_back(Next);
+  }
+}
+
+bool ActiveNotes::IsRetired(
+    const NoteTable & _Notes,
+    std::size_t       _NoteIdx
+  ) const
+{
+  const auto Start = _Notes.Start[_NoteIdx];
+
+  if (Start < m_Time - m_HalfWindow)
+    return true;
+
+  // Same test as the fade-out of the animation
+  return Start <= m_Time && (m_Time - Start) / _Notes.Duration[_NoteIdx] >= 1;
+}
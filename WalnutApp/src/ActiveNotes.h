@@ -0,0 +1,56 @@
+#pragma once
+
+#include "NoteTable.h"
+
+#include <cstddef>
+#include <vector>
+
+//
+// Notes of each track that the animation view has to draw at the current
+// time: notes which started at most _HalfWindow seconds ago or start
+// within the next _HalfWindow seconds, until they have fully faded out.
+// While time moves forward the window slides, adding notes as they enter
+// the look-ahead and retiring faded ones. Anything else rebuilds it with
+// binary searches.
+//
+class ActiveNotes
+{
+public: // Interface
+
+  void Update(
+      const NoteTable & _Notes,
+      float             _Time,
+      float             _HalfWindow
+    );
+
+  // Forces the next Update to rebuild the window (new song, seek, restart)
+  void Invalidate();
+
+  // Note indices of the track in start order
+  const std::vector<std::size_t> & GetTrackNotes(
+      int _TrackIdx
+    ) const;
+
+private: // Service
+
+  void Rebuild(
+      const NoteTable & _Notes
+    );
+
+  void Advance(
+      const NoteTable & _Notes
+    );
+
+  bool IsRetired(
+      const NoteTable & _Notes,
+      std::size_t       _NoteIdx
+    ) const;
+
+private: // Members
+
+  std::vector<std::vector<std::size_t>> m_TrackNotes;
+  std::vector<std::size_t>              m_NextNote;
+  float                                 m_Time       = 0;
+  float                                 m_HalfWindow = 0;
+  bool                                  m_IsValid    = false;
+};
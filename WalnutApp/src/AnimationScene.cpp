@@ -0,0 +1,132 @@
+#include "AnimationScene.h"
+
+#include <vector>
+
+//
+// Service
+//
+
+namespace
+{
+
+struct DrawTrackSetup
+{
+  FigureBatch::Shape Shape;
+  ImU32              Color;
+};
+
+const std::vector<DrawTrackSetup> TRACK_SETUPS {
+    { FigureBatch::Shape::Circle,             0x12B0FF },
+    { FigureBatch::Shape::Triangle,           0xA3C54D },
+    { FigureBatch::Shape::Square,             0xA3DAEE },
+    { FigureBatch::Shape::Rhombus,            0x9CACE9 },
+    { FigureBatch::Shape::Pentagon,           0x3F82FE },
+    { FigureBatch::Shape::Hexagon,            0x92780F },
+    { FigureBatch::Shape::TriangleUpsideDown, 0x729CB5 },
+    { FigureBatch::Shape::Circle,             0xA88F7A },
+    { FigureBatch::Shape::Triangle,           0x3854A2 },
+    { FigureBatch::Shape::Square,             0x8C5633 },
+    { FigureBatch::Shape::Rhombus,            0x465D57 },
+    { FigureBatch::Shape::Pentagon,           0x7B6171 },
+    { FigureBatch::Shape::Hexagon,            0x3F39D1 },
+    { FigureBatch::Shape::TriangleUpsideDown, 0xF2F0EE },
+    { FigureBatch::Shape::Circle,             0x9B9CA0 },
+    { FigureBatch::Shape::Triangle,           0x4C3D3B },
+  };
+
+} // namespace
+
+//
+// Interface
+//
+
+void AnimationScene::Invalidate()
+{
+  m_ActiveNotes.Invalidate();
+}
+
+void AnimationScene::Draw(
+    ImDrawList     * _DrawList,
+    const Song     & _Song,
+    const Settings & _Settings,
+    float            _Time,
+    ImVec2           _ScreenPos,
+    ImVec2           _Size
+  )
+{
+  const auto HalfScreenTime = _Size.x / (2 * _Settings.PixelPerSec);
+  const auto TrackOffset    = _Time - HalfScreenTime;
+  const auto NoteRange      = _Settings.MaxNote - _Settings.MinNote + 1;
+  const auto NoteHeight     = _Size.y / (NoteRange + 1);
+
+  const auto & Notes = _Song.Notes;
+
+  m_ActiveNotes.Update(Notes, _Time, HalfScreenTime);
+
+  m_Layout.Clear();
+
+  int DrawSetupIdx = 0;
+
+  for (int TrackIdx = 0; TrackIdx < _Song.GetTrackCount(); ++TrackIdx)
+  {
+    if (!_Song.TrackHasNote[TrackIdx])
+      continue;
+
+    const auto & DrawSetup = TRACK_SETUPS.at(DrawSetupIdx++ % TRACK_SETUPS.size());
+
+    for (const auto NoteIdx : m_ActiveNotes.GetTrackNotes(TrackIdx))
+      m_Layout.Add(
+          Notes.Start[NoteIdx],
+          Notes.Duration[NoteIdx],
+          Notes.Velocity[NoteIdx],
+          Notes.Key[NoteIdx],
+          DrawSetup.Color,
+          DrawSetup.Shape
+        );
+  }
+
+  FigureLayout::Frame Frame;
+  Frame.ScreenPos      = _ScreenPos;
+  Frame.Width          = _Size.x;
+  Frame.Time           = _Time;
+  Frame.HalfScreenTime = HalfScreenTime;
+  Frame.TrackOffset    = TrackOffset;
+  Frame.PixelPerSec    = _Settings.PixelPerSec;
+  Frame.FigureHeight   = _Settings.FigureHeight;
+  Frame.MaxNote        = _Settings.MaxNote;
+  Frame.NoteHeight     = NoteHeight;
+
+  m_Layout.Compute(Frame);
+
+  for (std::size_t FigureIdx = 0; FigureIdx < m_Layout.GetCount(); ++FigureIdx)
+    m_Figures.Add(
+        m_Layout.Shape[FigureIdx],
+        ImVec2(m_Layout.X[FigureIdx], m_Layout.Y[FigureIdx]),
+        m_Layout.Size[FigureIdx],
+        m_Layout.Filled[FigureIdx],
+        m_Layout.Color[FigureIdx]
+      );
+
+  m_Figures.Flush(_DrawList);
+
+  if (_Settings.RenderGrid)
+  {
+    const auto PlayheadX = _ScreenPos.x + (_Time - TrackOffset) * _Settings.PixelPerSec;
+
+    _DrawList->AddLine(
+      ImVec2(PlayheadX, _ScreenPos.y),
+      ImVec2(PlayheadX, _ScreenPos.y + _Size.y),
+      0xff1111ff
+    );
+
+    for (auto i = _Settings.MinNote; i <= _Settings.MaxNote; ++i)
+    {
+      const auto y = _ScreenPos.y + (_Settings.MaxNote - i + 1) * NoteHeight;
+
+      _DrawList->AddLine(
+        ImVec2(_ScreenPos.x, y), ImVec2(_ScreenPos.x + _Size.x, y),
+        0xff1111ff
+      );
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ActiveNotes.h"
+#include "FigureBatch.h"
+#include "FigureLayout.h"
+#include "Song.h"
+#include "imgui.h"
+
+//
+// Contents of the animation view at a given time, drawn into any draw
+// list. The live view draws into its ImGui window, the offline renderer
+// keeps one scene per worker and draws into its own lists.
+//
+class AnimationScene
+{
+public: // Types
+
+  struct Settings
+  {
+    float MinNote      = -1;
+    float MaxNote      = -1;
+    float FigureHeight = 100;
+    float PixelPerSec  = 300;
+    bool  RenderGrid   = false;
+  };
+
+public: // Interface
+
+  // Forces a rebuild of the active notes (new song, seek, restart)
+  void Invalidate();
+
+  // Draws the figures of _Song at _Time into the _Size rect at _ScreenPos
+  void Draw(
+      ImDrawList     * _DrawList,
+      const Song     & _Song,
+      const Settings & _Settings,
+      float            _Time,
+      ImVec2           _ScreenPos,
+      ImVec2           _Size
+    );
+
+private: // Members
+
+  ActiveNotes  m_ActiveNotes;
+  FigureLayout m_Layout;
+  FigureBatch  m_Figures;
+};
@@ -0,0 +1,229 @@
+#include "AudioCache.h"
+#include "CachedAudio.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Synthesizer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+//
+// Service
+//
+
+namespace
+{
+
+constexpr char     ENTRY_MAGIC[4] = { 'W', 'M', 'A', 'C' };
+constexpr uint32_t ENTRY_VERSION  = 1;
+constexpr char     ENTRY_SUFFIX[] = ".pcm";
+
+struct EntryHeader
+{
+  char     Magic[4];
+  uint32_t Version;
+  uint64_t Key;
+  uint64_t FrameCount;
+  uint32_t SampleRate;
+  uint32_t ChannelCount;
+};
+
+} // namespace
+
+//
+// Construction
+//
+
+AudioCache::AudioCache(
+    const std::string & _Directory,
+    uint64_t            _MaxSize
+  )
+  : m_Directory(_Directory)
+  , m_MaxSize(_MaxSize)
+{
+}
+
+//
+// Interface
+//
+
+bool AudioCache::MakeKey(
+    const std::string & _MidiPath,
+    uint64_t          & _Key
+  )
+{
+  smf::MappedFile Midi(_MidiPath);
+
+  if (!Midi.isOpen())
+    return false;
+
+  // Anything which changes the rendered sound belongs to the key
+  const uint32_t Settings[] =
+  {
+    Synthesizer::VERSION,
+    Synthesizer::SAMPLE_RATE,
+    Synthesizer::CHANNEL_COUNT,
+    Synthesizer::MAX_VOICES
+  };
+
+  _Key = HashBytes(Midi.data(), Midi.size());
+  _Key = HashBytes(Settings, sizeof(Settings), _Key);
+
+  return true;
+}
+
+bool AudioCache::Load(
+    uint64_t      _Key,
+    CachedAudio & _Audio
+  ) const
+{
+  const auto EntryPath = GetEntryPath(_Key);
+
+  auto Entry = std::make_unique<smf::MappedFile>(EntryPath);
+
+  if (!Entry->isOpen() || Entry->size() < sizeof(EntryHeader))
+    return false;
+
+  EntryHeader Header;
+  std::memcpy(&Header, Entry->data(), sizeof(Header));
+
+  const auto FrameSize = sizeof(int16_t) * Synthesizer::CHANNEL_COUNT;
+
+  if (std::memcmp(Header.Magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 ||
+      Header.Version      != ENTRY_VERSION                             ||
+      Header.Key          != _Key                                      ||
+      Header.SampleRate   != Synthesizer::SAMPLE_RATE                  ||
+      Header.ChannelCount != Synthesizer::CHANNEL_COUNT                ||
+      Header.FrameCount   != (Entry->size() - sizeof(EntryHeader)) / FrameSize)
+    return false;
+
+  // The modification time orders the entries for trimming
+  std::error_code Error;
+  std::filesystem::last_write_time(EntryPath, std::filesystem::file_time_type::clock::now(), Error);
+
+  const auto * Samples = reinterpret_cast<const int16_t *>(Entry->data() + sizeof(EntryHeader));
+
+  _Audio.Assign(std::move(Entry), Samples, Header.FrameCount);
+
+  return true;
+}
+
+bool AudioCache::Store(
+    uint64_t        _Key,
+    const int16_t * _Samples,
+    uint64_t        _FrameCount
+  ) const
+{
+  std::error_code Error;
+  std::filesystem::create_directories(m_Directory, Error);
+
+  if (Error)
+    return false;
+
+  EntryHeader Header;
+  std::memcpy(Header.Magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+  Header.Version      = ENTRY_VERSION;
+  Header.Key          = _Key;
+  Header.FrameCount   = _FrameCount;
+  Header.SampleRate   = Synthesizer::SAMPLE_RATE;
+  Header.ChannelCount = Synthesizer::CHANNEL_COUNT;
+
+  // Written under a temporary name and renamed, so a reader never sees
+  // a partially written entry
+  const auto EntryPath = GetEntryPath(_Key);
+  const auto TempPath  = EntryPath + ".tmp";
+
+  {
+    std::ofstream Output(TempPath, std::ios::binary | std::ios::trunc);
+
+    Output.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+    Output.write(reinterpret_cast<const char *>(_Samples), _FrameCount * Synthesizer::CHANNEL_COUNT * sizeof(int16_t));
+
+    if (!Output)
+    {
+      Output.close();
+      std::filesystem::remove(TempPath, Error);
+      return false;
+    }
+  }
+
+  std::filesystem::rename(TempPath, EntryPath, Error);
+
+  if (Error)
+    return false;
+
+  Trim(EntryPath);
+
+  return true;
+}
+
+//
+// Service
+//
+
+void AudioCache::Trim(
+    const std::string & _KeepPath
+  ) const
+{
+  struct Entry
+  {
+    std::filesystem::path           Path;
+    std::filesystem::file_time_type UsedTime;
+    uint64_t                        Size;
+  };
+
+  std::vector<Entry> Entries;
+  uint64_t           TotalSize = 0;
+  std::error_code    Error;
+
+  for (const auto & DirectoryEntry : std::filesystem::directory_iterator(m_Directory, Error))
+  {
+    if (!DirectoryEntry.is_regular_file(Error) || DirectoryEntry.path().extension() != ENTRY_SUFFIX)
+      continue;
+
+    Entry Item;
+    Item.Path     = DirectoryEntry.path();
+    Item.UsedTime = DirectoryEntry.last_write_time(Error);
+    Item.Size     = DirectoryEntry.file_size(Error);
+
+    if (Error)
+      continue;
+
+    TotalSize += Item.Size;
+    Entries.push_back(std::move(Item));
+  }
+
+  std::sort(Entries.begin(), Entries.end(), [](const Entry & _Left, const Entry & _Right)
+    {
+      return _Left.UsedTime < _Right.UsedTime;
+    });
+
+  // An entry still mapped for playback cannot be removed on Windows, it
+  // stays until a later trim
+  for (const auto & Item : Entries)
+  {
+    if (TotalSize <= m_MaxSize)
+      break;
+
+    if (Item.Path == std::filesystem::path(_KeepPath))
+      continue;
+
+    if (std::filesystem::remove(Item.Path, Error))
+      TotalSize -= Item.Size;
+  }
+}
+
+std::string AudioCache::GetEntryPath(
+    uint64_t _Key
+  ) const
+{
+  char Name[17];
+  std::snprintf(Name, sizeof(Name), "%016llx", static_cast<unsigned long long>(_Key));
+
+  return (std::filesystem::path(m_Directory) / (Name + std::string(ENTRY_SUFFIX))).string();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class CachedAudio;
+
+//
+// Directory of rendered song audio, one file per entry. Entries are named
+// by a hash of the MIDI file content and the synthesizer settings, so a
+// song renders once however often it is selected, and renamed or copied
+// MIDI files share their entry. The least recently used entries are
+// removed when the directory outgrows its size cap.
+//
+class AudioCache
+{
+public: // Constants
+
+  static constexpr uint64_t DEFAULT_MAX_SIZE = 2ull << 30;  // bytes
+
+public: // Construction
+
+  AudioCache(
+      const std::string & _Directory,
+      uint64_t            _MaxSize = DEFAULT_MAX_SIZE
+    );
+
+public: // Interface
+
+  // Returns false if the MIDI file cannot be read
+  static bool MakeKey(
+      const std::string & _MidiPath,
+      uint64_t          & _Key
+    );
+
+  // Maps the entry for playback and marks it as recently used
+  bool Load(
+      uint64_t      _Key,
+      CachedAudio & _Audio
+    ) const;
+
+  // Writes _FrameCount interleaved 16-bit stereo frames to a new entry,
+  // then trims the directory to the size cap
+  bool Store(
+      uint64_t        _Key,
+      const int16_t * _Samples,
+      uint64_t        _FrameCount
+    ) const;
+
+private: // Service
+
+  // Removes the least recently used entries, except _KeepPath
+  void Trim(
+      const std::string & _KeepPath
+    ) const;
+
+  std::string GetEntryPath(
+      uint64_t _Key
+    ) const;
+
+private: // Members
+
+  std::string m_Directory;
+  uint64_t    m_MaxSize;
+};
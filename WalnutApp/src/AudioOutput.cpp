@@ -0,0 +1,176 @@
+#include "AudioOutput.h"
+#include "windows.h"
+
+#include <algorithm>
+#include <cstdint>
+
+//
+// Types
+//
+
+struct AudioOutput::Device
+{
+  HWAVEOUT             Handle = nullptr;
+  HANDLE               Event  = nullptr;
+  WAVEHDR              Headers[BUFFER_COUNT] {};
+  std::vector<int16_t> Samples[BUFFER_COUNT];
+  DWORD                LastPosition = 0;
+  uint64_t             Wraps        = 0;  // of the 32 bit sample position
+};
+
+//
+// Construction
+//
+
+AudioOutput::AudioOutput()
+  : m_Device(std::make_unique<Device>())
+{
+}
+
+AudioOutput::~AudioOutput()
+{
+  Stop();
+}
+
+//
+// AudioSink
+//
+
+bool AudioOutput::Start(
+    int            _SampleRate,
+    RenderCallback _Callback
+  )
+{
+  Stop();
+
+  WAVEFORMATEX Format = { 0 };
+  Format.wFormatTag      = WAVE_FORMAT_PCM;
+  Format.nChannels       = 2;
+  Format.nSamplesPerSec  = _SampleRate;
+  Format.wBitsPerSample  = 16;
+  Format.nBlockAlign     = Format.nChannels * Format.wBitsPerSample / 8;
+  Format.nAvgBytesPerSec = Format.nSamplesPerSec * Format.nBlockAlign;
+
+  auto & Device = *m_Device;
+
+  Device.Event = CreateEventA(NULL, FALSE, FALSE, NULL);
+
+  if (waveOutOpen(&Device.Handle, WAVE_MAPPER, &Format, reinterpret_cast<DWORD_PTR>(Device.Event), 0, CALLBACK_EVENT) != MMSYSERR_NOERROR)
+  {
+    CloseHandle(Device.Event);
+    Device.Handle = nullptr;
+    Device.Event  = nullptr;
+    return false;
+  }
+
+  m_Callback      = std::move(_Callback);
+  m_StopRequested = false;
+
+  Device.LastPosition = 0;
+  Device.Wraps        = 0;
+
+  for (int BufferIdx = 0; BufferIdx < BUFFER_COUNT; ++BufferIdx)
+  {
+    auto & Samples = Device.Samples[BufferIdx];
+    auto & Header  = Device.Headers[BufferIdx];
+
+    Samples.resize(BUFFER_FRAMES * 2);
+
+    Header = { 0 };
+    Header.lpData         = reinterpret_cast<LPSTR>(Samples.data());
+    Header.dwBufferLength = static_cast<DWORD>(Samples.size() * sizeof(int16_t));
+
+    waveOutPrepareHeader(Device.Handle, &Header, sizeof(WAVEHDR));
+    FillBuffer(BufferIdx);
+  }
+
+  m_Feeder = std::async(std::launch::async, &AudioOutput::FeedLoop, this);
+
+  return true;
+}
+
+void AudioOutput::Stop()
+{
+  auto & Device = *m_Device;
+
+  if (Device.Handle == nullptr)
+    return;
+
+  m_StopRequested = true;
+
+  if (m_Feeder.valid())
+    m_Feeder.wait();
+
+  waveOutReset(Device.Handle);
+
+  for (auto & Header : Device.Headers)
+    waveOutUnprepareHeader(Device.Handle, &Header, sizeof(WAVEHDR));
+
+  waveOutClose(Device.Handle);
+  CloseHandle(Device.Event);
+
+  Device.Handle = nullptr;
+  Device.Event  = nullptr;
+}
+
+bool AudioOutput::IsPlaying() const
+{
+  return m_Device->Handle != nullptr;
+}
+
+uint64_t AudioOutput::GetPlayedFrames() const
+{
+  auto & Device = *m_Device;
+
+  if (Device.Handle == nullptr)
+    return 0;
+
+  MMTIME Time = { 0 };
+  Time.wType = TIME_SAMPLES;
+
+  if (waveOutGetPosition(Device.Handle, &Time, sizeof(MMTIME)) != MMSYSERR_NOERROR || Time.wType != TIME_SAMPLES)
+    return (Device.Wraps << 32) + Device.LastPosition;
+
+  // The position wraps after a day of playback at 48 kHz
+  if (Time.u.sample < Device.LastPosition)
+    ++Device.Wraps;
+
+  Device.LastPosition = Time.u.sample;
+
+  return (Device.Wraps << 32) + Device.LastPosition;
+}
+
+//
+// Service
+//
+
+void AudioOutput::FillBuffer(
+    int _BufferIdx
+  )
+{
+  auto & Device  = *m_Device;
+  auto & Samples = Device.Samples[_BufferIdx];
+
+  m_Mix.resize(Samples.size());
+  m_Callback(m_Mix.data(), BUFFER_FRAMES);
+
+  for (std::size_t SampleIdx = 0; SampleIdx < Samples.size(); ++SampleIdx)
+    Samples[SampleIdx] = static_cast<int16_t>(std::clamp(m_Mix[SampleIdx], -1.0f, 1.0f) * 32767);
+
+  waveOutWrite(Device.Handle, &Device.Headers[_BufferIdx], sizeof(WAVEHDR));
+}
+
+void AudioOutput::FeedLoop()
+{
+  auto & Device = *m_Device;
+
+  while (!m_StopRequested)
+  {
+    WaitForSingleObject(Device.Event, 50);
+
+    // The device sets WHDR_DONE on played buffers until they are written again
+    for (int BufferIdx = 0; BufferIdx < BUFFER_COUNT && !m_StopRequested; ++BufferIdx)
+      if (Device.Headers[BufferIdx].dwFlags & WHDR_DONE)
+        FillBuffer(BufferIdx);
+  }
+}
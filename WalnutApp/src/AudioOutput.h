@@ -0,0 +1,63 @@
+#pragma once
+
+#include "AudioSink.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
+//
+// Streams audio to the default output device. The device is fed from a
+// few short buffers, each refilled by the render callback on a background
+// thread as soon as the device has played it, so playback starts as soon
+// as the first buffer is rendered.
+//
+class AudioOutput : public AudioSink
+{
+public: // Constants
+
+  static constexpr int         BUFFER_COUNT  = 4;
+  static constexpr std::size_t BUFFER_FRAMES = 1024;
+
+public: // Construction
+
+  AudioOutput();
+
+  ~AudioOutput() override;
+
+public: // AudioSink
+
+  bool Start(
+      int            _SampleRate,
+      RenderCallback _Callback
+    ) override;
+
+  void Stop() override;
+
+  bool IsPlaying() const override;
+
+  uint64_t GetPlayedFrames() const override;
+
+private: // Types
+
+  struct Device;
+
+private: // Service
+
+  void FillBuffer(
+      int _BufferIdx
+    );
+
+  void FeedLoop();
+
+private: // Members
+
+  std::unique_ptr<Device> m_Device;
+  RenderCallback          m_Callback;
+  std::vector<float>      m_Mix;
+  std::future<void>       m_Feeder;
+  std::atomic<bool>       m_StopRequested { false };
+};
@@ -0,0 +1,94 @@
+#include "AudioRingBuffer.h"
+
+#include <algorithm>
+
+//
+// Construction
+//
+
+AudioRingBuffer::AudioRingBuffer(
+    std::size_t _FrameCapacity,
+    int         _ChannelCount
+  )
+  : m_ChannelCount(_ChannelCount)
+{
+  std::size_t Capacity = 1;
+
+  while (Capacity < _FrameCapacity)
+    Capacity *= 2;
+
+  m_Samples.resize(Capacity * _ChannelCount);
+  m_FrameMask = Capacity - 1;
+}
+
+//
+// Interface
+//
+
+std::size_t AudioRingBuffer::Write(
+    const float * _Frames,
+    std::size_t   _FrameCount
+  )
+{
+  const auto WriteFrame = m_WriteFrame.load(std::memory_order_relaxed);
+  const auto ReadFrame  = m_ReadFrame.load(std::memory_order_acquire);
+
+  const auto FrameCount = std::min<std::size_t>(_FrameCount, GetFrameCapacity() - static_cast<std::size_t>(WriteFrame - ReadFrame));
+
+  // At most two copies, before and after the end of the ring
+  const auto Begin = static_cast<std::size_t>(WriteFrame) & m_FrameMask;
+  const auto First = std::min(FrameCount, GetFrameCapacity() - Begin);
+
+  std::copy(_Frames, _Frames + First * m_ChannelCount, m_Samples.begin() + Begin * m_ChannelCount);
+  std::copy(_Frames + First * m_ChannelCount, _Frames + FrameCount * m_ChannelCount, m_Samples.begin());
+
+  m_WriteFrame.store(WriteFrame + FrameCount, std::memory_order_release);
+
+  return FrameCount;
+}
+
+std::size_t AudioRingBuffer::Read(
+    float       * _Frames,
+    std::size_t   _FrameCount
+  )
+{
+  const auto ReadFrame  = m_ReadFrame.load(std::memory_order_relaxed);
+  const auto WriteFrame = m_WriteFrame.load(std::memory_order_acquire);
+
+  const auto FrameCount = std::min<std::size_t>(_FrameCount, static_cast<std::size_t>(WriteFrame - ReadFrame));
+
+  const auto Begin = static_cast<std::size_t>(ReadFrame) & m_FrameMask;
+  const auto First = std::min(FrameCount, GetFrameCapacity() - Begin);
+
+  std::copy(m_Samples.begin() + Begin * m_ChannelCount, m_Samples.begin() + (Begin + First) * m_ChannelCount, _Frames);
+  std::copy(m_Samples.begin(), m_Samples.begin() + (FrameCount - First) * m_ChannelCount, _Frames + First * m_ChannelCount);
+
+  m_ReadFrame.store(ReadFrame + FrameCount, std::memory_order_release);
+
+  return FrameCount;
+}
+
+void AudioRingBuffer::Reset()
+{
+  m_WriteFrame = 0;
+  m_ReadFrame  = 0;
+}
+
+std::size_t AudioRingBuffer::GetReadableFrames() const
+{
+  // Read first, it can only grow up to the write position loaded after it
+  const auto ReadFrame  = m_ReadFrame.load(std::memory_order_acquire);
+  const auto WriteFrame = m_WriteFrame.load(std::memory_order_acquire);
+
+  return static_cast<std::size_t>(WriteFrame - ReadFrame);
+}
+
+std::size_t AudioRingBuffer::GetWritableFrames() const
+{
+  return GetFrameCapacity() - GetReadableFrames();
+}
+
+std::size_t AudioRingBuffer::GetFrameCapacity() const
+{
+  return m_FrameMask + 1;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// Lock-free ring of interleaved audio frames between one producer thread
+// and one consumer thread. Each side only moves its own position, so Write
+// and Read never wait; they transfer as many frames as fit or are there.
+//
+class AudioRingBuffer
+{
+public: // Construction
+
+  // _FrameCapacity is rounded up to a power of two
+  AudioRingBuffer(
+      std::size_t _FrameCapacity,
+      int         _ChannelCount
+    );
+
+public: // Interface
+
+  // Producer side, returns the number of frames written
+  std::size_t Write(
+      const float * _Frames,
+      std::size_t   _FrameCount
+    );
+
+  // Consumer side, returns the number of frames read
+  std::size_t Read(
+      float       * _Frames,
+      std::size_t   _FrameCount
+    );
+
+  // Drops all frames. Neither side may be running
+  void Reset();
+
+  std::size_t GetReadableFrames() const;
+
+  std::size_t GetWritableFrames() const;
+
+  std::size_t GetFrameCapacity() const;
+
+private: // Members
+
+  std::vector<float>    m_Samples;
+  std::size_t           m_FrameMask;
+  int                   m_ChannelCount;
+  std::atomic<uint64_t> m_WriteFrame { 0 };  // total frames written
+  std::atomic<uint64_t> m_ReadFrame  { 0 };  // total frames read
+};
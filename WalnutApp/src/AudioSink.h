@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+//
+// Destination of a played audio stream. A sink pulls frames from the render
+// callback at the pace it plays them, from its own thread.
+//
+class AudioSink
+{
+public: // Types
+
+  // Fills _FrameCount frames of interleaved stereo floats in [-1, 1]
+  using RenderCallback = std::function<void(float * _Output, std::size_t _FrameCount)>;
+
+public: // Construction
+
+  virtual ~AudioSink() = default;
+
+public: // Interface
+
+  // Stops previous playback and starts calling _Callback. Returns false if
+  // the sink cannot be opened
+  virtual bool Start(
+      int            _SampleRate,
+      RenderCallback _Callback
+    ) = 0;
+
+  virtual void Stop() = 0;
+
+  virtual bool IsPlaying() const = 0;
+
+  // Frames played out since Start, as counted by the device. The count may
+  // advance in steps but never runs ahead of what was heard
+  virtual uint64_t GetPlayedFrames() const = 0;
+};
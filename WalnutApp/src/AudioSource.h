@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+//
+// Stream of song audio which can start at any time of the song.
+//
+class AudioSource
+{
+public: // Construction
+
+  virtual ~AudioSource() = default;
+
+public: // Interface
+
+  // Restarts the stream at _Time seconds of the song
+  virtual void Start(
+      double _Time
+    ) = 0;
+
+  // Renders the next _FrameCount frames as interleaved stereo floats
+  virtual void Render(
+      float       * _Output,
+      std::size_t   _FrameCount
+    ) = 0;
+};
@@ -0,0 +1,159 @@
+#include "AudioStream.h"
+#include "AudioSource.h"
+#include "Synthesizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+//
+// Construction
+//
+
+AudioStream::AudioStream()
+  : m_Ring(RING_FRAMES, Synthesizer::CHANNEL_COUNT)
+{
+}
+
+AudioStream::~AudioStream()
+{
+  Stop();
+}
+
+//
+// Interface
+//
+
+bool AudioStream::Start(
+    AudioSource & _Source,
+    double        _Time,
+    AudioSink   & _Sink
+  )
+{
+  Stop();
+
+  _Source.Start(_Time);
+
+  m_Ring.Reset();
+  m_StartTime         = _Time;
+  m_StopRequested     = false;
+  m_ProducedFrames    = 0;
+  m_ConsumedFrames    = 0;
+  m_Underruns         = 0;
+  m_UnderrunFrames    = 0;
+  m_MinBufferedFrames = m_Ring.GetFrameCapacity();
+
+  m_Producer = std::async(std::launch::async, &AudioStream::ProduceLoop, this, std::ref(_Source));
+
+  // Give the producer a lead before the sink starts pulling
+  while (m_ProducedFrames < PREBUFFER_FRAMES)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  if (!_Sink.Start(Synthesizer::SAMPLE_RATE, [this](float * _Output, std::size_t _FrameCount) { Pull(_Output, _FrameCount); }))
+  {
+    Stop();
+    return false;
+  }
+
+  m_Sink = &_Sink;
+
+  return true;
+}
+
+void AudioStream::Stop()
+{
+  // The sink first, it reads from the ring
+  if (m_Sink != nullptr)
+  {
+    m_Sink->Stop();
+    m_Sink = nullptr;
+  }
+
+  if (m_Producer.valid())
+  {
+    m_StopRequested = true;
+    m_Producer.get();
+  }
+}
+
+bool AudioStream::IsPlaying() const
+{
+  return m_Sink != nullptr;
+}
+
+double AudioStream::GetPlayedTime() const
+{
+  if (m_Sink == nullptr)
+    return m_StartTime;
+
+  // Underrun silence is not song time. Counting it once pulled rather than
+  // once played only holds the time a few buffers early
+  const auto PlayedFrames  = m_Sink->GetPlayedFrames();
+  const auto SilenceFrames = std::min<uint64_t>(m_UnderrunFrames, PlayedFrames);
+
+  return m_StartTime + static_cast<double>(PlayedFrames - SilenceFrames) / Synthesizer::SAMPLE_RATE;
+}
+
+AudioStream::Statistics AudioStream::GetStatistics() const
+{
+  Statistics Result;
+
+  Result.ProducedFrames    = m_ProducedFrames;
+  Result.ConsumedFrames    = m_ConsumedFrames;
+  Result.Underruns         = m_Underruns;
+  Result.UnderrunFrames    = m_UnderrunFrames;
+  Result.BufferedFrames    = m_Ring.GetReadableFrames();
+  Result.MinBufferedFrames = m_MinBufferedFrames;
+
+  return Result;
+}
+
+//
+// Service
+//
+
+void AudioStream::ProduceLoop(
+    AudioSource & _Source
+  )
+{
+  std::vector<float> Chunk(CHUNK_FRAMES * Synthesizer::CHANNEL_COUNT);
+
+  while (!m_StopRequested)
+  {
+    if (m_Ring.GetWritableFrames() < CHUNK_FRAMES)
+    {
+      // Far enough ahead, wait for the sink to play some of it
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      continue;
+    }
+
+    _Source.Render(Chunk.data(), CHUNK_FRAMES);
+
+    m_Ring.Write(Chunk.data(), CHUNK_FRAMES);
+    m_ProducedFrames += CHUNK_FRAMES;
+  }
+}
+
+void AudioStream::Pull(
+    float       * _Output,
+    std::size_t   _FrameCount
+  )
+{
+  const auto Buffered = m_Ring.GetReadableFrames();
+
+  if (Buffered < m_MinBufferedFrames)
+    m_MinBufferedFrames = Buffered;
+
+  const auto FrameCount = m_Ring.Read(_Output, _FrameCount);
+
+  m_ConsumedFrames += FrameCount;
+
+  if (FrameCount < _FrameCount)
+  {
+    // Silence rather than stale samples until the producer catches up
+    std::fill(_Output + FrameCount * Synthesizer::CHANNEL_COUNT, _Output + _FrameCount * Synthesizer::CHANNEL_COUNT, 0.0f);
+
+    ++m_Underruns;
+    m_UnderrunFrames += _FrameCount - FrameCount;
+  }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "AudioRingBuffer.h"
+#include "AudioSink.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+class AudioSource;
+
+//
+// Plays any audio source through a ring buffer. A producer thread pulls
+// the source in chunks into the ring ahead of playback and the sink pulls
+// from the ring, so playback starts after a short prebuffer, and a slow
+// chunk, like one the synthesizer renders on the fly, only eats into the
+// buffered lead. When the ring runs dry the sink gets silence and the
+// underrun is counted.
+//
+class AudioStream
+{
+public: // Constants
+
+  static constexpr std::size_t CHUNK_FRAMES     = 1024;
+  static constexpr std::size_t RING_FRAMES      = 32768;
+  static constexpr std::size_t PREBUFFER_FRAMES = 12000;  // 250 ms
+
+public: // Types
+
+  struct Statistics
+  {
+    uint64_t    ProducedFrames;
+    uint64_t    ConsumedFrames;
+    uint64_t    Underruns;          // pulls which got less than requested
+    uint64_t    UnderrunFrames;     // frames filled with silence
+    std::size_t BufferedFrames;
+    std::size_t MinBufferedFrames;  // lowest fill seen by a pull
+  };
+
+public: // Construction
+
+  AudioStream();
+
+  ~AudioStream();
+
+public: // Interface
+
+  // Stops previous playback and plays _Source from _Time seconds into
+  // _Sink. _Source must not be used elsewhere until Stop. Returns false if
+  // the sink cannot be started
+  bool Start(
+      AudioSource & _Source,
+      double        _Time,
+      AudioSink   & _Sink
+    );
+
+  void Stop();
+
+  bool IsPlaying() const;
+
+  // Song time of the audio the sink has played so far. It advances in the
+  // steps of the sink's counter and stands still on underruns
+  double GetPlayedTime() const;
+
+  Statistics GetStatistics() const;
+
+private: // Service
+
+  void ProduceLoop(
+      AudioSource & _Source
+    );
+
+  void Pull(
+      float       * _Output,
+      std::size_t   _FrameCount
+    );
+
+private: // Members
+
+  AudioRingBuffer          m_Ring;
+  AudioSink *              m_Sink      = nullptr;
+  double                   m_StartTime = 0;
+  std::future<void>        m_Producer;
+  std::atomic<bool>        m_StopRequested     { false };
+  std::atomic<uint64_t>    m_ProducedFrames    { 0 };
+  std::atomic<uint64_t>    m_ConsumedFrames    { 0 };
+  std::atomic<uint64_t>    m_Underruns         { 0 };
+  std::atomic<uint64_t>    m_UnderrunFrames    { 0 };
+  std::atomic<std::size_t> m_MinBufferedFrames { 0 };
+};
@@ -0,0 +1,465 @@
+#include "Benchmark.h"
+#include "AudioStream.h"
+#include "FigureLayout.h"
+#include "FileAudioSink.h"
+#include "NoteGeometryCache.h"
+#include "PlaybackClock.h"
+#include "SoftwareRasterizer.h"
+#include "Song.h"
+#include "Synthesizer.h"
+#include "imgui_internal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+//
+// Service
+//
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double MIN_SECONDS  = 0.5;  // each timing repeats for at least this long
+constexpr int    MIN_REPEATS  = 10;
+constexpr int    CHECK_FRAMES = 64;
+constexpr float  SONG_TIME    = 60;
+constexpr double PASS_SECONDS = 1;    // of audio per synthesizer run, every voice still sounding
+
+constexpr int    RASTER_WIDTH  = 1920;
+constexpr int    RASTER_HEIGHT = 1080;
+constexpr float  RASTER_SCALE  = 2;     // framebuffer pixels per display unit
+constexpr int    ROLL_TRACKS   = 6;
+constexpr int    ROLL_NOTES    = 2000;  // per track, over the song
+constexpr int    ROLL_MIN_KEY  = 48;
+constexpr int    ROLL_MAX_KEY  = 71;
+constexpr float  ROLL_SPEED    = 100;   // display units per second
+constexpr int    CHECKER_SIZE  = 64;
+constexpr ImU32  BACKGROUND    = 0xff0f0f0f;
+
+constexpr double UI_FRAME_SECONDS = 1 / 60.0;
+constexpr double WARMUP_SECONDS   = 2;    // for the playhead to settle on the audio clock
+
+// Seconds per call of _Run, averaged over enough calls for a stable value
+template <typename TRun>
+double TimeCalls(TRun && _Run)
+{
+  _Run();
+
+  const auto Begin = Clock::now();
+
+  int    Repeats = 0;
+  double Elapsed = 0;
+
+  do
+  {
+    _Run();
+    ++Repeats;
+
+    Elapsed = std::chrono::duration<double>(Clock::now() - Begin).count();
+  }
+  while (Repeats < MIN_REPEATS || Elapsed < MIN_SECONDS);
+
+  return Elapsed / Repeats;
+}
+
+template <typename T>
+bool IsSame(const std::vector<T> & _Lhs, const std::vector<T> & _Rhs)
+{
+  return _Lhs.size() == _Rhs.size() && std::memcmp(_Lhs.data(), _Rhs.data(), _Lhs.size() * sizeof(T)) == 0;
+}
+
+bool IsSame(const FigureLayout & _Lhs, const FigureLayout & _Rhs)
+{
+  return IsSame(_Lhs.X, _Rhs.X)         &&
+         IsSame(_Lhs.Y, _Rhs.Y)         &&
+         IsSame(_Lhs.Size, _Rhs.Size)   &&
+         IsSame(_Lhs.Color, _Rhs.Color) &&
+         IsSame(_Lhs.Filled, _Rhs.Filled);
+}
+
+// Frame of a 1920x1080 view at 100 px/s
+FigureLayout::Frame GetFrame(
+    float _Time
+  )
+{
+  FigureLayout::Frame Frame;
+  Frame.ScreenPos      = ImVec2(0, 0);
+  Frame.Width          = 1920;
+  Frame.Time           = _Time;
+  Frame.HalfScreenTime = Frame.Width / (2 * 100.0f);
+  Frame.TrackOffset    = _Time - Frame.HalfScreenTime;
+  Frame.PixelPerSec    = 100;
+  Frame.FigureHeight   = 50;
+  Frame.MaxNote        = 108;
+  Frame.NoteHeight     = 1080 / 89.0f;
+
+  return Frame;
+}
+
+// Random notes on ROLL_TRACKS tracks, sorted by start within each track
+NoteTable MakeRollNotes()
+{
+  std::mt19937 Random(1);
+
+  std::uniform_real_distribution<float> Start(0, 2 * SONG_TIME);
+  std::uniform_real_distribution<float> Duration(0.05f, 2);
+  std::uniform_int_distribution<int>    Key(ROLL_MIN_KEY, ROLL_MAX_KEY);
+
+  NoteTable Notes;
+
+  for (int TrackIdx = 0; TrackIdx < ROLL_TRACKS; ++TrackIdx)
+  {
+    std::vector<float> Starts(ROLL_NOTES);
+
+    for (auto & NoteStart : Starts)
+      NoteStart = Start(Random);
+
+    std::sort(Starts.begin(), Starts.end());
+
+    Notes.TrackBegin.push_back(Notes.Start.size());
+    Notes.TrackMaxDuration.push_back(0);
+
+    for (const auto NoteStart : Starts)
+    {
+      Notes.Start.push_back(NoteStart);
+      Notes.Duration.push_back(Duration(Random));
+      Notes.Key.push_back(static_cast<uint8_t>(Key(Random)));
+      Notes.Velocity.push_back(100);
+      Notes.Channel.push_back(0);
+      Notes.Track.push_back(static_cast<uint16_t>(TrackIdx));
+
+      Notes.TrackMaxDuration.back() = std::max(Notes.TrackMaxDuration.back(), Notes.Duration.back());
+    }
+  }
+
+  Notes.TrackBegin.push_back(Notes.Start.size());
+
+  return Notes;
+}
+
+// Black and white squares of 8 texels
+std::vector<ImU32> MakeChecker()
+{
+  std::vector<ImU32> Pixels(CHECKER_SIZE * CHECKER_SIZE);
+
+  for (int Y = 0; Y < CHECKER_SIZE; ++Y)
+    for (int X = 0; X < CHECKER_SIZE; ++X)
+      Pixels[Y * CHECKER_SIZE + X] = ((X / 8 + Y / 8) % 2) != 0 ? 0xffffffff : 0xff000000;
+
+  return Pixels;
+}
+
+} // namespace
+
+//
+// Interface
+//
+
+int Benchmark::RunFigureLayout(
+    std::size_t _FigureCount
+  )
+{
+  // Figures spread over every stage, appearing, shrinking and faded out
+  std::mt19937 Random(1);
+
+  std::uniform_real_distribution<float> Start(SONG_TIME - 5, SONG_TIME + GetFrame(SONG_TIME).HalfScreenTime);
+  std::uniform_real_distribution<float> Duration(0.05f, 4);
+  std::uniform_int_distribution<int>    Velocity(1, 127);
+  std::uniform_int_distribution<int>    Key(21, 108);
+  std::uniform_int_distribution<int>    Shape(0, static_cast<int>(FigureBatch::Shape::Hexagon));
+
+  FigureLayout Layout;
+
+  for (std::size_t FigureIdx = 0; FigureIdx < _FigureCount; ++FigureIdx)
+    Layout.Add(
+        Start(Random),
+        Duration(Random),
+        static_cast<uint8_t>(Velocity(Random)),
+        static_cast<uint8_t>(Key(Random)),
+        Random(),
+        static_cast<FigureBatch::Shape>(Shape(Random))
+      );
+
+  FigureLayout Reference = Layout;
+
+  bool IsIdentical = true;
+
+  for (int FrameIdx = 0; FrameIdx < CHECK_FRAMES; ++FrameIdx)
+  {
+    const auto Frame = GetFrame(SONG_TIME - 5 + FrameIdx * 0.25f);
+
+    Layout.Compute(Frame);
+    Reference.ComputeReference(Frame);
+
+    IsIdentical = IsIdentical && IsSame(Layout, Reference);
+  }
+
+  const auto Frame = GetFrame(SONG_TIME);
+
+  const auto ScalarSeconds = TimeCalls([&] { Reference.ComputeReference(Frame); });
+  const auto VectorSeconds = TimeCalls([&] { Layout.Compute(Frame); });
+
+  const auto Count = static_cast<double>(_FigureCount > 0 ? _FigureCount : 1);
+
+  std::printf("FigureLayout, %zu figures, vector kernel %s\n", _FigureCount, FigureLayout::GetVectorName());
+  std::printf("  scalar  %8.2f ns/figure  %8.3f ms/frame\n", ScalarSeconds * 1e9 / Count, ScalarSeconds * 1e3);
+  std::printf("  vector  %8.2f ns/figure  %8.3f ms/frame  %.2fx\n", VectorSeconds * 1e9 / Count, VectorSeconds * 1e3, ScalarSeconds / VectorSeconds);
+  std::printf("  results %s over %d frames\n", IsIdentical ? "identical" : "DIFFER", CHECK_FRAMES);
+
+  return IsIdentical ? 0 : 1;
+}
+
+int Benchmark::RunSynthesizer(
+    std::size_t _VoiceCount
+  )
+{
+  const auto VoiceCount = std::clamp<std::size_t>(_VoiceCount, 1, Synthesizer::MAX_VOICES);
+
+  // Held notes all starting at once, spread over the keys since the key
+  // sets the decay
+  NoteTable Notes;
+
+  for (std::size_t VoiceIdx = 0; VoiceIdx < VoiceCount; ++VoiceIdx)
+  {
+    Notes.Start.push_back(0);
+    Notes.Duration.push_back(static_cast<float>(PASS_SECONDS) + 1);
+    Notes.Key.push_back(static_cast<uint8_t>(30 + VoiceIdx * 7 % 70));
+    Notes.Velocity.push_back(100);
+    Notes.Channel.push_back(0);
+    Notes.Track.push_back(0);
+  }
+
+  Notes.TrackBegin       = { 0, VoiceCount };
+  Notes.TrackMaxDuration = { static_cast<float>(PASS_SECONDS) + 1 };
+
+  Synthesizer Synth;
+  Synth.SetNotes(Notes);
+
+  std::vector<float> Output(Synthesizer::BLOCK_FRAMES * Synthesizer::CHANNEL_COUNT);
+
+  const auto PassFrames = static_cast<std::size_t>(PASS_SECONDS * Synthesizer::SAMPLE_RATE);
+
+  const auto Seconds = TimeCalls([&]
+    {
+      Synth.Start(0);
+
+      for (std::size_t Frame = 0; Frame < PassFrames; Frame += Synthesizer::BLOCK_FRAMES)
+        Synth.Render(Output.data(), std::min(Synthesizer::BLOCK_FRAMES, PassFrames - Frame));
+    });
+
+  const auto RealTime = PASS_SECONDS / Seconds;
+
+  std::printf("Synthesizer, %zu voices at %d Hz, vector mixer %s\n", VoiceCount, Synthesizer::SAMPLE_RATE, Synthesizer::GetVectorName());
+  std::printf("  %8.1fx real time\n", RealTime);
+  std::printf("  %8.0f voices per core\n", RealTime * VoiceCount);
+
+  return 0;
+}
+
+int Benchmark::RunRasterizer(
+    unsigned int _ThreadCount
+  )
+{
+  const auto ThreadCount = _ThreadCount != 0 ? _ThreadCount : std::max(1u, std::thread::hardware_concurrency());
+
+  ImFontAtlas Atlas;
+  auto * Font = Atlas.AddFontDefault();
+
+  SoftwareRasterizer Reference;
+  SoftwareRasterizer Tiled;
+
+  // Textures are added in the same order, so their ids are the same in both
+  Reference.SetFontAtlas(Atlas);
+  Tiled.SetFontAtlas(Atlas);
+
+  const auto Checker   = MakeChecker();
+  const auto CheckerId = Reference.AddTexture(Checker.data(), CHECKER_SIZE, CHECKER_SIZE);
+  Tiled.AddTexture(Checker.data(), CHECKER_SIZE, CHECKER_SIZE);
+
+  Tiled.SetThreadCount(ThreadCount);
+
+  const auto Origin      = ImVec2(1920, 120);
+  const auto DisplaySize = ImVec2(RASTER_WIDTH / RASTER_SCALE, RASTER_HEIGHT / RASTER_SCALE);
+  const auto DisplayEnd  = ImVec2(Origin.x + DisplaySize.x, Origin.y + DisplaySize.y);
+
+  // What ImGui::NewFrame would set up for the draw lists
+  ImDrawListSharedData SharedData;
+  SharedData.TexUvWhitePixel      = Atlas.TexUvWhitePixel;
+  SharedData.Font                 = Font;
+  SharedData.FontSize             = Font->FontSize;
+  SharedData.ClipRectFullscreen   = ImVec4(Origin.x, Origin.y, DisplayEnd.x, DisplayEnd.y);
+  SharedData.CurveTessellationTol = 1.25f;
+  SharedData.InitialFlags         = ImDrawListFlags_AntiAliasedLines | ImDrawListFlags_AntiAliasedFill | ImDrawListFlags_AllowVtxOffset;
+  SharedData.SetCircleTessellationMaxError(0.30f);
+
+  // The piano roll like the live view draws it, a label and the notes of
+  // each track with the playhead across them
+  const auto Notes = MakeRollNotes();
+
+  NoteGeometryCache Geometry;
+
+  const auto TrackHeight = DisplaySize.y / ROLL_TRACKS;
+  const auto NoteHeight  = (TrackHeight - Font->FontSize) / (ROLL_MAX_KEY - ROLL_MIN_KEY + 1);
+  const auto TimeOffset  = SONG_TIME - DisplaySize.x / (2 * ROLL_SPEED);
+
+  ImDrawList Roll(&SharedData);
+  Roll._ResetForNewFrame();
+  Roll.PushClipRect(Origin, DisplayEnd);
+  Roll.PushTextureID(Atlas.TexID);
+
+  for (int TrackIdx = 0; TrackIdx < ROLL_TRACKS; ++TrackIdx)
+  {
+    const auto Top = Origin.y + TrackIdx * TrackHeight;
+
+    char Label[32];
+    std::snprintf(Label, sizeof(Label), "Track No %d", TrackIdx);
+
+    Roll.AddText(Font, Font->FontSize, ImVec2(Origin.x, Top), 0xffffffff, Label);
+
+    Geometry.Draw(
+        &Roll,
+        Notes,
+        TrackIdx,
+        ROLL_MAX_KEY,
+        ImVec2(Origin.x, Top + Font->FontSize),
+        TimeOffset,
+        DisplaySize.x / ROLL_SPEED,
+        ROLL_SPEED,
+        NoteHeight
+      );
+  }
+
+  Roll.AddLine(
+      ImVec2(Origin.x + DisplaySize.x / 2, Origin.y),
+      ImVec2(Origin.x + DisplaySize.x / 2, DisplayEnd.y),
+      0xff1111ff,
+      2
+    );
+
+  Roll.PopTextureID();
+  Roll.PopClipRect();
+
+  // A second list on top, with a texture other than the font atlas
+  ImDrawList Overlay(&SharedData);
+  Overlay._ResetForNewFrame();
+  Overlay.PushClipRect(Origin, DisplayEnd);
+  Overlay.PushTextureID(Atlas.TexID);
+
+  Overlay.AddImage(CheckerId, ImVec2(DisplayEnd.x - 140, Origin.y + 20), ImVec2(DisplayEnd.x - 20, Origin.y + 140), ImVec2(0, 0), ImVec2(1, 1), 0xc0ffffff);
+  Overlay.AddText(Font, Font->FontSize, ImVec2(DisplayEnd.x - 140, Origin.y + 145), 0xffffffff, "Overlay");
+
+  Overlay.PopTextureID();
+  Overlay.PopClipRect();
+
+  ImDrawList * Lists[] = { &Roll, &Overlay };
+
+  ImDrawData DrawData;
+  DrawData.Valid            = true;
+  DrawData.CmdLists         = Lists;
+  DrawData.CmdListsCount    = 2;
+  DrawData.TotalVtxCount    = Roll.VtxBuffer.Size + Overlay.VtxBuffer.Size;
+  DrawData.TotalIdxCount    = Roll.IdxBuffer.Size + Overlay.IdxBuffer.Size;
+  DrawData.DisplayPos       = Origin;
+  DrawData.DisplaySize      = DisplaySize;
+  DrawData.FramebufferScale = ImVec2(RASTER_SCALE, RASTER_SCALE);
+
+  Reference.Resize(RASTER_WIDTH, RASTER_HEIGHT);
+  Tiled.Resize(RASTER_WIDTH, RASTER_HEIGHT);
+
+  const auto DrawFrame = [&](SoftwareRasterizer & _Rasterizer)
+  {
+    _Rasterizer.Clear(BACKGROUND);
+    _Rasterizer.Draw(DrawData);
+  };
+
+  DrawFrame(Reference);
+  DrawFrame(Tiled);
+
+  const bool IsIdentical = IsSame(Reference.GetPixels(), Tiled.GetPixels());
+
+  const auto SerialSeconds = TimeCalls([&] { DrawFrame(Reference); });
+  const auto TiledSeconds  = TimeCalls([&] { DrawFrame(Tiled); });
+
+  std::printf("SoftwareRasterizer, %dx%d, %d triangles\n", RASTER_WIDTH, RASTER_HEIGHT, DrawData.TotalIdxCount / 3);
+  std::printf("  1 thread    %8.3f ms/frame\n", SerialSeconds * 1e3);
+  std::printf("  %u threads   %8.3f ms/frame  %.2fx\n", ThreadCount, TiledSeconds * 1e3, SerialSeconds / TiledSeconds);
+  std::printf("  pixels %s\n", IsIdentical ? "identical" : "DIFFER");
+
+  return IsIdentical ? 0 : 1;
+}
+
+int Benchmark::RunPlayback(
+    const Song        & _Song,
+    double              _Seconds,
+    const std::string & _WavPath
+  )
+{
+  Synthesizer Synth;
+  Synth.SetNotes(_Song.Notes);
+
+  FileAudioSink Sink(_WavPath);
+  AudioStream   Stream;
+  PlaybackClock Playhead;
+
+  const double StartTime = _Song.HasNotes() ? _Song.FirstNoteTime : 0;
+
+  if (!Stream.Start(Synth, StartTime, Sink))
+  {
+    std::fprintf(stderr, "Cannot write %s\n", _WavPath.c_str());
+    return 1;
+  }
+
+  // The sink plays one frame per sample period from its start, so the
+  // heard time is the time since then, less the silence of underruns
+  const auto PlayStart = Clock::now();
+
+  Playhead.Start(StartTime);
+
+  double DriftSum    = 0;
+  double WorstDrift  = 0;
+  int    SampleCount = 0;
+
+  for (;;)
+  {
+    std::this_thread::sleep_for(std::chrono::duration<double>(UI_FRAME_SECONDS));
+
+    const auto Time       = Playhead.Update(Stream.GetPlayedTime());
+    const auto Statistics = Stream.GetStatistics();
+    const auto Elapsed    = std::chrono::duration<double>(Clock::now() - PlayStart).count();
+
+    if (Elapsed >= _Seconds)
+      break;
+
+    if (Elapsed < WARMUP_SECONDS)
+      continue;
+
+    const auto HeardTime = StartTime + Elapsed - static_cast<double>(Statistics.UnderrunFrames) / Synthesizer::SAMPLE_RATE;
+    const auto Drift     = std::abs(Time - HeardTime);
+
+    DriftSum  += Drift;
+    WorstDrift = std::max(WorstDrift, Drift);
+    ++SampleCount;
+  }
+
+  const auto Statistics = Stream.GetStatistics();
+
+  Stream.Stop();
+
+  const auto MeanDrift = SampleCount > 0 ? DriftSum / SampleCount : 0.0;
+
+  std::printf("Playback, %.1f s at %d Hz from %.2f s, %d playhead updates\n", _Seconds, Synthesizer::SAMPLE_RATE, StartTime, SampleCount);
+  std::printf("  drift     %8.3f ms mean  %8.3f ms worst\n", MeanDrift * 1e3, WorstDrift * 1e3);
+  std::printf("  underruns %8llu, %llu frames of silence\n", static_cast<unsigned long long>(Statistics.Underruns), static_cast<unsigned long long>(Statistics.UnderrunFrames));
+  std::printf("  buffered  %8zu frames at the lowest\n", Statistics.MinBufferedFrames);
+  std::printf("  mean drift %s %.1f ms\n", MeanDrift <= MAX_DRIFT ? "within" : "EXCEEDS", MAX_DRIFT * 1e3);
+
+  return MeanDrift <= MAX_DRIFT ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class Song;
+
+//
+// Timings and checks for the headless --bench-* modes. Each one prints its
+// results and returns the exit code of the process, non-zero when a check
+// fails, like an optimized kernel not matching its reference.
+//
+class Benchmark
+{
+public: // Constants
+
+  // Seconds the playhead may be off the heard audio on average
+  static constexpr double MAX_DRIFT = 0.001;
+
+public: // Interface
+
+  // Times the figure kernel on _FigureCount random figures, with the
+  // vector path of the build and with the scalar reference, and checks
+  // that both give identical results
+  static int RunFigureLayout(
+      std::size_t _FigureCount
+    );
+
+  // Times the synthesizer with _VoiceCount voices sounding, at most the
+  // size of its pool, and reports how many voices one core renders in
+  // real time
+  static int RunSynthesizer(
+      std::size_t _VoiceCount
+    );
+
+  // Times the rasterizer on a piano roll frame with text and a texture,
+  // drawn with the origin and pixel density of a window on a second
+  // monitor, on one thread and on _ThreadCount (0 for one per core), and
+  // checks that both give identical pixels
+  static int RunRasterizer(
+      unsigned int _ThreadCount
+    );
+
+  // Plays _Song for _Seconds through the audio stream into a file sink,
+  // written to _WavPath unless it is empty, with the playhead stepped at
+  // 60 fps like the live view. Reports how far the playhead is from the
+  // heard audio and the underruns, and fails when it is off by more than
+  // MAX_DRIFT on average
+  static int RunPlayback(
+      const Song        & _Song,
+      double              _Seconds,
+      const std::string & _WavPath
+    );
+};
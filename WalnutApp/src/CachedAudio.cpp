@@ -0,0 +1,77 @@
+#include "CachedAudio.h"
+#include "MappedFile.h"
+#include "Synthesizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+//
+// Construction
+//
+
+CachedAudio::CachedAudio() = default;
+
+CachedAudio::~CachedAudio() = default;
+
+//
+// Interface
+//
+
+void CachedAudio::Assign(
+    std::unique_ptr<smf::MappedFile>   _File,
+    const int16_t                    * _Samples,
+    uint64_t                           _FrameCount
+  )
+{
+  m_File       = std::move(_File);
+  m_Samples    = _Samples;
+  m_FrameCount = _FrameCount;
+  m_Frame      = 0;
+}
+
+void CachedAudio::Clear()
+{
+  Assign(nullptr, nullptr, 0);
+}
+
+bool CachedAudio::IsEmpty() const
+{
+  return m_File == nullptr;
+}
+
+//
+// AudioSource
+//
+
+void CachedAudio::Start(
+    double _Time
+  )
+{
+  m_Frame = static_cast<int64_t>(std::llround(_Time * Synthesizer::SAMPLE_RATE));
+}
+
+void CachedAudio::Render(
+    float       * _Output,
+    std::size_t   _FrameCount
+  )
+{
+  constexpr int   CHANNEL_COUNT = Synthesizer::CHANNEL_COUNT;
+  constexpr float SCALE         = 1.0f / 32767;
+
+  const auto Frame = m_Frame;
+  m_Frame += _FrameCount;
+
+  // Frames before the start and past the end of the rendering are silent
+  const auto Begin = std::clamp<int64_t>(Frame, 0, static_cast<int64_t>(m_FrameCount));
+  const auto End   = std::clamp<int64_t>(m_Frame, 0, static_cast<int64_t>(m_FrameCount));
+
+  std::fill(_Output, _Output + _FrameCount * CHANNEL_COUNT, 0.0f);
+
+  if (Begin >= End)
+    return;
+
+  auto * Output = _Output + (Begin - Frame) * CHANNEL_COUNT;
+
+  for (auto SampleIdx = Begin * CHANNEL_COUNT; SampleIdx < End * CHANNEL_COUNT; ++SampleIdx)
+    *Output++ = m_Samples[SampleIdx] * SCALE;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "AudioSource.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace smf
+{
+  class MappedFile;
+}
+
+//
+// Song audio rendered ahead of time, played straight from a mapped file of
+// 16-bit stereo frames. Times outside of the rendered frames are silent.
+//
+class CachedAudio : public AudioSource
+{
+public: // Construction
+
+  CachedAudio();
+
+  ~CachedAudio() override;
+
+public: // Interface
+
+  // Takes over _File, whose _FrameCount frames start at _Samples
+  void Assign(
+      std::unique_ptr<smf::MappedFile>   _File,
+      const int16_t                    * _Samples,
+      uint64_t                           _FrameCount
+    );
+
+  void Clear();
+
+  bool IsEmpty() const;
+
+public: // AudioSource
+
+  void Start(
+      double _Time
+    ) override;
+
+  void Render(
+      float       * _Output,
+      std::size_t   _FrameCount
+    ) override;
+
+private: // Members
+
+  std::unique_ptr<smf::MappedFile> m_File;
+  const int16_t *                  m_Samples    = nullptr;
+  uint64_t                         m_FrameCount = 0;
+  int64_t                          m_Frame      = 0;  // next frame, negative before the start
+};
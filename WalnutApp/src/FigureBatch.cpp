@@ -0,0 +1,383 @@
+#include "FigureBatch.h"
+#include "imgui_internal.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+//
+// Service
+//
+
+namespace
+{
+
+constexpr float AA_SIZE          = 1;
+constexpr int   MAX_BLOCK_VTX    = 1 << 16;
+constexpr float CIRCLE_MAX_ERROR = 0.30f;  // pixels, ImGui's default circle tessellation error
+
+// Tessellation levels of the circle template, the finest one is ImGui's
+// own limit
+constexpr std::array<int, 13> CIRCLE_SEGMENTS = { 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512 };
+
+// Outline of a shape of height 1 centered on the origin, stored as separate
+// coordinate arrays so scaling a figure is a plain loop over floats
+struct ShapeTemplate
+{
+  std::vector<float> X;
+  std::vector<float> Y;
+  std::vector<float> NormalX;  // miter normals for the anti-aliased fringe
+  std::vector<float> NormalY;
+
+  int GetPointCount() const
+  {
+    return static_cast<int>(X.size());
+  }
+};
+
+ShapeTemplate MakeTemplate(
+    std::vector<ImVec2> _Points
+  )
+{
+  ShapeTemplate Template;
+
+  const int PointCount = static_cast<int>(_Points.size());
+
+  // Same normals as ImDrawList::AddConvexPolyFilled, oriented outwards
+  float Area = 0;
+
+  for (int i0 = PointCount - 1, i1 = 0; i1 < PointCount; i0 = i1++)
+    Area += _Points[i0].x * _Points[i1].y - _Points[i1].x * _Points[i0].y;
+
+  const float Orientation = Area > 0 ? 1.0f : -1.0f;
+
+  std::vector<ImVec2> EdgeNormals(PointCount);
+
+  for (int i0 = PointCount - 1, i1 = 0; i1 < PointCount; i0 = i1++)
+  {
+    float dx = _Points[i1].x - _Points[i0].x;
+    float dy = _Points[i1].y - _Points[i0].y;
+
+    const float Length = std::sqrt(dx * dx + dy * dy);
+
+    if (Length > 0)
+    {
+      dx /= Length;
+      dy /= Length;
+    }
+
+    EdgeNormals[i0] = ImVec2(dy * Orientation, -dx * Orientation);
+  }
+
+  for (int i0 = PointCount - 1, i1 = 0; i1 < PointCount; i0 = i1++)
+  {
+    float nx = (EdgeNormals[i0].x + EdgeNormals[i1].x) / 2;
+    float ny = (EdgeNormals[i0].y + EdgeNormals[i1].y) / 2;
+
+    const float d2 = nx * nx + ny * ny;
+
+    if (d2 > 0.000001f)
+    {
+      const float Scale = std::fmin(1 / d2, 100.0f);
+
+      nx *= Scale;
+      ny *= Scale;
+    }
+
+    Template.X.push_back(_Points[i1].x);
+    Template.Y.push_back(_Points[i1].y);
+    Template.NormalX.push_back(nx);
+    Template.NormalY.push_back(ny);
+  }
+
+  return Template;
+}
+
+struct ShapeTemplates
+{
+  std::array<ShapeTemplate, static_cast<int>(FigureBatch::Shape::Count)> Shapes;  // all but the circle
+
+  // One circle per tessellation level, used up to its maximum height
+  std::array<ShapeTemplate, CIRCLE_SEGMENTS.size()> Circles;
+  std::array<float, CIRCLE_SEGMENTS.size()>         CircleMaxHeights;
+};
+
+ShapeTemplates MakeTemplates()
+{
+  ShapeTemplates Result;
+
+  auto & Templates = Result.Shapes;
+
+  // ImGui tessellates a circle so that no chord strays more than the
+  // tessellation error from it, which with n segments holds up to radius
+  // error / (1 - cos(pi / n))
+  for (std::size_t Level = 0; Level < CIRCLE_SEGMENTS.size(); ++Level)
+  {
+    const int Segments = CIRCLE_SEGMENTS[Level];
+
+    std::vector<ImVec2> CirclePoints;
+
+    for (int i = 0; i < Segments; ++i)
+    {
+      const float Angle = 2 * 3.141592f * i / Segments;
+      CirclePoints.push_back(ImVec2(std::cos(Angle) / 2, std::sin(Angle) / 2));
+    }
+
+    Result.Circles[Level]          = MakeTemplate(CirclePoints);
+    Result.CircleMaxHeights[Level] = 2 * CIRCLE_MAX_ERROR / static_cast<float>(1 - std::cos(3.141592653589793 / Segments));
+  }
+
+  //                        sqrt(3)
+  const float Side = 2 / 1.732050807568877f;
+
+  Templates[static_cast<int>(FigureBatch::Shape::Triangle)] = MakeTemplate({
+      {         0, -0.5f },
+      {  Side / 2,  0.5f },
+      { -Side / 2,  0.5f },
+    });
+
+  Templates[static_cast<int>(FigureBatch::Shape::TriangleUpsideDown)] = MakeTemplate({
+      {         0,  0.5f },
+      {  Side / 2, -0.5f },
+      { -Side / 2, -0.5f },
+    });
+
+  Templates[static_cast<int>(FigureBatch::Shape::Square)] = MakeTemplate({
+      { -0.5f, -0.5f },
+      {  0.5f, -0.5f },
+      {  0.5f,  0.5f },
+      { -0.5f,  0.5f },
+    });
+
+  Templates[static_cast<int>(FigureBatch::Shape::Rhombus)] = MakeTemplate({
+      {     0, -0.5f },
+      {  0.5f,     0 },
+      {     0,  0.5f },
+      { -0.5f,     0 },
+    });
+
+  const float a = 0.6498393924658126f;
+  const float d = a * 1.618033988749895f;
+  const float y = std::sqrt(1 - d * d) / 2;
+
+  Templates[static_cast<int>(FigureBatch::Shape::Pentagon)] = MakeTemplate({
+      {      0, -0.5f },
+      {  d / 2,    -y },
+      {  a / 2,  0.5f },
+      { -a / 2,  0.5f },
+      { -d / 2,    -y },
+    });
+
+  const float h_a = 0.5773502691896258f;
+
+  Templates[static_cast<int>(FigureBatch::Shape::Hexagon)] = MakeTemplate({
+      {  h_a / 2, -0.5f },
+      {      h_a,     0 },
+      {  h_a / 2,  0.5f },
+      { -h_a / 2,  0.5f },
+      {     -h_a,     0 },
+      { -h_a / 2, -0.5f },
+    });
+
+  return Result;
+}
+
+// Circles get the coarsest template which is still as round as ImGui
+// would draw them at _Height
+const ShapeTemplate & GetTemplate(
+    FigureBatch::Shape _Shape,
+    float              _Height
+  )
+{
+  static const auto TEMPLATES = MakeTemplates();
+
+  if (_Shape != FigureBatch::Shape::Circle)
+    return TEMPLATES.Shapes[static_cast<int>(_Shape)];
+
+  const auto & MaxHeights = TEMPLATES.CircleMaxHeights;
+
+  const auto Level = std::min<std::size_t>(
+      std::lower_bound(MaxHeights.begin(), MaxHeights.end(), _Height) - MaxHeights.begin(),
+      MaxHeights.size() - 1
+    );
+
+  return TEMPLATES.Circles[Level];
+}
+
+} // namespace
+
+//
+// Interface
+//
+
+void FigureBatch::Add(
+    Shape  _Shape,
+    ImVec2 _ScreenPos,
+    float  _Height,
+    bool   _Filled,
+    ImU32  _Color
+  )
+{
+  if (_Height <= 0 || (_Color & 0xff000000) == 0)
+    return;
+
+  m_Figures.push_back({ _ScreenPos, _Height, _Color, _Shape, _Filled });
+}
+
+void FigureBatch::Flush(
+    ImDrawList * _DrawList
+  )
+{
+  std::size_t BlockBegin = 0;
+  int         VtxCount   = 0;
+  int         IdxCount   = 0;
+
+  for (std::size_t FigureIdx = 0; FigureIdx < m_Figures.size(); ++FigureIdx)
+  {
+    const auto FigureVtxCount = GetVtxCount(m_Figures[FigureIdx]);
+
+    if (VtxCount + FigureVtxCount >= MAX_BLOCK_VTX)
+    {
+      EmitBlock(_DrawList, BlockBegin, FigureIdx, VtxCount, IdxCount);
+
+      BlockBegin = FigureIdx;
+      VtxCount   = 0;
+      IdxCount   = 0;
+    }
+
+    VtxCount += FigureVtxCount;
+    IdxCount += GetIdxCount(m_Figures[FigureIdx]);
+  }
+
+  if (VtxCount > 0)
+    EmitBlock(_DrawList, BlockBegin, m_Figures.size(), VtxCount, IdxCount);
+
+  m_Figures.clear();
+}
+
+//
+// Service
+//
+
+void FigureBatch::EmitBlock(
+    ImDrawList * _DrawList,
+    std::size_t  _FigureBegin,
+    std::size_t  _FigureEnd,
+    int          _VtxCount,
+    int          _IdxCount
+  ) const
+{
+  _DrawList->PrimReserve(_IdxCount, _VtxCount);
+
+  const auto   Uv   = _DrawList->_Data->TexUvWhitePixel;
+  auto *       Vtx  = _DrawList->_VtxWritePtr;
+  auto *       Idx  = _DrawList->_IdxWritePtr;
+  unsigned int Base = _DrawList->_VtxCurrentIdx;
+
+  for (auto FigureIdx = _FigureBegin; FigureIdx < _FigureEnd; ++FigureIdx)
+  {
+    const auto & Figure     = m_Figures[FigureIdx];
+    const auto & Template   = GetTemplate(Figure.Kind, Figure.Height);
+    const int    PointCount = Template.GetPointCount();
+    const ImU32  Color      = Figure.Color;
+    const ImU32  Fringe     = Figure.Color & 0x00ffffff;
+    const float  cx         = Figure.ScreenPos.x;
+    const float  cy         = Figure.ScreenPos.y;
+    const float  h          = Figure.Height;
+
+    if (Figure.Filled)
+    {
+      // Like ImDrawList::AddConvexPolyFilled: an opaque inner polygon and
+      // a transparent outer ring, half the fringe away on either side
+      for (int i = 0; i < PointCount; ++i)
+      {
+        const float x  = cx + Template.X[i] * h;
+        const float y  = cy + Template.Y[i] * h;
+        const float dx = Template.NormalX[i] * (AA_SIZE / 2);
+        const float dy = Template.NormalY[i] * (AA_SIZE / 2);
+
+        Vtx[0] = { ImVec2(x - dx, y - dy), Uv, Color };
+        Vtx[1] = { ImVec2(x + dx, y + dy), Uv, Fringe };
+        Vtx += 2;
+      }
+
+      for (int i = 2; i < PointCount; ++i)
+      {
+        Idx[0] = static_cast<ImDrawIdx>(Base);
+        Idx[1] = static_cast<ImDrawIdx>(Base + (i - 1) * 2);
+        Idx[2] = static_cast<ImDrawIdx>(Base + i * 2);
+        Idx += 3;
+      }
+
+      for (int i0 = PointCount - 1, i1 = 0; i1 < PointCount; i0 = i1++)
+      {
+        Idx[0] = static_cast<ImDrawIdx>(Base + i1 * 2);
+        Idx[1] = static_cast<ImDrawIdx>(Base + i0 * 2);
+        Idx[2] = static_cast<ImDrawIdx>(Base + i0 * 2 + 1);
+        Idx[3] = static_cast<ImDrawIdx>(Base + i0 * 2 + 1);
+        Idx[4] = static_cast<ImDrawIdx>(Base + i1 * 2 + 1);
+        Idx[5] = static_cast<ImDrawIdx>(Base + i1 * 2);
+        Idx += 6;
+      }
+    }
+    else
+    {
+      // Like the thin anti-aliased ImDrawList::AddPolyline: an opaque
+      // center line between two transparent edges
+      for (int i = 0; i < PointCount; ++i)
+      {
+        const float x  = cx + Template.X[i] * h;
+        const float y  = cy + Template.Y[i] * h;
+        const float dx = Template.NormalX[i] * AA_SIZE;
+        const float dy = Template.NormalY[i] * AA_SIZE;
+
+        Vtx[0] = { ImVec2(x,      y),      Uv, Color };
+        Vtx[1] = { ImVec2(x + dx, y + dy), Uv, Fringe };
+        Vtx[2] = { ImVec2(x - dx, y - dy), Uv, Fringe };
+        Vtx += 3;
+      }
+
+      for (int i0 = PointCount - 1, i1 = 0; i1 < PointCount; i0 = i1++)
+      {
+        const unsigned int v0 = Base + i0 * 3;
+        const unsigned int v1 = Base + i1 * 3;
+
+        Idx[0]  = static_cast<ImDrawIdx>(v1);
+        Idx[1]  = static_cast<ImDrawIdx>(v0);
+        Idx[2]  = static_cast<ImDrawIdx>(v0 + 2);
+        Idx[3]  = static_cast<ImDrawIdx>(v0 + 2);
+        Idx[4]  = static_cast<ImDrawIdx>(v1 + 2);
+        Idx[5]  = static_cast<ImDrawIdx>(v1);
+        Idx[6]  = static_cast<ImDrawIdx>(v1 + 1);
+        Idx[7]  = static_cast<ImDrawIdx>(v0 + 1);
+        Idx[8]  = static_cast<ImDrawIdx>(v0);
+        Idx[9]  = static_cast<ImDrawIdx>(v0);
+        Idx[10] = static_cast<ImDrawIdx>(v1);
+        Idx[11] = static_cast<ImDrawIdx>(v1 + 1);
+        Idx += 12;
+      }
+    }
+
+    Base += GetVtxCount(Figure);
+  }
+
+  _DrawList->_VtxWritePtr    = Vtx;
+  _DrawList->_IdxWritePtr    = Idx;
+  _DrawList->_VtxCurrentIdx = Base;
+}
+
+int FigureBatch::GetVtxCount(
+    const Figure & _Figure
+  )
+{
+  return GetTemplate(_Figure.Kind, _Figure.Height).GetPointCount() * (_Figure.Filled ? 2 : 3);
+}
+
+int FigureBatch::GetIdxCount(
+    const Figure & _Figure
+  )
+{
+  const int PointCount = GetTemplate(_Figure.Kind, _Figure.Height).GetPointCount();
+
+  return _Figure.Filled ? (PointCount - 2) * 3 + PointCount * 6 : PointCount * 12;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <vector>
+
+//
+// Animation figures of one frame, written into the draw list together.
+// Each shape has a template of its outline at unit height with the
+// anti-aliasing normals already computed, so a figure only scales and
+// translates its template. Circles have a template per tessellation
+// level, and each takes the coarsest one which is as round as ImGui would
+// draw it at its radius. Figures are queued with Add and emitted by
+// Flush in one reserved vertex/index block, split only where the block
+// would overflow 16-bit indices.
+//
+class FigureBatch
+{
+public: // Types
+
+  enum class Shape
+  {
+    Circle,
+    Triangle,
+    TriangleUpsideDown,
+    Square,
+    Rhombus,
+    Pentagon,
+    Hexagon,
+    Count
+  };
+
+public: // Interface
+
+  // _Height is the height of the figure, _Color includes its opacity
+  void Add(
+      Shape  _Shape,
+      ImVec2 _ScreenPos,
+      float  _Height,
+      bool   _Filled,
+      ImU32  _Color
+    );
+
+  // Writes the queued figures into _DrawList and clears the queue
+  void Flush(
+      ImDrawList * _DrawList
+    );
+
+private: // Types
+
+  struct Figure
+  {
+    ImVec2 ScreenPos;
+    float  Height;
+    ImU32  Color;
+    Shape  Kind;
+    bool   Filled;
+  };
+
+private: // Service
+
+  void EmitBlock(
+      ImDrawList * _DrawList,
+      std::size_t  _FigureBegin,
+      std::size_t  _FigureEnd,
+      int          _VtxCount,
+      int          _IdxCount
+    ) const;
+
+  static int GetVtxCount(
+      const Figure & _Figure
+    );
+
+  static int GetIdxCount(
+      const Figure & _Figure
+    );
+
+private: // Members
+
+  std::vector<Figure> m_Figures;
+};
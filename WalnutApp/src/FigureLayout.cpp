@@ -0,0 +1,271 @@
+#include "FigureLayout.h"
+
+#if defined(__AVX2__)
+  #define FIGURE_LAYOUT_AVX2
+  #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define FIGURE_LAYOUT_SSE2
+  #include <emmintrin.h>
+#endif
+
+//
+// Interface
+//
+
+void FigureLayout::Clear()
+{
+  m_Start.clear();
+  m_Duration.clear();
+  m_Velocity.clear();
+  m_Key.clear();
+  m_BaseColor.clear();
+  Shape.clear();
+}
+
+void FigureLayout::Add(
+    float              _Start,
+    float              _Duration,
+    uint8_t            _Velocity,
+    uint8_t            _Key,
+    ImU32              _Color,
+    FigureBatch::Shape _Shape
+  )
+{
+  m_Start.push_back(_Start);
+  m_Duration.push_back(_Duration);
+  m_Velocity.push_back(_Velocity);
+  m_Key.push_back(_Key);
+  m_BaseColor.push_back(_Color & 0x00ffffff);
+  Shape.push_back(_Shape);
+}
+
+void FigureLayout::Compute(
+    const Frame & _Frame
+  )
+{
+  ResizeResults();
+  ComputeScalar(_Frame, ComputeVector(_Frame), GetCount());
+}
+
+void FigureLayout::ComputeReference(
+    const Frame & _Frame
+  )
+{
+  ResizeResults();
+  ComputeScalar(_Frame, 0, GetCount());
+}
+
+std::size_t FigureLayout::GetCount() const
+{
+  return m_Start.size();
+}
+
+const char * FigureLayout::GetVectorName()
+{
+#if defined(FIGURE_LAYOUT_AVX2)
+  return "AVX2";
+#elif defined(FIGURE_LAYOUT_SSE2)
+  return "SSE2";
+#else
+  return "none";
+#endif
+}
+
+//
+// Service
+//
+
+void FigureLayout::ResizeResults()
+{
+  const auto Count = GetCount();
+
+  X.resize(Count);
+  Y.resize(Count);
+  Size.resize(Count);
+  Color.resize(Count);
+  Filled.resize(Count);
+}
+
+// Reference version of the kernel. The vector versions perform the same
+// operations in the same order, so all of them give identical results
+void FigureLayout::ComputeScalar(
+    const Frame & _Frame,
+    std::size_t   _Begin,
+    std::size_t   _End
+  )
+{
+  const float Right      = _Frame.ScreenPos.x + _Frame.Width;
+  const float RightToMid = _Frame.ScreenPos.x + _Frame.Width / 2 - Right;
+
+  for (auto i = _Begin; i < _End; ++i)
+  {
+    const float Start  = m_Start[i];
+    const float Height = _Frame.FigureHeight * (m_Velocity[i] / 127.0f);
+
+    // Appearing figures slide in from the right edge, growing with the
+    // cubic ease; started ones shrink and fade over the note duration
+    float Appear = 1 - (Start - _Frame.Time) / _Frame.HalfScreenTime;
+    Appear = Appear * Appear * Appear;
+
+    const float Disappear = (_Frame.Time - Start) / m_Duration[i];
+    const float Shrink    = 1 - Disappear * Disappear * Disappear;
+
+    const bool IsAppearing = Start > _Frame.Time;
+    const bool IsVisible   = IsAppearing || Disappear < 1;
+
+    float Opacity = IsVisible ? (IsAppearing ? Appear : 1 - Disappear) : 0;
+    Opacity = Opacity > 0 ? Opacity : 0;
+    Opacity = Opacity < 1 ? Opacity : 1;
+
+    X[i]      = IsAppearing
+      ? Right + Appear * RightToMid
+      : _Frame.ScreenPos.x + (Start - _Frame.TrackOffset) * _Frame.PixelPerSec;
+    Y[i]      = _Frame.ScreenPos.y + ((_Frame.MaxNote - m_Key[i]) + 1) * _Frame.NoteHeight;
+    Size[i]   = IsVisible ? Height * (IsAppearing ? Appear : Shrink) : 0;
+    Color[i]  = m_BaseColor[i] | (static_cast<ImU32>(static_cast<int>(255 * Opacity)) << 24);
+    Filled[i] = !IsAppearing;
+  }
+}
+
+#if defined(FIGURE_LAYOUT_AVX2)
+
+std::size_t FigureLayout::ComputeVector(
+    const Frame & _Frame
+  )
+{
+  const auto Count = GetCount() / 8 * 8;
+
+  const __m256 Zero        = _mm256_setzero_ps();
+  const __m256 One         = _mm256_set1_ps(1);
+  const __m256 MaxVelocity = _mm256_set1_ps(127);
+  const __m256 MaxAlpha    = _mm256_set1_ps(255);
+  const __m256 Time        = _mm256_set1_ps(_Frame.Time);
+  const __m256 HalfTime    = _mm256_set1_ps(_Frame.HalfScreenTime);
+  const __m256 Right       = _mm256_set1_ps(_Frame.ScreenPos.x + _Frame.Width);
+  const __m256 RightToMid  = _mm256_set1_ps(_Frame.ScreenPos.x + _Frame.Width / 2 - (_Frame.ScreenPos.x + _Frame.Width));
+  const __m256 Left        = _mm256_set1_ps(_Frame.ScreenPos.x);
+  const __m256 Top         = _mm256_set1_ps(_Frame.ScreenPos.y);
+  const __m256 TrackOffset = _mm256_set1_ps(_Frame.TrackOffset);
+  const __m256 PixelPerSec = _mm256_set1_ps(_Frame.PixelPerSec);
+  const __m256 FigHeight   = _mm256_set1_ps(_Frame.FigureHeight);
+  const __m256 MaxNote     = _mm256_set1_ps(_Frame.MaxNote);
+  const __m256 NoteHeight  = _mm256_set1_ps(_Frame.NoteHeight);
+
+  for (std::size_t i = 0; i < Count; i += 8)
+  {
+    const __m256 Start  = _mm256_loadu_ps(&m_Start[i]);
+    const __m256 Height = _mm256_mul_ps(FigHeight, _mm256_div_ps(_mm256_loadu_ps(&m_Velocity[i]), MaxVelocity));
+
+    __m256 Appear = _mm256_sub_ps(One, _mm256_div_ps(_mm256_sub_ps(Start, Time), HalfTime));
+    Appear = _mm256_mul_ps(_mm256_mul_ps(Appear, Appear), Appear);
+
+    const __m256 Disappear = _mm256_div_ps(_mm256_sub_ps(Time, Start), _mm256_loadu_ps(&m_Duration[i]));
+    const __m256 Shrink    = _mm256_sub_ps(One, _mm256_mul_ps(_mm256_mul_ps(Disappear, Disappear), Disappear));
+
+    const __m256 IsAppearing = _mm256_cmp_ps(Start, Time, _CMP_GT_OQ);
+    const __m256 IsVisible   = _mm256_or_ps(IsAppearing, _mm256_cmp_ps(Disappear, One, _CMP_LT_OQ));
+
+    __m256 Opacity = _mm256_and_ps(IsVisible, _mm256_blendv_ps(_mm256_sub_ps(One, Disappear), Appear, IsAppearing));
+    Opacity = _mm256_max_ps(Opacity, Zero);
+    Opacity = _mm256_min_ps(Opacity, One);
+
+    const __m256 AppearX    = _mm256_add_ps(Right, _mm256_mul_ps(Appear, RightToMid));
+    const __m256 DisappearX = _mm256_add_ps(Left, _mm256_mul_ps(_mm256_sub_ps(Start, TrackOffset), PixelPerSec));
+    const __m256 KeyY       = _mm256_add_ps(_mm256_sub_ps(MaxNote, _mm256_loadu_ps(&m_Key[i])), One);
+    const __m256 Scale      = _mm256_blendv_ps(Shrink, Appear, IsAppearing);
+    const __m256i Alpha     = _mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(MaxAlpha, Opacity)), 24);
+    const __m256i BaseColor = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&m_BaseColor[i]));
+
+    _mm256_storeu_ps(&X[i], _mm256_blendv_ps(DisappearX, AppearX, IsAppearing));
+    _mm256_storeu_ps(&Y[i], _mm256_add_ps(Top, _mm256_mul_ps(KeyY, NoteHeight)));
+    _mm256_storeu_ps(&Size[i], _mm256_and_ps(IsVisible, _mm256_mul_ps(Height, Scale)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(&Color[i]), _mm256_or_si256(BaseColor, Alpha));
+
+    const int AppearingMask = _mm256_movemask_ps(IsAppearing);
+
+    for (int Lane = 0; Lane < 8; ++Lane)
+      Filled[i + Lane] = !((AppearingMask >> Lane) & 1);
+  }
+
+  return Count;
+}
+
+#elif defined(FIGURE_LAYOUT_SSE2)
+
+std::size_t FigureLayout::ComputeVector(
+    const Frame & _Frame
+  )
+{
+  const auto Count = GetCount() / 4 * 4;
+
+  const __m128 Zero        = _mm_setzero_ps();
+  const __m128 One         = _mm_set1_ps(1);
+  const __m128 MaxVelocity = _mm_set1_ps(127);
+  const __m128 MaxAlpha    = _mm_set1_ps(255);
+  const __m128 Time        = _mm_set1_ps(_Frame.Time);
+  const __m128 HalfTime    = _mm_set1_ps(_Frame.HalfScreenTime);
+  const __m128 Right       = _mm_set1_ps(_Frame.ScreenPos.x + _Frame.Width);
+  const __m128 RightToMid  = _mm_set1_ps(_Frame.ScreenPos.x + _Frame.Width / 2 - (_Frame.ScreenPos.x + _Frame.Width));
+  const __m128 Left        = _mm_set1_ps(_Frame.ScreenPos.x);
+  const __m128 Top         = _mm_set1_ps(_Frame.ScreenPos.y);
+  const __m128 TrackOffset = _mm_set1_ps(_Frame.TrackOffset);
+  const __m128 PixelPerSec = _mm_set1_ps(_Frame.PixelPerSec);
+  const __m128 FigHeight   = _mm_set1_ps(_Frame.FigureHeight);
+  const __m128 MaxNote     = _mm_set1_ps(_Frame.MaxNote);
+  const __m128 NoteHeight  = _mm_set1_ps(_Frame.NoteHeight);
+
+  // SSE2 has no blend, select with masks instead
+  const auto Select = [](__m128 _Mask, __m128 _IfTrue, __m128 _IfFalse)
+  {
+    return _mm_or_ps(_mm_and_ps(_Mask, _IfTrue), _mm_andnot_ps(_Mask, _IfFalse));
+  };
+
+  for (std::size_t i = 0; i < Count; i += 4)
+  {
+    const __m128 Start  = _mm_loadu_ps(&m_Start[i]);
+    const __m128 Height = _mm_mul_ps(FigHeight, _mm_div_ps(_mm_loadu_ps(&m_Velocity[i]), MaxVelocity));
+
+    __m128 Appear = _mm_sub_ps(One, _mm_div_ps(_mm_sub_ps(Start, Time), HalfTime));
+    Appear = _mm_mul_ps(_mm_mul_ps(Appear, Appear), Appear);
+
+    const __m128 Disappear = _mm_div_ps(_mm_sub_ps(Time, Start), _mm_loadu_ps(&m_Duration[i]));
+    const __m128 Shrink    = _mm_sub_ps(One, _mm_mul_ps(_mm_mul_ps(Disappear, Disappear), Disappear));
+
+    const __m128 IsAppearing = _mm_cmpgt_ps(Start, Time);
+    const __m128 IsVisible   = _mm_or_ps(IsAppearing, _mm_cmplt_ps(Disappear, One));
+
+    __m128 Opacity = _mm_and_ps(IsVisible, Select(IsAppearing, Appear, _mm_sub_ps(One, Disappear)));
+    Opacity = _mm_max_ps(Opacity, Zero);
+    Opacity = _mm_min_ps(Opacity, One);
+
+    const __m128 AppearX    = _mm_add_ps(Right, _mm_mul_ps(Appear, RightToMid));
+    const __m128 DisappearX = _mm_add_ps(Left, _mm_mul_ps(_mm_sub_ps(Start, TrackOffset), PixelPerSec));
+    const __m128 KeyY       = _mm_add_ps(_mm_sub_ps(MaxNote, _mm_loadu_ps(&m_Key[i])), One);
+    const __m128 Scale      = Select(IsAppearing, Appear, Shrink);
+    const __m128i Alpha     = _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(MaxAlpha, Opacity)), 24);
+    const __m128i BaseColor = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&m_BaseColor[i]));
+
+    _mm_storeu_ps(&X[i], Select(IsAppearing, AppearX, DisappearX));
+    _mm_storeu_ps(&Y[i], _mm_add_ps(Top, _mm_mul_ps(KeyY, NoteHeight)));
+    _mm_storeu_ps(&Size[i], _mm_and_ps(IsVisible, _mm_mul_ps(Height, Scale)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(&Color[i]), _mm_or_si128(BaseColor, Alpha));
+
+    const int AppearingMask = _mm_movemask_ps(IsAppearing);
+
+    for (int Lane = 0; Lane < 4; ++Lane)
+      Filled[i + Lane] = !((AppearingMask >> Lane) & 1);
+  }
+
+  return Count;
+}
+
+#else
+
+std::size_t FigureLayout::ComputeVector(
+    const Frame & /*_Frame*/
+  )
+{
+  return 0;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "FigureBatch.h"
+#include "imgui.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// Position, size and color of the animation figures of one frame. The
+// visible notes are gathered with Add, then Compute evaluates the easing
+// and fading of all of them at once, with SSE or AVX when the build
+// targets it and a scalar loop otherwise. Results are indexed like the
+// added notes; figures which have fully faded out get a zero Size.
+//
+class FigureLayout
+{
+public: // Types
+
+  struct Frame
+  {
+    ImVec2 ScreenPos;       // top left corner of the animation view
+    float  Width;           // width of the animation view
+    float  Time;
+    float  HalfScreenTime;
+    float  TrackOffset;     // time at the left edge of the view
+    float  PixelPerSec;
+    float  FigureHeight;    // height of a figure at full velocity
+    float  MaxNote;
+    float  NoteHeight;
+  };
+
+public: // Members
+
+  std::vector<float>              X;
+  std::vector<float>              Y;
+  std::vector<float>              Size;
+  std::vector<ImU32>              Color;
+  std::vector<uint8_t>            Filled;
+  std::vector<FigureBatch::Shape> Shape;
+
+public: // Interface
+
+  void Clear();
+
+  // _Color is the color of the figure without opacity
+  void Add(
+      float              _Start,
+      float              _Duration,
+      uint8_t            _Velocity,
+      uint8_t            _Key,
+      ImU32              _Color,
+      FigureBatch::Shape _Shape
+    );
+
+  void Compute(
+      const Frame & _Frame
+    );
+
+  // Compute with the scalar kernel only, the reference the vector kernel
+  // matches bit for bit
+  void ComputeReference(
+      const Frame & _Frame
+    );
+
+  std::size_t GetCount() const;
+
+  // Instruction set of the vector kernel in this build, "none" without one
+  static const char * GetVectorName();
+
+private: // Service
+
+  void ResizeResults();
+
+  void ComputeScalar(
+      const Frame & _Frame,
+      std::size_t   _Begin,
+      std::size_t   _End
+    );
+
+  std::size_t ComputeVector(
+      const Frame & _Frame
+    );
+
+private: // Members
+
+  std::vector<float> m_Start;
+  std::vector<float> m_Duration;
+  std::vector<float> m_Velocity;
+  std::vector<float> m_Key;
+  std::vector<ImU32> m_BaseColor;
+};
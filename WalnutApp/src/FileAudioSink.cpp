@@ -0,0 +1,145 @@
+#include "FileAudioSink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+//
+// Construction
+//
+
+FileAudioSink::FileAudioSink(
+    const std::string & _FilePath
+  )
+  : m_FilePath(_FilePath)
+{
+}
+
+FileAudioSink::~FileAudioSink()
+{
+  Stop();
+}
+
+//
+// AudioSink
+//
+
+bool FileAudioSink::Start(
+    int            _SampleRate,
+    RenderCallback _Callback
+  )
+{
+  Stop();
+
+  if (!m_FilePath.empty())
+  {
+    m_File = std::fopen(m_FilePath.c_str(), "wb");
+
+    if (m_File == nullptr)
+      return false;
+  }
+
+  m_SampleRate    = _SampleRate;
+  m_Callback      = std::move(_Callback);
+  m_StopRequested = false;
+  m_PulledFrames  = 0;
+  m_PlayedFrames  = 0;
+
+  if (m_File != nullptr)
+    WriteWavHeader(m_File, m_SampleRate, 0);
+
+  m_Puller = std::async(std::launch::async, &FileAudioSink::PullLoop, this);
+
+  return true;
+}
+
+void FileAudioSink::Stop()
+{
+  if (!m_Puller.valid())
+    return;
+
+  m_StopRequested = true;
+  m_Puller.get();
+
+  if (m_File != nullptr)
+  {
+    // Sizes are known now
+    std::fseek(m_File, 0, SEEK_SET);
+    WriteWavHeader(m_File, m_SampleRate, m_PulledFrames);
+    std::fclose(m_File);
+    m_File = nullptr;
+  }
+}
+
+bool FileAudioSink::IsPlaying() const
+{
+  return m_Puller.valid();
+}
+
+uint64_t FileAudioSink::GetPlayedFrames() const
+{
+  return m_PlayedFrames;
+}
+
+//
+// Interface
+//
+
+void FileAudioSink::WriteWavHeader(
+    FILE     * _File,
+    int        _SampleRate,
+    uint64_t   _FrameCount
+  )
+{
+  const uint32_t DataSize = static_cast<uint32_t>(_FrameCount * 2 * sizeof(int16_t));
+
+  const auto Write32 = [_File](uint32_t _Value) { std::fwrite(&_Value, 4, 1, _File); };
+  const auto Write16 = [_File](uint16_t _Value) { std::fwrite(&_Value, 2, 1, _File); };
+
+  std::fwrite("RIFF", 1, 4, _File);
+  Write32(36 + DataSize);
+  std::fwrite("WAVEfmt ", 1, 8, _File);
+  Write32(16);
+  Write16(1);                   // PCM
+  Write16(2);                   // channels
+  Write32(_SampleRate);
+  Write32(_SampleRate * 4);     // bytes per second
+  Write16(4);                   // bytes per frame
+  Write16(16);                  // bits per sample
+  std::fwrite("data", 1, 4, _File);
+  Write32(DataSize);
+}
+
+//
+// Service
+//
+
+void FileAudioSink::PullLoop()
+{
+  const auto Period = std::chrono::duration<double>(static_cast<double>(BUFFER_FRAMES) / m_SampleRate);
+
+  const auto Start = std::chrono::steady_clock::now();
+
+  m_Mix.resize(BUFFER_FRAMES * 2);
+  m_Samples.resize(BUFFER_FRAMES * 2);
+
+  while (!m_StopRequested)
+  {
+    m_Callback(m_Mix.data(), BUFFER_FRAMES);
+    m_PulledFrames += BUFFER_FRAMES;
+
+    if (m_File != nullptr)
+    {
+      for (std::size_t SampleIdx = 0; SampleIdx < m_Mix.size(); ++SampleIdx)
+        m_Samples[SampleIdx] = static_cast<int16_t>(std::clamp(m_Mix[SampleIdx], -1.0f, 1.0f) * 32767);
+
+      std::fwrite(m_Samples.data(), sizeof(int16_t), m_Samples.size(), m_File);
+    }
+
+    // Deadlines are counted from the start, so oversleeping does not drift
+    const auto Deadline = Start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(Period * static_cast<double>(m_PulledFrames / BUFFER_FRAMES));
+    std::this_thread::sleep_until(Deadline);
+
+    m_PlayedFrames = m_PulledFrames.load();
+  }
+}
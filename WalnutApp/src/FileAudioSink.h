@@ -0,0 +1,71 @@
+#pragma once
+
+#include "AudioSink.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <vector>
+
+//
+// Sink without an audio device, for headless machines. It pulls frames in
+// real time like a device would and appends them to a 16-bit WAV file, or
+// discards them when no file is given.
+//
+class FileAudioSink : public AudioSink
+{
+public: // Constants
+
+  static constexpr std::size_t BUFFER_FRAMES = 1024;
+
+public: // Construction
+
+  // An empty _FilePath discards the audio
+  FileAudioSink(
+      const std::string & _FilePath = {}
+    );
+
+  ~FileAudioSink() override;
+
+public: // AudioSink
+
+  bool Start(
+      int            _SampleRate,
+      RenderCallback _Callback
+    ) override;
+
+  void Stop() override;
+
+  bool IsPlaying() const override;
+
+  // A buffer counts as played once its period has passed
+  uint64_t GetPlayedFrames() const override;
+
+public: // Interface
+
+  // Header of a 16-bit stereo WAV file with _FrameCount frames of data
+  static void WriteWavHeader(
+      FILE     * _File,
+      int        _SampleRate,
+      uint64_t   _FrameCount
+    );
+
+private: // Service
+
+  void PullLoop();
+
+private: // Members
+
+  std::string           m_FilePath;
+  FILE *                m_File       = nullptr;
+  int                   m_SampleRate = 0;
+  RenderCallback        m_Callback;
+  std::vector<float>    m_Mix;
+  std::vector<int16_t>  m_Samples;
+  std::future<void>     m_Puller;
+  std::atomic<bool>     m_StopRequested { false };
+  std::atomic<uint64_t> m_PulledFrames  { 0 };
+  std::atomic<uint64_t> m_PlayedFrames  { 0 };
+};
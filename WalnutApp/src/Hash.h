@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a. Pass the previous result as _Hash to hash several blocks
+inline uint64_t HashBytes(
+    const void  * _Data,
+    std::size_t   _Size,
+    uint64_t      _Hash = 0xcbf29ce484222325ull
+  )
+{
+  const auto * Bytes = static_cast<const unsigned char *>(_Data);
+
+  for (std::size_t i = 0; i < _Size; ++i)
+  {
+    _Hash ^= Bytes[i];
+    _Hash *= 0x100000001b3ull;
+  }
+
+  return _Hash;
+}
@@ -1,9 +1,12 @@
 #include "MidiVisualization.h"
+#include "OfflineAudioRenderer.h"
 #include "windows.h"
 #include "imgui.h"
 
-#include <optional>
+#include <algorithm>
+#include <cstdio>
 #include <filesystem>
+#include <thread>
 
 //
 // Service
@@ -42,11 +45,6 @@ ImVec2 operator/(ImVec2 lhs, float rhs)
   return ImVec2{ lhs.x / rhs, lhs.y / rhs };
 }
 
-float Lerp(float a, float b, float t)
-{
-  return a + t * (b - a);
-}
-
 ImVec2 CalculateEllipsePoint(ImVec2 _EllipseSize, float _T)
 {
   return { _EllipseSize.x + _EllipseSize.x * std::cos(_T), _EllipseSize.y + _EllipseSize.y * std::sin(_T) };
@@ -100,215 +98,55 @@ float GetFitSize()
   return min(Size.x, Size.y);
 }
 
-float EaseInCubic(float x)
+std::string GetNoteName(int _Key)
 {
-  return x * x * x;
-}
-
-} // namespace
+  static const char * NAMES[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
 
-//
-// Animation
-//
-
-ImU32 MixColor(
-    ImU32 _Color,
-    float _Opacity
-  )
-{
-  return (_Color & 0x00ffffff) | (static_cast<ImU32>(0xff * _Opacity) << 24);
+  return NAMES[_Key % 12] + std::to_string(_Key / 12 - 1);
 }
 
-void DrawCircle(
-    ImVec2 _ScreenPos,
-    float  _Height,
-    bool   _Filled,
-    float  _Opacity,
-    ImU32  _Color
-  )
+std::string GetSongLabel(const std::string & _FileName, const SongInfo * _Info)
 {
-  if (_Filled)
-    ImGui::GetWindowDrawList()->AddCircleFilled(_ScreenPos, _Height / 2, MixColor(_Color, _Opacity));
-  else
-    ImGui::GetWindowDrawList()->AddCircle(_ScreenPos, _Height / 2, MixColor(_Color, _Opacity));
-}
+  if (_Info == nullptr)
+    return _FileName + "  (scanning...)";
 
-void DrawTriangle(
-    ImVec2 _ScreenPos,
-    float  _Height,
-    bool   _Filled,
-    float  _Opacity,
-    ImU32  _Color
-  )
-{
-  ImGui::GetWindowDrawList()->PathClear();
+  if (!_Info->IsValid)
+    return _FileName + "  (unreadable)";
 
-  //                                 sqrt(3)
-  const float Side = (2 * _Height) / 1.732050807568877;
-  const float Half = _Height / 2;
+  const int Seconds = static_cast<int>(_Info->Duration);
 
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(        0, -Half));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2( Side / 2,  Half));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(-Side / 2,  Half));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(        0, -Half));
+  char Buffer[128];
+  std::snprintf(Buffer, sizeof(Buffer), "  %d:%02d, %d tracks, %d notes", Seconds / 60, Seconds % 60, _Info->TrackCount, _Info->NoteCount);
 
-  if (_Filled)
-    ImGui::GetWindowDrawList()->PathFillConvex(MixColor(_Color, _Opacity));
-  else
-    ImGui::GetWindowDrawList()->PathStroke(MixColor(_Color, _Opacity));
-}
+  std::string Label = _FileName + Buffer;
 
-void DrawTriangleUpsideDown(
-    ImVec2 _ScreenPos,
-    float  _Height,
-    bool   _Filled,
-    float  _Opacity,
-    ImU32  _Color
-  )
-{
-  ImGui::GetWindowDrawList()->PathClear();
-
-  //                                 sqrt(3)
-  const float Side = (2 * _Height) / 1.732050807568877;
-  const float Half = _Height / 2;
-
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(        0,  Half));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2( Side / 2, -Half));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(-Side / 2, -Half));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(        0,  Half));
-
-  if (_Filled)
-    ImGui::GetWindowDrawList()->PathFillConvex(MixColor(_Color, _Opacity));
-  else
-    ImGui::GetWindowDrawList()->PathStroke(MixColor(_Color, _Opacity));
-}
+  if (_Info->NoteCount > 0)
+    Label += ", " + GetNoteName(_Info->MinKey) + "-" + GetNoteName(_Info->MaxKey);
 
-void DrawSquare(
-    ImVec2 _ScreenPos,
-    float  _Height,
-    bool   _Filled,
-    float  _Opacity,
-    ImU32  _Color
-  )
-{
-  const auto Offset = ImVec2(_Height / 2, _Height / 2);
-
-  if (_Filled)
-    ImGui::GetWindowDrawList()->AddRectFilled(_ScreenPos - Offset, _ScreenPos + Offset, MixColor(_Color, _Opacity));
-  else
-    ImGui::GetWindowDrawList()->AddRect(_ScreenPos - Offset, _ScreenPos + Offset, MixColor(_Color, _Opacity));
+  return Label;
 }
 
-void DrawRhombus(
-    ImVec2 _ScreenPos,
-    float  _Height,
-    bool   _Filled,
-    float  _Opacity,
-    ImU32  _Color
-  )
-{
-  ImGui::GetWindowDrawList()->PathClear();
-
-  const float Half = _Height / 2;
-
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(    0, -Half));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2( Half,     0));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(    0,  Half));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(-Half,     0));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(    0, -Half));
-
-  if (_Filled)
-    ImGui::GetWindowDrawList()->PathFillConvex(MixColor(_Color, _Opacity));
-  else
-    ImGui::GetWindowDrawList()->PathStroke(MixColor(_Color, _Opacity));
-}
+} // namespace
 
-void DrawPentagon(
-    ImVec2 _ScreenPos,
-    float  h,
-    bool   _Filled,
-    float  _Opacity,
-    ImU32  _Color
-  )
-{
-  ImGui::GetWindowDrawList()->PathClear();
-
-  const float a = h * 0.6498393924658126;
-  const float d = a * 1.618033988749895;
-  const float y = std::sqrt(h * h - d * d) / 2;
-
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(     0, -h / 2));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2( d / 2,     -y));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2( a / 2,  h / 2));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(-a / 2,  h / 2));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(-d / 2,     -y));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(     0, -h / 2));
-
-  if (_Filled)
-    ImGui::GetWindowDrawList()->PathFillConvex(MixColor(_Color, _Opacity));
-  else
-    ImGui::GetWindowDrawList()->PathStroke(MixColor(_Color, _Opacity));
-}
+//
+// Animation
+//
 
-void DrawHexagon(
-    ImVec2 _ScreenPos,
-    float  h,
-    bool   _Filled,
-    float  _Opacity,
-    ImU32  _Color
+ImU32 MixColor(
+    ImU32 _Color,
+    float _Opacity
   )
 {
-  ImGui::GetWindowDrawList()->PathClear();
-
-  const float a   = h * 0.5773502691896258;
-  const float a_2 = a / 2;
-  const float h_2 = h / 2;
-
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2( a_2, -h_2));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(   a,    0));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2( a_2,  h_2));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(-a_2,  h_2));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(  -a,    0));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2(-a_2, -h_2));
-  ImGui::GetWindowDrawList()->PathLineTo(_ScreenPos + ImVec2( a_2, -h_2));
-
-  if (_Filled)
-    ImGui::GetWindowDrawList()->PathFillConvex(MixColor(_Color, _Opacity));
-  else
-    ImGui::GetWindowDrawList()->PathStroke(MixColor(_Color, _Opacity));
+  return (_Color & 0x00ffffff) | (static_cast<ImU32>(0xff * _Opacity) << 24);
 }
 
-struct DrawTrackSetup
-{
-  void(*DrawFunction)(ImVec2, float, bool, float, ImU32);
-  ImU32 Color;
-};
-
-const std::vector<DrawTrackSetup> TRACK_SETUPS {
-    { &DrawCircle,             0x12B0FF },
-    { &DrawTriangle,           0xA3C54D },
-    { &DrawSquare,             0xA3DAEE },
-    { &DrawRhombus,            0x9CACE9 },
-    { &DrawPentagon,           0x3F82FE },
-    { &DrawHexagon,            0x92780F },
-    { &DrawTriangleUpsideDown, 0x729CB5 },
-    { &DrawCircle,             0xA88F7A },
-    { &DrawTriangle,           0x3854A2 },
-    { &DrawSquare,             0x8C5633 },
-    { &DrawRhombus,            0x465D57 },
-    { &DrawPentagon,           0x7B6171 },
-    { &DrawHexagon,            0x3F39D1 },
-    { &DrawTriangleUpsideDown, 0xF2F0EE },
-    { &DrawCircle,             0x9B9CA0 },
-    { &DrawTriangle,           0x4C3D3B },
-  };
-
 //
 // Constants
 //
 
 const std::string MidiVisualization::FILES_DIR = "rsc";
-const std::string MidiVisualization::TEMP_FILE = "TempFile.wav";
+const std::string MidiVisualization::CACHE_DIR = "rsc_cache";
+const std::string MidiVisualization::AUDIO_CACHE_DIR = "rsc_cache\\audio";
 
 //
 // Walnut::Layer
@@ -316,13 +154,24 @@ const std::string MidiVisualization::TEMP_FILE = "TempFile.wav";
 
 void MidiVisualization::OnAttach()
 {
+  m_MidiFile.setReadThreadCount(0);
+  m_MidiFile.setEventArena(true);
   RescanDirectory();
 }
 
+void MidiVisualization::OnDetach()
+{
+  StopPlaying();
+  StopAudioRender();
+}
+
 void MidiVisualization::OnUIRender()
 {
   const bool WaitProcess = IsFileProcessing();
 
+  // Picks up the rendered audio once it is cached
+  IsAudioRendering();
+
   ImGui::Begin("Midi");
   RenderFileControls();
 
@@ -350,11 +199,12 @@ void MidiVisualization::OnUIRender()
 }
 
 void MidiVisualization::OnUpdate(
-    float _DeltaTime
+    float /*_DeltaTime*/
   )
 {
-  if (m_IsPlaying && m_Time < m_MidiFile.getFileDurationInSeconds())
-    m_Time += _DeltaTime;
+  // Follow the audio rather than summing frame times, which drift from it
+  if (m_IsPlaying && m_Time < m_Song.Duration)
+    m_Time = static_cast<float>(m_Clock.Update(m_Stream.GetPlayedTime()));
 }
 
 //
@@ -390,13 +240,32 @@ void MidiVisualization::RenderFileControls()
       StopPlaying();
   }
 
+  if (m_IsPlaying)
+  {
+    const auto Statistics = m_Stream.GetStatistics();
+
+    ImGui::Text("Buffered %.0f ms, underruns %llu",
+      1000.0 * Statistics.BufferedFrames / Synthesizer::SAMPLE_RATE,
+      static_cast<unsigned long long>(Statistics.Underruns));
+  }
+
+  if (m_AudioRenderFuture.valid())
+    ImGui::Text("Caching audio");
+
+  if (m_Catalog.IsBuilding())
+    ImGui::Text("Indexing %zu / %zu", m_Catalog.GetScannedCount(), m_Catalog.GetFileCount());
+
   ImGui::BeginDisabled(IsFileProcessing());
   if (ImGui::BeginCombo("##Combo", m_FileName.c_str()))
   {
-    for (const auto & Entry : m_DirectoryFiles)
+    for (std::size_t FileIdx = 0; FileIdx < m_DirectoryFiles.size(); ++FileIdx)
     {
-      const bool IsSelected = (Entry == m_FileName);
-      if (ImGui::Selectable(Entry.c_str(), IsSelected))
+      const auto & Entry      = m_DirectoryFiles[FileIdx];
+      const auto   Label      = GetSongLabel(Entry, m_Catalog.GetInfo(FileIdx));
+      const bool   IsSelected = (Entry == m_FileName);
+
+      ImGui::PushID(static_cast<int>(FileIdx));
+      if (ImGui::Selectable((Label + "###Song").c_str(), IsSelected))
       {
         m_FileName = Entry;
         m_IsProcessed = false;
@@ -404,6 +273,7 @@ void MidiVisualization::RenderFileControls()
       }
       if (IsSelected)
         ImGui::SetItemDefaultFocus();
+      ImGui::PopID();
     }
     ImGui::EndCombo();
   }
@@ -441,14 +311,14 @@ void MidiVisualization::RenderMidiContent()
     m_TrackOffset -= DragDelta.x / m_PixelPerSecond;
   }
 
-  for (int TrackIdx = 0; TrackIdx < m_MidiFile.getTrackCount(); ++TrackIdx)
+  const auto & Notes = m_Song.Notes;
+
+  for (int TrackIdx = 0; TrackIdx < m_Song.GetTrackCount(); ++TrackIdx)
   {
-    const auto & Track      = m_MidiFile[TrackIdx];
-    const auto   EventCount = Track.getEventCount();
-    const auto   MinNote    = m_TrackNoteRange[TrackIdx].first;
-    const auto   MaxNote    = m_TrackNoteRange[TrackIdx].second;
+    const auto   MinNote    = m_Song.TrackNoteRange[TrackIdx].first;
+    const auto   MaxNote    = m_Song.TrackNoteRange[TrackIdx].second;
     const auto   NoteRange  = MaxNote - MinNote + 1;
-    const auto   Message    = m_TrackMetaMessage[TrackIdx];
+    const auto & Message    = m_Song.TrackMetaMessage[TrackIdx];
 
     ImGui::PushID(TrackIdx);
 
@@ -463,33 +333,65 @@ void MidiVisualization::RenderMidiContent()
       ImGui::TreePop();
     }
 
+    // Tracks scrolled out of view draw nothing, so skip their notes
+    const bool IsTrackVisible = ImGui::IsRectVisible(ImVec2(1, NoteRange * m_NoteHeight));
+
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
     ImGui::BeginChild("##Track", ImVec2(-1, NoteRange * m_NoteHeight), true);
 
     const auto P = ImGui::GetCursorScreenPos();
 
-    for (int EventIdx = 0; EventIdx < EventCount; ++EventIdx)
+    const auto VisibleFrom = TrackOffset;
+    const auto VisibleTo   = TrackOffset + ImGui::GetWindowWidth() / m_PixelPerSecond;
+
+    // Zoomed out, notes are drawn as runs of the density pyramid, which
+    // gives at most one rect per (pixel column, key)
+    const auto Level = m_NoteDensity.SelectLevel(m_PixelPerSecond);
+
+    if (IsTrackVisible && Level >= 0)
     {
-      const auto & Event = Track[EventIdx];
+      const auto CellDuration = m_NoteDensity.GetCellDuration(Level);
 
-      if (!Event.isNoteOn())
-        continue;
+      for (int Key = static_cast<int>(MinNote); Key <= static_cast<int>(MaxNote); ++Key)
+      {
+        const auto [RunBegin, RunEnd] = m_NoteDensity.FindRuns(TrackIdx, Level, Key, VisibleFrom, VisibleTo);
 
-      const auto BeginPos = ImVec2(
-          P.x + (Event.seconds - TrackOffset) * m_PixelPerSecond,
-          P.y + (MaxNote - Event.getKeyNumber()) * m_NoteHeight
-        );
+        for (auto Run = RunBegin; Run != RunEnd; ++Run)
+        {
+          const auto BeginPos = ImVec2(
+              P.x + (Run->Begin * CellDuration - TrackOffset) * m_PixelPerSecond,
+              P.y + (MaxNote - Key) * m_NoteHeight
+            );
+
+          const auto EndPos = ImVec2(
+              P.x + (Run->End * CellDuration - TrackOffset) * m_PixelPerSecond,
+              BeginPos.y + m_NoteHeight
+            );
+
+          ImGui::GetWindowDrawList()->AddRectFilled(
+            BeginPos,
+            EndPos,
+            MixColor(0xffffffff, 0.25f + 0.75f * Run->Coverage / 255)
+          );
+        }
+      }
+    }
 
-      const auto EndPos = ImVec2(
-          BeginPos.x + Event.getDurationInSeconds() * m_PixelPerSecond - 1,
-          BeginPos.y + m_NoteHeight
+    // Zoomed in, note rects are copied from cached chunks, translated by
+    // the scroll offset
+    if (IsTrackVisible && Level < 0)
+    {
+      m_NoteGeometry.Draw(
+          ImGui::GetWindowDrawList(),
+          Notes,
+          TrackIdx,
+          MaxNote,
+          P,
+          VisibleFrom,
+          VisibleTo - VisibleFrom,
+          m_PixelPerSecond,
+          m_NoteHeight
         );
-
-      ImGui::GetWindowDrawList()->AddRectFilled(
-        BeginPos,
-        EndPos,
-        0xffffffff
-      );
     }
 
     ImGui::GetWindowDrawList()->AddLine(
@@ -520,93 +422,18 @@ void MidiVisualization::RenderAnimation()
 
   ImGui::Separator();
 
-  const auto AvailSize      = ImGui::GetContentRegionAvail();
-  const auto HalfScreenTime = AvailSize.x / (2 * m_Anim.PixelPerSec);
-  const auto TrackOffset    = m_Time - HalfScreenTime;
-  const auto NoteRange      = m_Anim.MaxNote - m_Anim.MinNote + 1;
-  const auto NoteHeight     = AvailSize.y / (NoteRange + 1);
-
   ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
   ImGui::BeginChild("##Animation", ImVec2(-1, -1));
 
-  const auto P = ImGui::GetCursorScreenPos();
-
-  int DrawSetupIdx = 0;
-
-  for (int TrackIdx = 0; TrackIdx < m_MidiFile.getTrackCount(); ++TrackIdx)
-  {
-    const auto & Track      = m_MidiFile[TrackIdx];
-    const auto   EventCount = Track.getEventCount();
-
-    if (!m_TrackHasNote[TrackIdx])
-      continue;
-
-    const auto & DrawSetup = TRACK_SETUPS.at(DrawSetupIdx++ % TRACK_SETUPS.size());
-
-    for (int EventIdx = 0; EventIdx < EventCount; ++EventIdx)
-    {
-      const auto & Event = Track[EventIdx];
-
-      if (!Event.isNoteOn())
-        continue;
-
-      auto ScreenPos = P + ImVec2(
-          (Event.seconds - TrackOffset) * m_Anim.PixelPerSec,
-          (m_Anim.MaxNote - Event.getKeyNumber() + 1) * NoteHeight
-        );
-
-      if (Event.seconds < TrackOffset || Event.seconds > m_Time + HalfScreenTime)
-        continue;
-
-      if (Event.seconds > m_Time)
-      {
-        const auto AppearingProgress = EaseInCubic(1 - (Event.seconds - m_Time) / HalfScreenTime);
-
-        ScreenPos.x = Lerp(P.x + AvailSize.x, P.x + AvailSize.x / 2, AppearingProgress);
-
-        DrawSetup.DrawFunction(
-            ScreenPos,
-            m_Anim.FigureHeight * (Event.getVelocity() / 127.0f) * AppearingProgress,
-            false,
-            AppearingProgress,
-            DrawSetup.Color
-          );
-      }
-      else
-      {
-        const float DisappearingProgress = (m_Time - Event.seconds) / Event.getDurationInSeconds();
-
-        if (DisappearingProgress < 1)
-          DrawSetup.DrawFunction(
-            ScreenPos,
-            m_Anim.FigureHeight * (Event.getVelocity() / 127.0f) * (1 - EaseInCubic(DisappearingProgress)),
-            true,
-            1 - DisappearingProgress,
-            DrawSetup.Color
-          );
-      }
-    }
-  }
-
-  if (m_Anim.RenderGrid)
-  {
-    ImGui::GetWindowDrawList()->AddLine(
-      P + ImVec2((m_Time - TrackOffset) * m_Anim.PixelPerSec, 0),
-      P + ImVec2((m_Time - TrackOffset) * m_Anim.PixelPerSec, AvailSize.y),
-      0xff1111ff
+  m_Scene.Draw(
+      ImGui::GetWindowDrawList(),
+      m_Song,
+      m_Anim,
+      m_Time,
+      ImGui::GetCursorScreenPos(),
+      ImGui::GetContentRegionAvail()
     );
 
-    for (auto i = m_Anim.MinNote; i <= m_Anim.MaxNote; ++i)
-    {
-      const auto y = (m_Anim.MaxNote - i + 1) * NoteHeight;
-
-      ImGui::GetWindowDrawList()->AddLine(
-        P + ImVec2(0, y), P + ImVec2(AvailSize.x, y),
-        0xff1111ff
-      );
-    }
-  }
-
   ImGui::EndChild();
   ImGui::PopStyleVar();
 }
@@ -622,6 +449,10 @@ void MidiVisualization::StartProcessFile(
   if (m_IsPlaying)
     StopPlaying();
 
+  // Both read the song which is about to be replaced
+  StopAudioRender();
+  m_CachedAudio.Clear();
+
   m_ProcessFileFuture = std::async(std::launch::async, &MidiVisualization::ProcessFile, this, _FileName);
 }
 
@@ -629,95 +460,40 @@ void MidiVisualization::ProcessFile(
     const std::string & _FileName
   )
 {
-  std::string Parameters = FILES_DIR + "\\" + _FileName + " -Ow -o " + FILES_DIR + "\\" + TEMP_FILE;
-
-  SHELLEXECUTEINFOA ShExecInfo = { 0 };
-  ShExecInfo.cbSize = sizeof(SHELLEXECUTEINFO);
-  ShExecInfo.fMask = SEE_MASK_NOCLOSEPROCESS;
-  ShExecInfo.hwnd = NULL;
-  ShExecInfo.lpVerb = NULL;
-  ShExecInfo.lpFile = "C:\\Program Files\\TiMidity++-2.15.0\\timidity.exe";
-  ShExecInfo.lpParameters = Parameters.c_str();
-  ShExecInfo.lpDirectory = NULL;
-  ShExecInfo.nShow = SW_HIDE;
-  ShExecInfo.hInstApp = NULL;
-  ShellExecuteExA(&ShExecInfo);
-
-  m_MidiFile.read(FILES_DIR + "\\" + _FileName);
+  const auto FilePath = FILES_DIR + "\\" + _FileName;
 
-  m_MidiFile.doTimeAnalysis();
-  m_MidiFile.linkNotePairs();
-
-  const auto TrackCount = m_MidiFile.getTrackCount();
-
-  m_TrackNoteRange.assign(TrackCount, { 0.0f, 0.0f });
-  m_TrackMetaMessage.assign(TrackCount, "");
-  m_TrackHasNote.assign(TrackCount, false);
-  m_FirstNoteTime = FLT_MAX;
-
-  std::optional<float> GlobalMinNote;
-  std::optional<float> GlobalMaxNote;
-
-  for (int TrackIdx = 0; TrackIdx < TrackCount; ++TrackIdx)
+  if (!m_SongCache.Load(FilePath, m_Song))
   {
-    std::optional<float> TrackMinNote;
-    std::optional<float> TrackMaxNote;
-
-    for (int EventIdx = 0; EventIdx < m_MidiFile[TrackIdx].size(); ++EventIdx)
-    {
-      auto & Event = m_MidiFile[TrackIdx][EventIdx];
-
-      if (Event.isNoteOn())
-      {
-        m_TrackHasNote[TrackIdx] = true;
-
-        if (Event.seconds < m_FirstNoteTime)
-          m_FirstNoteTime = Event.seconds;
-
-        const auto Note = Event.getKeyNumber();
-
-        if (!TrackMinNote.has_value() || Note < TrackMinNote.value())
-          TrackMinNote = Note;
-
-        if (!TrackMaxNote.has_value() || Note > TrackMaxNote.value())
-          TrackMaxNote = Note;
-      }
-
-      if (Event.isMeta())
-      {
-        const std::string EventMessage = Event.getMetaContent().c_str();
-
-        if (!EventMessage.empty())
-        {
-          if (!m_TrackMetaMessage[TrackIdx].empty())
-            m_TrackMetaMessage[TrackIdx].append("\n");
-          m_TrackMetaMessage[TrackIdx].append(EventMessage);
-        }
-      }
-    }
-
-    if (TrackMinNote.has_value() && TrackMaxNote.has_value())
+    // A file which cannot be read shows as empty and is not cached, so
+    // it is read again next time
+    if (m_MidiFile.read(FilePath))
     {
-      m_TrackNoteRange[TrackIdx] = { TrackMinNote.value(), TrackMaxNote.value() };
-
-      if (!GlobalMinNote.has_value() || TrackMinNote.value() < GlobalMinNote.value())
-        GlobalMinNote = TrackMinNote.value();
+      m_MidiFile.doTimeAnalysis();
+      m_MidiFile.linkNotePairs();
 
-      if (!GlobalMaxNote.has_value() || TrackMaxNote.value() > GlobalMaxNote.value())
-        GlobalMaxNote = TrackMaxNote.value();
+      m_Song.Build(m_MidiFile);
+      m_SongCache.Store(FilePath, m_Song);
     }
+    else
+      m_Song.Clear();
   }
 
-  if (GlobalMinNote.has_value() && GlobalMaxNote.has_value())
+  m_NoteDensity.Build(m_Song.Notes);
+
+  if (m_Song.HasNotes())
   {
-    m_Anim.MinNote = GlobalMinNote.value();
-    m_Anim.MaxNote = GlobalMaxNote.value();
+    m_Anim.MinNote = m_Song.MinNote;
+    m_Anim.MaxNote = m_Song.MaxNote;
   }
 
-  m_Time = m_FirstNoteTime - 0.4;
+  m_Synth.SetNotes(m_Song.Notes);
+
+  m_HasAudioKey = AudioCache::MakeKey(FilePath, m_AudioKey);
 
-  WaitForSingleObject(ShExecInfo.hProcess, INFINITE);
-  CloseHandle(ShExecInfo.hProcess);
+  if (m_HasAudioKey)
+    m_AudioCache.Load(m_AudioKey, m_CachedAudio);
+
+  m_Time = m_Song.FirstNoteTime - 0.4;
 }
 
 bool MidiVisualization::IsFileProcessing()
@@ -729,22 +505,71 @@ bool MidiVisualization::IsFileProcessing()
   {
     m_ProcessFileFuture.get();
     m_IsProcessed = true;
+    m_Scene.Invalidate();
+    m_NoteGeometry.Clear();
+
+    if (m_HasAudioKey && m_CachedAudio.IsEmpty())
+    {
+      m_AudioRenderCancel = false;
+      m_AudioRenderFuture = std::async(std::launch::async, &MidiVisualization::RenderAudio, this);
+    }
   }
 
   return m_ProcessFileFuture.valid();
 }
 
+bool MidiVisualization::RenderAudio()
+{
+  auto Settings = OfflineAudioRenderer::GetDefaultSettings(m_Song);
+
+  // One core stays with the playback, which may be streaming meanwhile
+  const auto CoreCount = std::thread::hardware_concurrency();
+  Settings.ThreadCount = CoreCount > 1 ? CoreCount - 1 : 1;
+
+  std::vector<int16_t> Samples;
+
+  if (!OfflineAudioRenderer::Render(m_Song.Notes, Settings, Samples, &m_AudioRenderCancel))
+    return false;
+
+  return m_AudioCache.Store(m_AudioKey, Samples.data(), Samples.size() / Synthesizer::CHANNEL_COUNT);
+}
+
+bool MidiVisualization::IsAudioRendering()
+{
+  if (!m_AudioRenderFuture.valid())
+    return false;
+
+  // Playback in progress keeps the synthesizer, the next one uses the cache
+  if (m_AudioRenderFuture.wait_for(std::chrono::milliseconds{ 0 }) == std::future_status::ready)
+    if (m_AudioRenderFuture.get())
+      m_AudioCache.Load(m_AudioKey, m_CachedAudio);
+
+  return m_AudioRenderFuture.valid();
+}
+
+void MidiVisualization::StopAudioRender()
+{
+  if (!m_AudioRenderFuture.valid())
+    return;
+
+  m_AudioRenderCancel = true;
+  m_AudioRenderFuture.get();
+}
+
 void MidiVisualization::StartPlaying()
 {
-  std::string TempFile = FILES_DIR + "\\" + TEMP_FILE;
-  PlaySoundA(TempFile.c_str(), NULL, SND_ASYNC);
-  m_Time = m_FirstNoteTime - 0.4;
-  m_IsPlaying = true;
+  m_Time = m_Song.FirstNoteTime - 0.4;
+  // Cached audio plays without synthesizing
+  AudioSource & Source = m_CachedAudio.IsEmpty() ? static_cast<AudioSource &>(m_Synth) : m_CachedAudio;
+
+  m_IsPlaying = m_Stream.Start(Source, m_Time, m_Audio);
+  m_Clock.Start(m_Time);
+  m_Scene.Invalidate();
 }
 
 void MidiVisualization::StopPlaying()
 {
-  PlaySoundA(NULL, NULL, SND_ASYNC);
+  m_Stream.Stop();
   m_IsPlaying = false;
 }
 
@@ -761,4 +586,6 @@ void MidiVisualization::RescanDirectory()
     if (Path.has_extension() && Path.extension() == ".mid")
       m_DirectoryFiles.emplace_back(Path.filename().string());
   }
+
+  m_Catalog.Start(FILES_DIR, m_DirectoryFiles);
 }
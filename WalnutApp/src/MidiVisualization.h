@@ -1,8 +1,21 @@
 #pragma once
 
 #include "Walnut/Layer.h"
+#include "AnimationScene.h"
+#include "AudioCache.h"
+#include "AudioOutput.h"
+#include "AudioStream.h"
+#include "CachedAudio.h"
 #include "MidiFile.h"
-
+#include "NoteDensity.h"
+#include "NoteGeometryCache.h"
+#include "PlaybackClock.h"
+#include "Song.h"
+#include "SongCache.h"
+#include "SongCatalog.h"
+#include "Synthesizer.h"
+
+#include <atomic>
 #include <future>
 #include <vector>
 #include <string>
@@ -12,6 +25,9 @@ class MidiVisualization : public Walnut::Layer
 public: // Members
 
   smf::MidiFile m_MidiFile;
+  Song          m_Song;
+  NoteDensity   m_NoteDensity;
+  SongCache     m_SongCache { CACHE_DIR };
   std::string   m_FileName;
 
   float m_TrackOffset    = 0;
@@ -21,34 +37,37 @@ public: // Members
   bool  m_Follow         = false;
   bool  m_IsPlaying      = false;
 
-  std::vector<std::pair<float, float>> m_TrackNoteRange;
-  std::vector<std::string>             m_TrackMetaMessage;
-  std::vector<bool>                    m_TrackHasNote;
-  float                                m_FirstNoteTime = FLT_MAX;
-
   std::future<void>        m_ProcessFileFuture;
   std::vector<std::string> m_DirectoryFiles;
+  SongCatalog              m_Catalog;
   bool                     m_IsProcessed;
-
-  struct {
-
-    float MinNote      = -1;
-    float MaxNote      = -1;
-    float FigureHeight = 100;
-    float PixelPerSec  = 300;
-    bool  RenderGrid   = false;
-
-  } m_Anim;
+  NoteGeometryCache        m_NoteGeometry;
+  AnimationScene           m_Scene;
+  Synthesizer              m_Synth;
+  AudioOutput              m_Audio;
+  AudioCache               m_AudioCache { AUDIO_CACHE_DIR };
+  CachedAudio              m_CachedAudio;
+  uint64_t                 m_AudioKey    = 0;
+  bool                     m_HasAudioKey = false;
+  std::future<bool>        m_AudioRenderFuture;
+  std::atomic<bool>        m_AudioRenderCancel { false };
+  AudioStream              m_Stream;
+  PlaybackClock            m_Clock;
+
+  AnimationScene::Settings m_Anim;
 
 private: // Constants
 
   static const std::string FILES_DIR;
-  static const std::string TEMP_FILE;
+  static const std::string CACHE_DIR;
+  static const std::string AUDIO_CACHE_DIR;
 
 public: // Walnut::Layer
 
   void OnAttach() override;
 
+  void OnDetach() override;
+
   void OnUIRender() override;
 
   void OnUpdate(
@@ -75,6 +94,12 @@ private: // Service
 
   bool IsFileProcessing();
 
+  bool RenderAudio();
+
+  bool IsAudioRendering();
+
+  void StopAudioRender();
+
   void StartPlaying();
 
   void StopPlaying();
@@ -0,0 +1,245 @@
+#include "NoteDensity.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+//
+// Service
+//
+
+namespace
+{
+
+// Run of a key while the pyramid is built, with the time its notes cover
+// in cells of its level
+struct PendingRun
+{
+  uint32_t Begin;
+  uint32_t End;
+  double   Covered;
+};
+
+uint8_t ToCoverage(float _Share)
+{
+  return static_cast<uint8_t>(std::clamp(std::ceil(_Share * 255), 1.0f, 255.0f));
+}
+
+// Appends cells [_Begin, _End) holding _Covered cells of notes, joining the
+// last run when they touch it. Expects the cells in order
+void AddCells(
+    std::vector<PendingRun> & _Runs,
+    uint32_t                  _Begin,
+    uint32_t                  _End,
+    double                    _Covered
+  )
+{
+  if (!_Runs.empty() && _Begin <= _Runs.back().End)
+  {
+    _Runs.back().End      = std::max(_Runs.back().End, _End);
+    _Runs.back().Covered += _Covered;
+  }
+  else
+  {
+    _Runs.push_back({ _Begin, _End, _Covered });
+  }
+}
+
+void AddInterval(
+    std::vector<PendingRun> & _Runs,
+    double                    _From,
+    double                    _To
+  )
+{
+  AddCells(_Runs, static_cast<uint32_t>(_From), static_cast<uint32_t>(std::ceil(_To)), _To - _From);
+}
+
+} // namespace
+
+//
+// Interface
+//
+
+void NoteDensity::Build(
+    const NoteTable & _Notes
+  )
+{
+  Clear();
+
+  const auto TrackCount = _Notes.GetTrackCount();
+
+  m_Levels.assign(LEVEL_COUNT, std::vector<TrackLevel>(TrackCount));
+
+  std::vector<std::size_t> KeyNotes;  // notes of the track grouped by key, each key by start time
+  std::vector<PendingRun>  Runs;
+  std::vector<PendingRun>  CoarseRuns;
+
+  for (int TrackIdx = 0; TrackIdx < TrackCount; ++TrackIdx)
+  {
+    const auto NoteBegin = _Notes.GetTrackBegin(TrackIdx);
+    const auto NoteEnd   = _Notes.GetTrackEnd(TrackIdx);
+
+    if (NoteBegin == NoteEnd)
+      continue;
+
+    // Counting sort by key keeps the start order of the track within a key
+    std::array<std::size_t, 129> KeyBegin = {};
+
+    for (auto NoteIdx = NoteBegin; NoteIdx < NoteEnd; ++NoteIdx)
+      ++KeyBegin[_Notes.Key[NoteIdx] + 1];
+
+    for (std::size_t Key = 0; Key < 128; ++Key)
+      KeyBegin[Key + 1] += KeyBegin[Key];
+
+    auto KeyNext = KeyBegin;
+
+    KeyNotes.resize(NoteEnd - NoteBegin);
+
+    for (auto NoteIdx = NoteBegin; NoteIdx < NoteEnd; ++NoteIdx)
+      KeyNotes[KeyNext[_Notes.Key[NoteIdx]]++] = NoteIdx;
+
+    int MinKey = 0;
+    int MaxKey = 127;
+
+    while (KeyBegin[MinKey + 1] == 0)
+      ++MinKey;
+
+    while (KeyBegin[MaxKey] == KeyBegin[MaxKey + 1])
+      --MaxKey;
+
+    for (int Level = 0; Level < LEVEL_COUNT; ++Level)
+    {
+      m_Levels[Level][TrackIdx].MinKey = MinKey;
+      m_Levels[Level][TrackIdx].KeyBegin.reserve(MaxKey - MinKey + 2);
+    }
+
+    for (int Key = MinKey; Key <= MaxKey; ++Key)
+    {
+      // Base level from the notes, overlapping notes covering their union
+      Runs.clear();
+
+      double From = 0;
+      double To   = -1;
+
+      for (auto OrderIdx = KeyBegin[Key]; OrderIdx < KeyBegin[Key + 1]; ++OrderIdx)
+      {
+        const auto NoteIdx = KeyNotes[OrderIdx];
+
+        const double NoteFrom = std::max(_Notes.Start[NoteIdx], 0.0f) * static_cast<double>(BASE_CELLS_PER_SECOND);
+        const double NoteTo   = std::max(_Notes.Start[NoteIdx] + _Notes.Duration[NoteIdx], 0.0f) * static_cast<double>(BASE_CELLS_PER_SECOND);
+
+        if (NoteTo <= NoteFrom)
+          continue;
+
+        if (NoteFrom <= To)
+        {
+          To = std::max(To, NoteTo);
+          continue;
+        }
+
+        if (From < To)
+          AddInterval(Runs, From, To);
+
+        From = NoteFrom;
+        To   = NoteTo;
+      }
+
+      if (From < To)
+        AddInterval(Runs, From, To);
+
+      // Each level above halves the cells of the runs below
+      for (int Level = 0; Level < LEVEL_COUNT; ++Level)
+      {
+        if (Level > 0)
+        {
+          CoarseRuns.clear();
+
+          for (const auto & Run : Runs)
+            AddCells(CoarseRuns, Run.Begin / 2, (Run.End + 1) / 2, Run.Covered / 2);
+
+          Runs.swap(CoarseRuns);
+        }
+
+        auto & Track = m_Levels[Level][TrackIdx];
+
+        Track.KeyBegin.push_back(static_cast<uint32_t>(Track.Runs.size()));
+
+        for (const auto & Run : Runs)
+        {
+          Track.Runs.push_back({
+              Run.Begin,
+              Run.End,
+              static_cast<uint8_t>(Key),
+              ToCoverage(static_cast<float>(Run.Covered / (Run.End - Run.Begin)))
+            });
+        }
+      }
+    }
+
+    for (int Level = 0; Level < LEVEL_COUNT; ++Level)
+    {
+      auto & Track = m_Levels[Level][TrackIdx];
+
+      Track.KeyBegin.push_back(static_cast<uint32_t>(Track.Runs.size()));
+      Track.Runs.shrink_to_fit();
+    }
+  }
+}
+
+void NoteDensity::Clear()
+{
+  m_Levels.clear();
+}
+
+int NoteDensity::SelectLevel(
+    float _PixelPerSecond
+  ) const
+{
+  int Level = -1;
+
+  while (Level + 1 < LEVEL_COUNT && GetCellDuration(Level + 1) * _PixelPerSecond <= 1)
+    ++Level;
+
+  return Level;
+}
+
+float NoteDensity::GetCellDuration(
+    int _Level
+  ) const
+{
+  return std::ldexp(1.0f / BASE_CELLS_PER_SECOND, _Level);
+}
+
+std::pair<const NoteDensity::Run *, const NoteDensity::Run *> NoteDensity::FindRuns(
+    int   _TrackIdx,
+    int   _Level,
+    int   _Key,
+    float _From,
+    float _To
+  ) const
+{
+  if (_Level < 0 || _Level >= static_cast<int>(m_Levels.size()) || _TrackIdx >= static_cast<int>(m_Levels[_Level].size()))
+    return { nullptr, nullptr };
+
+  const auto & Track = m_Levels[_Level][_TrackIdx];
+
+  const auto KeyIdx = _Key - Track.MinKey;
+
+  if (KeyIdx < 0 || KeyIdx + 1 >= static_cast<int>(Track.KeyBegin.size()))
+    return { nullptr, nullptr };
+
+  const auto * KeyRuns    = Track.Runs.data() + Track.KeyBegin[KeyIdx];
+  const auto * KeyRunsEnd = Track.Runs.data() + Track.KeyBegin[KeyIdx + 1];
+
+  // Runs of a key do not overlap, so they are sorted by both ends
+  const auto CellDuration = GetCellDuration(_Level);
+  const auto FirstCell    = static_cast<uint32_t>(std::max(std::floor(_From / CellDuration), 0.0f));
+  const auto LastCell     = static_cast<uint32_t>(std::max(std::floor(_To / CellDuration), 0.0f));
+
+  const auto * First = std::upper_bound(KeyRuns, KeyRunsEnd, FirstCell,
+      [](uint32_t _Cell, const Run & _Run) { return _Cell < _Run.End; });
+  const auto * Last  = std::upper_bound(First, KeyRunsEnd, LastCell,
+      [](uint32_t _Cell, const Run & _Run) { return _Cell < _Run.Begin; });
+
+  return { First, Last };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "NoteTable.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//
+// Level-of-detail pyramid of the notes of each track for zoomed-out views.
+// A level splits time into cells of equal duration, twice as long as the
+// cells of the level below it. For each key, consecutive cells touched by
+// notes are stored as one run along with the average share of its cells
+// covered by notes, so a level never has more runs than the track has
+// notes, nor more than one run per cell.
+//
+class NoteDensity
+{
+public: // Types
+
+  struct Run
+  {
+    uint32_t Begin;     // first cell of the run at its level
+    uint32_t End;       // one past the last cell
+    uint8_t  Key;
+    uint8_t  Coverage;  // average coverage of the cells, 1..255
+  };
+
+public: // Constants
+
+  // Level 1 cells are 1/16 s, a pixel wide at 16 px/s; the piano roll
+  // zooms out to 10 px/s, so a coarser level would never be selected
+  static constexpr int   LEVEL_COUNT           = 2;
+  static constexpr float BASE_CELLS_PER_SECOND = 32;
+
+public: // Interface
+
+  void Build(
+      const NoteTable & _Notes
+    );
+
+  void Clear();
+
+  // Coarsest level whose cells are at most one pixel wide, or -1 when the
+  // zoom is close enough to draw the notes themselves
+  int SelectLevel(
+      float _PixelPerSecond
+    ) const;
+
+  float GetCellDuration(
+      int _Level
+    ) const;
+
+  // Runs of the key in the track overlapping [_From, _To], ordered by time
+  std::pair<const Run *, const Run *> FindRuns(
+      int   _TrackIdx,
+      int   _Level,
+      int   _Key,
+      float _From,
+      float _To
+    ) const;
+
+private: // Types
+
+  struct TrackLevel
+  {
+    int                   MinKey = 0;
+    std::vector<uint32_t> KeyBegin;  // runs of MinKey + i are [KeyBegin[i], KeyBegin[i + 1])
+    std::vector<Run>      Runs;
+  };
+
+private: // Members
+
+  // m_Levels[Level][TrackIdx]
+  std::vector<std::vector<TrackLevel>> m_Levels;
+};
@@ -0,0 +1,142 @@
+#include "NoteGeometryCache.h"
+#include "imgui_internal.h"
+
+#include <algorithm>
+
+//
+// Interface
+//
+
+void NoteGeometryCache::Clear()
+{
+  m_TrackChunks.clear();
+}
+
+void NoteGeometryCache::Draw(
+    ImDrawList      * _DrawList,
+    const NoteTable & _Notes,
+    int               _TrackIdx,
+    float             _MaxKey,
+    ImVec2            _ScreenPos,
+    float             _TimeOffset,
+    float             _VisibleTime,
+    float             _PixelPerSecond,
+    float             _NoteHeight
+  )
+{
+  const auto TexUvWhitePixel = _DrawList->_Data->TexUvWhitePixel;
+
+  if (_PixelPerSecond    != m_PixelPerSecond    ||
+      _NoteHeight        != m_NoteHeight        ||
+      TexUvWhitePixel.x  != m_TexUvWhitePixel.x ||
+      TexUvWhitePixel.y  != m_TexUvWhitePixel.y)
+  {
+    Clear();
+
+    m_PixelPerSecond  = _PixelPerSecond;
+    m_NoteHeight      = _NoteHeight;
+    m_TexUvWhitePixel = TexUvWhitePixel;
+  }
+
+  if (m_TrackChunks.size() != static_cast<std::size_t>(_Notes.GetTrackCount()))
+    m_TrackChunks.assign(_Notes.GetTrackCount(), {});
+
+  const auto TrackBegin = _Notes.GetTrackBegin(_TrackIdx);
+  const auto TrackEnd   = _Notes.GetTrackEnd(_TrackIdx);
+
+  auto & Chunks = m_TrackChunks[_TrackIdx];
+
+  if (Chunks.empty())
+    Chunks.resize((TrackEnd - TrackBegin + CHUNK_NOTES - 1) / CHUNK_NOTES);
+
+  const auto [NoteBegin, NoteEnd] = _Notes.FindNotesInWindow(_TrackIdx, _TimeOffset, _TimeOffset + _VisibleTime);
+
+  if (NoteBegin == NoteEnd)
+    return;
+
+  const auto FirstChunk = (NoteBegin - TrackBegin) / CHUNK_NOTES;
+  const auto LastChunk  = (NoteEnd - 1 - TrackBegin) / CHUNK_NOTES;
+
+  for (auto ChunkIdx = FirstChunk; ChunkIdx <= LastChunk; ++ChunkIdx)
+  {
+    auto & Chunk = Chunks[ChunkIdx];
+
+    if (!Chunk.IsBuilt)
+    {
+      const auto ChunkBegin = TrackBegin + ChunkIdx * CHUNK_NOTES;
+      const auto ChunkEnd   = std::min(ChunkBegin + CHUNK_NOTES, TrackEnd);
+
+      BuildChunk(Chunk, _Notes, ChunkBegin, ChunkEnd, _MaxKey);
+    }
+
+    const auto RectCount = static_cast<int>(Chunk.Vertices.size() / 4);
+    const auto Offset    = ImVec2(_ScreenPos.x + (Chunk.Time - _TimeOffset) * _PixelPerSecond, _ScreenPos.y);
+
+    _DrawList->PrimReserve(RectCount * 6, RectCount * 4);
+
+    const auto   VtxBase = _DrawList->_VtxCurrentIdx;
+    auto *       Vtx     = _DrawList->_VtxWritePtr;
+    auto *       Idx     = _DrawList->_IdxWritePtr;
+
+    for (const auto & Vertex : Chunk.Vertices)
+    {
+      *Vtx = Vertex;
+      Vtx->pos.x += Offset.x;
+      Vtx->pos.y += Offset.y;
+      ++Vtx;
+    }
+
+    for (int RectIdx = 0; RectIdx < RectCount; ++RectIdx)
+    {
+      const auto Base = static_cast<ImDrawIdx>(VtxBase + RectIdx * 4);
+
+      Idx[0] = Base;
+      Idx[1] = static_cast<ImDrawIdx>(Base + 1);
+      Idx[2] = static_cast<ImDrawIdx>(Base + 2);
+      Idx[3] = Base;
+      Idx[4] = static_cast<ImDrawIdx>(Base + 2);
+      Idx[5] = static_cast<ImDrawIdx>(Base + 3);
+      Idx += 6;
+    }
+
+    _DrawList->_VtxWritePtr    = Vtx;
+    _DrawList->_IdxWritePtr    = Idx;
+    _DrawList->_VtxCurrentIdx += RectCount * 4;
+  }
+}
+
+//
+// Service
+//
+
+void NoteGeometryCache::BuildChunk(
+    Chunk           & _Chunk,
+    const NoteTable & _Notes,
+    std::size_t       _NoteBegin,
+    std::size_t       _NoteEnd,
+    float             _MaxKey
+  ) const
+{
+  // Same rects as ImDrawList::AddRectFilled, relative to the first note so
+  // the coordinates stay small
+  const ImU32 Color = 0xffffffff;
+
+  _Chunk.Time = _Notes.Start[_NoteBegin];
+  _Chunk.Vertices.clear();
+  _Chunk.Vertices.reserve((_NoteEnd - _NoteBegin) * 4);
+
+  for (auto NoteIdx = _NoteBegin; NoteIdx < _NoteEnd; ++NoteIdx)
+  {
+    const float Left   = (_Notes.Start[NoteIdx] - _Chunk.Time) * m_PixelPerSecond;
+    const float Top    = (_MaxKey - _Notes.Key[NoteIdx]) * m_NoteHeight;
+    const float Right  = Left + _Notes.Duration[NoteIdx] * m_PixelPerSecond - 1;
+    const float Bottom = Top + m_NoteHeight;
+
+    _Chunk.Vertices.push_back({ ImVec2(Left,  Top),    m_TexUvWhitePixel, Color });
+    _Chunk.Vertices.push_back({ ImVec2(Right, Top),    m_TexUvWhitePixel, Color });
+    _Chunk.Vertices.push_back({ ImVec2(Right, Bottom), m_TexUvWhitePixel, Color });
+    _Chunk.Vertices.push_back({ ImVec2(Left,  Bottom), m_TexUvWhitePixel, Color });
+  }
+
+  _Chunk.IsBuilt = true;
+}
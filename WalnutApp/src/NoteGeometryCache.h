@@ -0,0 +1,64 @@
+#pragma once
+
+#include "NoteTable.h"
+#include "imgui.h"
+
+#include <cstddef>
+#include <vector>
+
+//
+// Vertices of the piano roll note rects, built once per track chunk for the
+// current zoom and note height and copied into the draw list with only a
+// horizontal translation on later frames. Chunks are built on first use
+// and all of them are dropped when the zoom, note height or song changes.
+//
+class NoteGeometryCache
+{
+public: // Constants
+
+  static constexpr std::size_t CHUNK_NOTES = 512;
+
+public: // Interface
+
+  void Clear();
+
+  // Draws the notes of the track which may overlap the visible window.
+  // _ScreenPos is the top left corner of the track, showing _TimeOffset
+  void Draw(
+      ImDrawList      * _DrawList,
+      const NoteTable & _Notes,
+      int               _TrackIdx,
+      float             _MaxKey,
+      ImVec2            _ScreenPos,
+      float             _TimeOffset,
+      float             _VisibleTime,
+      float             _PixelPerSecond,
+      float             _NoteHeight
+    );
+
+private: // Types
+
+  struct Chunk
+  {
+    bool                    IsBuilt = false;
+    float                   Time    = 0;  // vertex x is relative to this time
+    std::vector<ImDrawVert> Vertices;
+  };
+
+private: // Service
+
+  void BuildChunk(
+      Chunk           & _Chunk,
+      const NoteTable & _Notes,
+      std::size_t       _NoteBegin,
+      std::size_t       _NoteEnd,
+      float             _MaxKey
+    ) const;
+
+private: // Members
+
+  std::vector<std::vector<Chunk>> m_TrackChunks;
+  float                           m_PixelPerSecond = 0;
+  float                           m_NoteHeight     = 0;
+  ImVec2                          m_TexUvWhitePixel;
+};
@@ -0,0 +1,110 @@
+#include "NoteTable.h"
+
+#include <algorithm>
+
+//
+// Interface
+//
+
+void NoteTable::Build(
+    const smf::MidiFile & _MidiFile
+  )
+{
+  Clear();
+
+  const auto TrackCount = _MidiFile.getTrackCount();
+
+  std::size_t NoteCount = 0;
+
+  for (int TrackIdx = 0; TrackIdx < TrackCount; ++TrackIdx)
+    for (int EventIdx = 0; EventIdx < _MidiFile[TrackIdx].size(); ++EventIdx)
+      if (_MidiFile[TrackIdx][EventIdx].isNoteOn())
+        ++NoteCount;
+
+  Start.reserve(NoteCount);
+  Duration.reserve(NoteCount);
+  Key.reserve(NoteCount);
+  Velocity.reserve(NoteCount);
+  Channel.reserve(NoteCount);
+  Track.reserve(NoteCount);
+  TrackBegin.reserve(TrackCount + 1);
+  TrackMaxDuration.reserve(TrackCount);
+
+  for (int TrackIdx = 0; TrackIdx < TrackCount; ++TrackIdx)
+  {
+    const auto & Events = _MidiFile[TrackIdx];
+
+    TrackBegin.push_back(Start.size());
+    TrackMaxDuration.push_back(0);
+
+    for (int EventIdx = 0; EventIdx < Events.size(); ++EventIdx)
+    {
+      const auto & Event = Events[EventIdx];
+
+      if (!Event.isNoteOn())
+        continue;
+
+      Start.push_back(static_cast<float>(Event.seconds));
+      Duration.push_back(static_cast<float>(Event.getDurationInSeconds()));
+      Key.push_back(static_cast<uint8_t>(Event.getKeyNumber()));
+      Velocity.push_back(static_cast<uint8_t>(Event.getVelocity()));
+      Channel.push_back(static_cast<uint8_t>(Event.getChannelNibble()));
+      Track.push_back(static_cast<uint16_t>(TrackIdx));
+
+      TrackMaxDuration.back() = std::max(TrackMaxDuration.back(), Duration.back());
+    }
+  }
+
+  TrackBegin.push_back(Start.size());
+}
+
+void NoteTable::Clear()
+{
+  Start.clear();
+  Duration.clear();
+  Key.clear();
+  Velocity.clear();
+  Channel.clear();
+  Track.clear();
+  TrackBegin.clear();
+  TrackMaxDuration.clear();
+}
+
+std::size_t NoteTable::GetNoteCount() const
+{
+  return Start.size();
+}
+
+int NoteTable::GetTrackCount() const
+{
+  return TrackBegin.empty() ? 0 : static_cast<int>(TrackBegin.size()) - 1;
+}
+
+std::size_t NoteTable::GetTrackBegin(
+    int _TrackIdx
+  ) const
+{
+  return TrackBegin[_TrackIdx];
+}
+
+std::size_t NoteTable::GetTrackEnd(
+    int _TrackIdx
+  ) const
+{
+  return TrackBegin[_TrackIdx + 1];
+}
+
+std::pair<std::size_t, std::size_t> NoteTable::FindNotesInWindow(
+    int   _TrackIdx,
+    float _From,
+    float _To
+  ) const
+{
+  const auto TrackStart = Start.begin() + GetTrackBegin(_TrackIdx);
+  const auto TrackEnd   = Start.begin() + GetTrackEnd(_TrackIdx);
+
+  const auto First = std::lower_bound(TrackStart, TrackEnd, _From - TrackMaxDuration[_TrackIdx]);
+  const auto Last  = std::upper_bound(First, TrackEnd, _To);
+
+  return { First - Start.begin(), Last - Start.begin() };
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "MidiFile.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//
+// Notes of a processed song as parallel arrays. Notes are grouped by track
+// and kept in the track's event order, so each track range is sorted by
+// start time.
+//
+class NoteTable
+{
+public: // Members
+
+  std::vector<float>    Start;
+  std::vector<float>    Duration;
+  std::vector<uint8_t>  Key;
+  std::vector<uint8_t>  Velocity;
+  std::vector<uint8_t>  Channel;
+  std::vector<uint16_t> Track;
+
+  // Notes of track i are [TrackBegin[i], TrackBegin[i + 1])
+  std::vector<std::size_t> TrackBegin;
+
+  // Longest note of each track, bounds how far before a time window a
+  // note overlapping it can start
+  std::vector<float> TrackMaxDuration;
+
+public: // Interface
+
+  // Expects doTimeAnalysis and linkNotePairs to have been run
+  void Build(
+      const smf::MidiFile & _MidiFile
+    );
+
+  void Clear();
+
+  std::size_t GetNoteCount() const;
+
+  int GetTrackCount() const;
+
+  std::size_t GetTrackBegin(
+      int _TrackIdx
+    ) const;
+
+  std::size_t GetTrackEnd(
+      int _TrackIdx
+    ) const;
+
+  // Range of notes of the track which may overlap [_From, _To]. Notes
+  // inside the range can still end before _From
+  std::pair<std::size_t, std::size_t> FindNotesInWindow(
+      int   _TrackIdx,
+      float _From,
+      float _To
+    ) const;
+};
@@ -0,0 +1,358 @@
+#include "OfflineAudioRenderer.h"
+#include "FileAudioSink.h"
+#include "Synthesizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <future>
+#include <thread>
+
+//
+// Service
+//
+
+namespace
+{
+
+constexpr double      SEARCH_STEP_SECONDS = 0.01;
+constexpr std::size_t CHUNK_FRAMES        = 4096;
+constexpr int         CHANNEL_COUNT       = Synthesizer::CHANNEL_COUNT;
+
+struct Segment
+{
+  int64_t            Begin;        // first output frame
+  int64_t            End;
+  int64_t            Preroll = 0;   // frames rendered and dropped before the head or Begin
+  std::vector<float> Head    = {};  // crossfade before Begin, rendered by this segment
+  std::vector<float> Tail    = {};  // crossfade before End, shared with the next segment
+};
+
+// Notes sounding at a time, release included, and whether a synthesizer
+// started there renders what one started at the beginning would
+class SoundingNotes
+{
+public:
+
+  explicit SoundingNotes(
+      const NoteTable & _Notes
+    )
+  {
+    std::vector<std::pair<double, double>> Notes(_Notes.Start.size());
+
+    for (std::size_t NoteIdx = 0; NoteIdx < Notes.size(); ++NoteIdx)
+      Notes[NoteIdx] = { _Notes.Start[NoteIdx], _Notes.Start[NoteIdx] + _Notes.Duration[NoteIdx] + Synthesizer::TAIL_SECONDS };
+
+    // By start, for the starts and the latest end so far
+    std::sort(Notes.begin(), Notes.end());
+
+    m_LatestEnds.assign(1, -DBL_MAX);
+
+    for (const auto & [Start, End] : Notes)
+    {
+      m_Starts.push_back(Start);
+      m_LatestEnds.push_back(std::max(m_LatestEnds.back(), End));
+    }
+
+    // By end, for the ends and the earliest start from there on
+    std::sort(Notes.begin(), Notes.end(), [](const auto & _Lhs, const auto & _Rhs) { return _Lhs.second < _Rhs.second; });
+
+    for (const auto & [Start, End] : Notes)
+      m_Ends.push_back(End);
+
+    m_EarliestStarts.assign(Notes.size() + 1, DBL_MAX);
+
+    for (auto NoteIdx = Notes.size(); NoteIdx-- > 0;)
+      m_EarliestStarts[NoteIdx] = std::min(m_EarliestStarts[NoteIdx + 1], Notes[NoteIdx].first);
+
+    // A note starting while the pool is full takes the voice of another
+    for (const auto Start : m_Starts)
+      if (GetCount(Start) > Synthesizer::MAX_VOICES && (m_CrowdedStarts.empty() || m_CrowdedStarts.back() != Start))
+        m_CrowdedStarts.push_back(Start);
+  }
+
+  std::ptrdiff_t GetCount(
+      double _Time
+    ) const
+  {
+    return (std::upper_bound(m_Starts.begin(), m_Starts.end(), _Time) - m_Starts.begin()) -
+           (std::upper_bound(m_Ends.begin(), m_Ends.end(), _Time) - m_Ends.begin());
+  }
+
+  // Voice stealing depends on the gains of the voices to the last bit,
+  // which restored voices only approximate. Restoring is exact when no
+  // note starts into a full pool while the notes sounding at _Time do,
+  // neither before, where it may have taken one of their voices, nor after
+  bool IsRestorable(
+      double _Time
+    ) const
+  {
+    const auto EarliestStart = m_EarliestStarts[std::upper_bound(m_Ends.begin(), m_Ends.end(), _Time) - m_Ends.begin()];
+
+    if (EarliestStart > _Time)
+      return true;
+
+    const auto LatestEnd = m_LatestEnds[std::upper_bound(m_Starts.begin(), m_Starts.end(), _Time) - m_Starts.begin()];
+
+    const auto Crowded = std::lower_bound(m_CrowdedStarts.begin(), m_CrowdedStarts.end(), EarliestStart);
+
+    return Crowded == m_CrowdedStarts.end() || *Crowded > LatestEnd;
+  }
+
+private:
+
+  std::vector<double> m_Starts;
+  std::vector<double> m_LatestEnds;      // of the first i notes by start
+  std::vector<double> m_Ends;
+  std::vector<double> m_EarliestStarts;  // of the notes from the i-th end on
+  std::vector<double> m_CrowdedStarts;
+};
+
+int16_t ToSample(
+    float _Value
+  )
+{
+  return static_cast<int16_t>(std::clamp(_Value, -1.0f, 1.0f) * 32767);
+}
+
+// Cut points near multiples of the segment length, each at the time with
+// the fewest sounding notes within the search distance
+std::vector<int64_t> FindCuts(
+    const SoundingNotes                    & _Sounding,
+    const OfflineAudioRenderer::Settings   & _Settings,
+    int64_t                                  _FrameCount,
+    int64_t                                  _MinLength
+  )
+{
+  const auto SegmentFrames = std::max<int64_t>(_MinLength * 2, std::llround(_Settings.SegmentSeconds * Synthesizer::SAMPLE_RATE));
+  const auto SearchFrames  = std::min<int64_t>(std::llround(_Settings.SearchSeconds * Synthesizer::SAMPLE_RATE), SegmentFrames / 2 - _MinLength);
+  const auto StepFrames    = std::max<int64_t>(1, std::llround(SEARCH_STEP_SECONDS * Synthesizer::SAMPLE_RATE));
+
+  std::vector<int64_t> Cuts;
+
+  for (int64_t Nominal = SegmentFrames; Nominal < _FrameCount - _MinLength; Nominal += SegmentFrames)
+  {
+    int64_t BestCut   = Nominal;
+    auto    BestCount = _Sounding.GetCount(_Settings.StartTime + static_cast<double>(Nominal) / Synthesizer::SAMPLE_RATE);
+
+    for (int64_t Offset = StepFrames; Offset <= SearchFrames; Offset += StepFrames)
+    {
+      // Closer candidates first, so ties keep the cut near its place
+      for (const auto Cut : { Nominal - Offset, Nominal + Offset })
+      {
+        if (Cut <= (Cuts.empty() ? 0 : Cuts.back()) + _MinLength || Cut >= _FrameCount - _MinLength)
+          continue;
+
+        const auto Count = _Sounding.GetCount(_Settings.StartTime + static_cast<double>(Cut) / Synthesizer::SAMPLE_RATE);
+
+        if (Count < BestCount)
+        {
+          BestCut   = Cut;
+          BestCount = Count;
+        }
+      }
+    }
+
+    Cuts.push_back(BestCut);
+  }
+
+  return Cuts;
+}
+
+} // namespace
+
+//
+// Interface
+//
+
+bool OfflineAudioRenderer::Render(
+    const NoteTable         & _Notes,
+    const Settings          & _Settings,
+    std::vector<int16_t>    & _Samples,
+    const std::atomic<bool> * _Cancel
+  )
+{
+  const auto StartFrame = std::llround(_Settings.StartTime * Synthesizer::SAMPLE_RATE);
+  const auto FrameCount = std::max<int64_t>(0, std::llround(_Settings.EndTime * Synthesizer::SAMPLE_RATE) - StartFrame);
+  const auto FadeFrames = std::max<int64_t>(1, std::llround(_Settings.CrossfadeSeconds * Synthesizer::SAMPLE_RATE));
+
+  _Samples.assign(static_cast<std::size_t>(FrameCount) * CHANNEL_COUNT, 0);
+
+  const SoundingNotes Sounding(_Notes);
+
+  // Segments render on the block grid of the first one, so the voices
+  // they start go through the same steps as in a render from the start
+  const auto BlockFrames = static_cast<int64_t>(Synthesizer::BLOCK_FRAMES);
+  const auto StepFrames  = BlockFrames * std::max<int64_t>(1, std::llround(SEARCH_STEP_SECONDS * Synthesizer::SAMPLE_RATE) / BlockFrames);
+
+  const auto IsRestorable = [&](int64_t _Frame)
+  {
+    return Sounding.IsRestorable(_Settings.StartTime + static_cast<double>(_Frame) / Synthesizer::SAMPLE_RATE);
+  };
+
+  std::vector<Segment> Segments;
+
+  int64_t Begin   = 0;
+  int64_t Preroll = 0;
+
+  for (const auto Cut : FindCuts(Sounding, _Settings, FrameCount, FadeFrames))
+  {
+    // A segment starts rendering where its voices can be restored, the
+    // frames up to its head are dropped; if there is no such place after
+    // the current segment starts, the current segment goes on instead
+    auto Restore = (Cut - FadeFrames) / BlockFrames * BlockFrames;
+
+    while (Restore > Begin && !IsRestorable(Restore))
+      Restore -= StepFrames;
+
+    if (Restore <= Begin)
+      continue;
+
+    Segments.push_back({ Begin, Cut, Preroll });
+
+    Begin   = Cut;
+    Preroll = Cut - FadeFrames - Restore;
+  }
+
+  Segments.push_back({ Begin, FrameCount, Preroll });
+
+  // Sorting the notes once, the workers copy the synthesizer
+  Synthesizer Prototype;
+  Prototype.SetNotes(_Notes);
+
+  std::atomic<std::size_t> NextSegment { 0 };
+
+  const auto IsCancelled = [&]
+  {
+    return _Cancel != nullptr && *_Cancel;
+  };
+
+  const auto RenderSegments = [&]
+  {
+    auto               Synth = Prototype;
+    std::vector<float> Chunk(CHUNK_FRAMES * CHANNEL_COUNT);
+
+    for (auto SegmentIdx = NextSegment++; SegmentIdx < Segments.size() && !IsCancelled(); SegmentIdx = NextSegment++)
+    {
+      auto & Segment = Segments[SegmentIdx];
+
+      const bool HasHead = SegmentIdx > 0;
+      const bool HasTail = SegmentIdx + 1 < Segments.size();
+
+      const auto RenderBegin = Segment.Begin - (HasHead ? FadeFrames : 0);
+      const auto WriteEnd    = Segment.End - (HasTail ? FadeFrames : 0);
+
+      Segment.Head.resize(HasHead ? FadeFrames * CHANNEL_COUNT : 0);
+      Segment.Tail.resize(HasTail ? FadeFrames * CHANNEL_COUNT : 0);
+
+      const auto First = RenderBegin - Segment.Preroll;
+
+      Synth.Start(static_cast<double>(StartFrame + First) / Synthesizer::SAMPLE_RATE);
+
+      for (auto ChunkBegin = First; ChunkBegin < Segment.End && !IsCancelled(); ChunkBegin += CHUNK_FRAMES)
+      {
+        const auto ChunkFrames = std::min<int64_t>(CHUNK_FRAMES, Segment.End - ChunkBegin);
+
+        Synth.Render(Chunk.data(), static_cast<std::size_t>(ChunkFrames));
+
+        for (int64_t FrameIdx = 0; FrameIdx < ChunkFrames; ++FrameIdx)
+        {
+          const auto    Frame  = ChunkBegin + FrameIdx;
+          const float * Source = Chunk.data() + FrameIdx * CHANNEL_COUNT;
+
+          float * Fade = nullptr;
+
+          if (Frame < RenderBegin)
+            continue;
+
+          if (Frame < Segment.Begin)
+            Fade = Segment.Head.data() + (Frame - RenderBegin) * CHANNEL_COUNT;
+          else
+          if (Frame >= WriteEnd)
+            Fade = Segment.Tail.data() + (Frame - WriteEnd) * CHANNEL_COUNT;
+
+          for (int Channel = 0; Channel < CHANNEL_COUNT; ++Channel)
+          {
+            if (Fade != nullptr)
+              Fade[Channel] = Source[Channel];
+            else
+              _Samples[Frame * CHANNEL_COUNT + Channel] = ToSample(Source[Channel]);
+          }
+        }
+      }
+    }
+  };
+
+  const auto ThreadCount = std::max(1u, std::min(
+      _Settings.ThreadCount != 0 ? _Settings.ThreadCount : std::thread::hardware_concurrency(),
+      static_cast<unsigned int>(Segments.size())
+    ));
+
+  std::vector<std::future<void>> Futures;
+
+  for (unsigned int ThreadIdx = 0; ThreadIdx < ThreadCount; ++ThreadIdx)
+    Futures.push_back(std::async(std::launch::async, RenderSegments));
+
+  for (auto & Future : Futures)
+    Future.wait();
+
+  if (IsCancelled())
+    return false;
+
+  // Both sides of a seam render the same notes, a linear fade is enough
+  for (std::size_t SegmentIdx = 1; SegmentIdx < Segments.size(); ++SegmentIdx)
+  {
+    const auto & Tail = Segments[SegmentIdx - 1].Tail;
+    const auto & Head = Segments[SegmentIdx].Head;
+
+    const auto FadeBegin = Segments[SegmentIdx].Begin - FadeFrames;
+
+    for (int64_t FrameIdx = 0; FrameIdx < FadeFrames; ++FrameIdx)
+    {
+      const float Weight = (FrameIdx + 0.5f) / FadeFrames;
+
+      for (int Channel = 0; Channel < CHANNEL_COUNT; ++Channel)
+      {
+        const auto SampleIdx = FrameIdx * CHANNEL_COUNT + Channel;
+
+        _Samples[(FadeBegin + FrameIdx) * CHANNEL_COUNT + Channel] = ToSample(Tail[SampleIdx] + (Head[SampleIdx] - Tail[SampleIdx]) * Weight);
+      }
+    }
+  }
+
+  return true;
+}
+
+bool OfflineAudioRenderer::Render(
+    const NoteTable   & _Notes,
+    const Settings    & _Settings,
+    const std::string & _FilePath
+  )
+{
+  std::vector<int16_t> Samples;
+
+  Render(_Notes, _Settings, Samples);
+
+  FILE * File = std::fopen(_FilePath.c_str(), "wb");
+
+  if (File == nullptr)
+    return false;
+
+  FileAudioSink::WriteWavHeader(File, Synthesizer::SAMPLE_RATE, Samples.size() / CHANNEL_COUNT);
+
+  const bool IsWritten = std::fwrite(Samples.data(), sizeof(int16_t), Samples.size(), File) == Samples.size();
+
+  return std::fclose(File) == 0 && IsWritten;
+}
+
+OfflineAudioRenderer::Settings OfflineAudioRenderer::GetDefaultSettings(
+    const Song & _Song
+  )
+{
+  Settings Settings;
+
+  Settings.EndTime = _Song.Duration + Synthesizer::TAIL_SECONDS;
+
+  return Settings;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Song.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Renders song audio faster than real time on all cores. The song is cut
+// into segments of about SegmentSeconds, each cut moved to the quietest
+// time nearby. Workers render the segments in parallel, each synthesizer
+// starting with the notes which still sound at its segment start, and a
+// short crossfade hides the rounding differences at the seams. Which
+// notes play depends on the voice stealing before once more notes start
+// than the synthesizer has voices, so a segment starts rendering at the
+// last earlier time none of the notes sounding then overlaps such a
+// start, or is not cut off from the previous segment when there is none.
+//
+class OfflineAudioRenderer
+{
+public: // Types
+
+  struct Settings
+  {
+    double       StartTime        = 0;
+    double       EndTime          = 0;
+    unsigned int ThreadCount      = 0;     // 0 for one per core
+    double       SegmentSeconds   = 10;
+    double       SearchSeconds    = 2;     // how far a cut may move to a quieter time
+    double       CrossfadeSeconds = 0.01;
+  };
+
+public: // Interface
+
+  // Renders [StartTime, EndTime) as interleaved 16-bit stereo. Returns false
+  // if _Cancel was set
+  static bool Render(
+      const NoteTable         & _Notes,
+      const Settings          & _Settings,
+      std::vector<int16_t>    & _Samples,
+      const std::atomic<bool> * _Cancel = nullptr
+    );
+
+  // Renders to a 16-bit WAV file, returns false if it cannot be written
+  static bool Render(
+      const NoteTable   & _Notes,
+      const Settings    & _Settings,
+      const std::string & _FilePath
+    );
+
+  // Settings for the whole song up to the end of its last release
+  static Settings GetDefaultSettings(
+      const Song & _Song
+    );
+};
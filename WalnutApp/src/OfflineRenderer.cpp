@@ -0,0 +1,235 @@
+#include "OfflineRenderer.h"
+#include "SoftwareRasterizer.h"
+#include "imgui_internal.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Service
+//
+
+namespace
+{
+
+struct FrameSlot
+{
+  std::vector<uint8_t> Data;
+  bool                 IsReady = false;
+};
+
+struct Worker
+{
+  Worker(
+      ImDrawListSharedData * _SharedData
+    )
+    : DrawList(_SharedData)
+  {
+  }
+
+  AnimationScene     Scene;
+  ImDrawList         DrawList;
+  SoftwareRasterizer Rasterizer;
+};
+
+void ConvertFrame(
+    const std::vector<ImU32>  & _Pixels,
+    OfflineRenderer::Format     _Format,
+    std::vector<uint8_t>      & _Data
+  )
+{
+  if (_Format == OfflineRenderer::Format::Rgba)
+  {
+    _Data.resize(_Pixels.size() * 4);
+
+    for (std::size_t PixelIdx = 0; PixelIdx < _Pixels.size(); ++PixelIdx)
+    {
+      _Data[PixelIdx * 4 + 0] = static_cast<uint8_t>(_Pixels[PixelIdx] >>  0);
+      _Data[PixelIdx * 4 + 1] = static_cast<uint8_t>(_Pixels[PixelIdx] >>  8);
+      _Data[PixelIdx * 4 + 2] = static_cast<uint8_t>(_Pixels[PixelIdx] >> 16);
+      _Data[PixelIdx * 4 + 3] = static_cast<uint8_t>(_Pixels[PixelIdx] >> 24);
+    }
+
+    return;
+  }
+
+  // FRAME header followed by the Y, U and V planes
+  static const char FRAME_HEADER[] = "FRAME\n";
+
+  const auto PixelCount  = _Pixels.size();
+  const auto HeaderSize  = sizeof(FRAME_HEADER) - 1;
+
+  _Data.resize(HeaderSize + PixelCount * 3);
+  std::copy(FRAME_HEADER, FRAME_HEADER + HeaderSize, _Data.begin());
+
+  uint8_t * Y = _Data.data() + HeaderSize;
+  uint8_t * U = Y + PixelCount;
+  uint8_t * V = U + PixelCount;
+
+  for (std::size_t PixelIdx = 0; PixelIdx < PixelCount; ++PixelIdx)
+  {
+    const int R = (_Pixels[PixelIdx] >>  0) & 0xff;
+    const int G = (_Pixels[PixelIdx] >>  8) & 0xff;
+    const int B = (_Pixels[PixelIdx] >> 16) & 0xff;
+
+    Y[PixelIdx] = static_cast<uint8_t>((( 66 * R + 129 * G +  25 * B + 128) >> 8) +  16);
+    U[PixelIdx] = static_cast<uint8_t>(((-38 * R -  74 * G + 112 * B + 128) >> 8) + 128);
+    V[PixelIdx] = static_cast<uint8_t>(((112 * R -  94 * G -  18 * B + 128) >> 8) + 128);
+  }
+}
+
+} // namespace
+
+//
+// Interface
+//
+
+bool OfflineRenderer::Render(
+    const Song        & _Song,
+    const Settings    & _Settings,
+    const std::string & _FilePath
+  )
+{
+  FILE * File = std::fopen(_FilePath.c_str(), "wb");
+
+  if (File == nullptr)
+    return false;
+
+  if (_Settings.OutputFormat == Format::Y4m)
+    std::fprintf(File, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", _Settings.Width, _Settings.Height, _Settings.FramesPerSecond);
+
+  const auto FrameCount = std::max(0, static_cast<int>((_Settings.EndTime - _Settings.StartTime) * _Settings.FramesPerSecond) + 1);
+
+  const auto ThreadCount = std::max(1u, std::min(
+      _Settings.ThreadCount != 0 ? _Settings.ThreadCount : std::thread::hardware_concurrency(),
+      static_cast<unsigned int>(FrameCount)
+    ));
+
+  // What ImGui::NewFrame would set up for the draw lists
+  ImDrawListSharedData SharedData;
+  SharedData.ClipRectFullscreen   = ImVec4(0, 0, static_cast<float>(_Settings.Width), static_cast<float>(_Settings.Height));
+  SharedData.CurveTessellationTol = 1.25f;
+  SharedData.InitialFlags         = ImDrawListFlags_AntiAliasedLines | ImDrawListFlags_AntiAliasedFill | ImDrawListFlags_AllowVtxOffset;
+  SharedData.SetCircleTessellationMaxError(0.30f);
+
+  // Frame N is rendered into slot N % SlotCount, and only once frame
+  // N - SlotCount has been written, so memory stays bounded
+  const int SlotCount = static_cast<int>(ThreadCount) * 2;
+
+  std::vector<FrameSlot>  Slots(SlotCount);
+  std::mutex              Mutex;
+  std::condition_variable Condition;
+  int                     NextFrame    = 0;
+  int                     WrittenCount = 0;
+
+  const auto RenderFrames = [&](Worker & _Worker)
+  {
+    _Worker.Rasterizer.Resize(_Settings.Width, _Settings.Height);
+
+    for (;;)
+    {
+      int FrameIdx;
+      {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        Condition.wait(Lock, [&] { return NextFrame >= FrameCount || NextFrame < WrittenCount + SlotCount; });
+
+        if (NextFrame >= FrameCount)
+          return;
+
+        FrameIdx = NextFrame++;
+      }
+
+      // Frames of a worker come in increasing time, so its active notes
+      // keep sliding forward instead of being rebuilt
+      const float Time = _Settings.StartTime + static_cast<float>(FrameIdx) / _Settings.FramesPerSecond;
+
+      _Worker.DrawList._ResetForNewFrame();
+      _Worker.DrawList.PushClipRect(ImVec2(0, 0), ImVec2(static_cast<float>(_Settings.Width), static_cast<float>(_Settings.Height)));
+
+      _Worker.Scene.Draw(
+          &_Worker.DrawList,
+          _Song,
+          _Settings.Scene,
+          Time,
+          ImVec2(0, 0),
+          ImVec2(static_cast<float>(_Settings.Width), static_cast<float>(_Settings.Height))
+        );
+
+      _Worker.DrawList.PopClipRect();
+
+      _Worker.Rasterizer.Clear(_Settings.Background);
+      _Worker.Rasterizer.Draw(_Worker.DrawList);
+
+      auto & Slot = Slots[FrameIdx % SlotCount];
+
+      ConvertFrame(_Worker.Rasterizer.GetPixels(), _Settings.OutputFormat, Slot.Data);
+
+      {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Slot.IsReady = true;
+      }
+
+      Condition.notify_all();
+    }
+  };
+
+  std::vector<std::unique_ptr<Worker>> Workers;
+  std::vector<std::future<void>>       Futures;
+
+  for (unsigned int ThreadIdx = 0; ThreadIdx < ThreadCount; ++ThreadIdx)
+  {
+    Workers.push_back(std::make_unique<Worker>(&SharedData));
+    Futures.push_back(std::async(std::launch::async, RenderFrames, std::ref(*Workers.back())));
+  }
+
+  bool IsWritten = true;
+
+  for (int FrameIdx = 0; FrameIdx < FrameCount; ++FrameIdx)
+  {
+    auto & Slot = Slots[FrameIdx % SlotCount];
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Condition.wait(Lock, [&] { return Slot.IsReady; });
+    }
+
+    IsWritten = IsWritten && std::fwrite(Slot.Data.data(), 1, Slot.Data.size(), File) == Slot.Data.size();
+
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Slot.IsReady = false;
+      ++WrittenCount;
+    }
+
+    Condition.notify_all();
+  }
+
+  for (auto & Future : Futures)
+    Future.wait();
+
+  return std::fclose(File) == 0 && IsWritten;
+}
+
+OfflineRenderer::Settings OfflineRenderer::GetDefaultSettings(
+    const Song & _Song
+  )
+{
+  Settings Settings;
+
+  if (_Song.HasNotes())
+  {
+    Settings.Scene.MinNote = _Song.MinNote;
+    Settings.Scene.MaxNote = _Song.MaxNote;
+    Settings.StartTime     = _Song.FirstNoteTime - 0.4f;
+  }
+
+  Settings.EndTime = _Song.Duration;
+
+  return Settings;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "AnimationScene.h"
+#include "Song.h"
+#include "imgui.h"
+
+#include <string>
+
+//
+// Renders the animation view to a video file without a window or GPU.
+// Frames are taken at a fixed rate, so frame N always shows the song at
+// StartTime + N / FramesPerSecond. Each frame depends only on its time, so
+// workers render frames in parallel and the frames are written in order.
+//
+class OfflineRenderer
+{
+public: // Types
+
+  enum class Format
+  {
+    Rgba,  // raw 8-bit RGBA frames, back to back
+    Y4m    // YUV4MPEG2 stream, 4:4:4 BT.601 limited range
+  };
+
+  struct Settings
+  {
+    int                      Width           = 1920;
+    int                      Height          = 1080;
+    int                      FramesPerSecond = 60;
+    float                    StartTime       = 0;
+    float                    EndTime         = 0;
+    Format                   OutputFormat    = Format::Y4m;
+    unsigned int             ThreadCount     = 0;  // 0 for one per core
+    ImU32                    Background      = 0xff0f0f0f;
+    AnimationScene::Settings Scene;
+  };
+
+public: // Interface
+
+  // Returns false if the file cannot be written
+  static bool Render(
+      const Song        & _Song,
+      const Settings    & _Settings,
+      const std::string & _FilePath
+    );
+
+  // Settings showing the whole song like the live view plays it
+  static Settings GetDefaultSettings(
+      const Song & _Song
+    );
+};
@@ -0,0 +1,45 @@
+#include "PlaybackClock.h"
+
+#include <algorithm>
+
+//
+// Interface
+//
+
+void PlaybackClock::Start(
+    double _Time
+  )
+{
+  m_Time        = _Time;
+  m_AudioTime   = _Time;
+  m_IsAdvancing = false;
+  m_UpdateTime  = std::chrono::steady_clock::now();
+}
+
+double PlaybackClock::Update(
+    double _AudioTime
+  )
+{
+  const auto Now     = std::chrono::steady_clock::now();
+  const auto Elapsed = std::chrono::duration<double>(Now - m_UpdateTime).count();
+
+  m_UpdateTime = Now;
+
+  // Hold until the device plays, the output latency is unknown before
+  if (_AudioTime > m_AudioTime)
+    m_IsAdvancing = true;
+
+  m_AudioTime = _AudioTime;
+
+  if (m_IsAdvancing)
+    m_Time = std::clamp(m_Time + Elapsed, _AudioTime, _AudioTime + MAX_LEAD);
+  else
+    m_Time = _AudioTime;
+
+  return m_Time;
+}
+
+double PlaybackClock::GetTime() const
+{
+  return m_Time;
+}
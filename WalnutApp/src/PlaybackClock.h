@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+
+//
+// Playhead driven by an audio clock. The audio clock counts what the device
+// has played, so it is exact but advances in steps of a device buffer; in
+// between the playhead runs on with the steady clock. Every reading of the
+// audio clock is a lower bound of the heard time, so the playhead keeps the
+// tightest bound seen and never drifts from the audio.
+//
+class PlaybackClock
+{
+public: // Constants
+
+  // How far the playhead may run ahead of the audio clock, when the device
+  // stalls or its clock is slower than the steady clock
+  static constexpr double MAX_LEAD = 0.05;
+
+public: // Interface
+
+  void Start(
+      double _Time
+    );
+
+  // Takes the current audio clock time, returns the playhead
+  double Update(
+      double _AudioTime
+    );
+
+  double GetTime() const;
+
+private: // Members
+
+  double                                m_Time          = 0;
+  double                                m_AudioTime     = 0;
+  bool                                  m_IsAdvancing   = false;
+  std::chrono::steady_clock::time_point m_UpdateTime;
+};
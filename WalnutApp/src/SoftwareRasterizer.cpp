@@ -0,0 +1,477 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <thread>
+
+//
+// Service
+//
+
+namespace
+{
+
+constexpr int SUBPIXEL_BITS = 4;
+constexpr int SUBPIXEL      = 1 << SUBPIXEL_BITS;
+
+struct SnappedVertex
+{
+  int64_t X;
+  int64_t Y;
+  float   U, V;
+  float   R, G, B, A;
+};
+
+SnappedVertex Snap(
+    const ImDrawVert & _Vertex,
+    ImVec2             _Offset,
+    ImVec2             _Scale
+  )
+{
+  return {
+      static_cast<int64_t>(std::lround((_Vertex.pos.x - _Offset.x) * _Scale.x * SUBPIXEL)),
+      static_cast<int64_t>(std::lround((_Vertex.pos.y - _Offset.y) * _Scale.y * SUBPIXEL)),
+      _Vertex.uv.x,
+      _Vertex.uv.y,
+      static_cast<float>((_Vertex.col >>  0) & 0xff),
+      static_cast<float>((_Vertex.col >>  8) & 0xff),
+      static_cast<float>((_Vertex.col >> 16) & 0xff),
+      static_cast<float>((_Vertex.col >> 24) & 0xff),
+    };
+}
+
+// Edge a->b is a top or left edge of a triangle with positive area
+bool IsTopLeft(
+    const SnappedVertex & _A,
+    const SnappedVertex & _B
+  )
+{
+  const auto dx = _B.X - _A.X;
+  const auto dy = _B.Y - _A.Y;
+
+  return dy < 0 || (dy == 0 && dx > 0);
+}
+
+ImU32 Modulate(
+    ImU32 _Color,
+    ImU32 _Texel
+  )
+{
+  if (_Texel == 0xffffffff)
+    return _Color;
+
+  ImU32 Result = 0;
+
+  for (int Shift = 0; Shift < 32; Shift += 8)
+  {
+    const ImU32 Color = (_Color >> Shift) & 0xff;
+    const ImU32 Texel = (_Texel >> Shift) & 0xff;
+
+    Result |= ((Color * Texel + 127) / 255) << Shift;
+  }
+
+  return Result;
+}
+
+ImU32 Blend(
+    ImU32 _Dst,
+    ImU32 _Src
+  )
+{
+  const ImU32 Alpha = _Src >> 24;
+
+  if (Alpha == 0xff)
+    return _Src;
+
+  if (Alpha == 0)
+    return _Dst;
+
+  const ImU32 InvAlpha = 0xff - Alpha;
+
+  ImU32 Result = 0;
+
+  for (int Shift = 0; Shift < 24; Shift += 8)
+  {
+    const ImU32 Src = (_Src >> Shift) & 0xff;
+    const ImU32 Dst = (_Dst >> Shift) & 0xff;
+
+    Result |= ((Src * Alpha + Dst * InvAlpha + 127) / 255) << Shift;
+  }
+
+  const ImU32 DstAlpha = _Dst >> 24;
+
+  return Result | ((Alpha + (DstAlpha * InvAlpha + 127) / 255) << 24);
+}
+
+} // namespace
+
+//
+// Interface
+//
+
+void SoftwareRasterizer::Resize(
+    int _Width,
+    int _Height
+  )
+{
+  m_Width       = _Width;
+  m_Height      = _Height;
+  m_TileColumns = (_Width + TILE_SIZE - 1) / TILE_SIZE;
+  m_TileRows    = (_Height + TILE_SIZE - 1) / TILE_SIZE;
+
+  m_Pixels.resize(static_cast<std::size_t>(_Width) * _Height);
+  m_TileBins.resize(static_cast<std::size_t>(m_TileColumns) * m_TileRows);
+}
+
+void SoftwareRasterizer::Clear(
+    ImU32 _Color
+  )
+{
+  std::fill(m_Pixels.begin(), m_Pixels.end(), _Color);
+}
+
+void SoftwareRasterizer::SetThreadCount(
+    unsigned int _ThreadCount
+  )
+{
+  m_ThreadCount = _ThreadCount;
+}
+
+ImTextureID SoftwareRasterizer::AddTexture(
+    const ImU32 * _Pixels,
+    int           _Width,
+    int           _Height
+  )
+{
+  auto NewTexture = std::make_unique<Texture>();
+
+  NewTexture->Pixels.assign(_Pixels, _Pixels + static_cast<std::size_t>(_Width) * _Height);
+  NewTexture->Width  = _Width;
+  NewTexture->Height = _Height;
+
+  m_Textures.push_back(std::move(NewTexture));
+
+  // Ids are 1-based so that a null id means no texture
+  return reinterpret_cast<ImTextureID>(static_cast<uintptr_t>(m_Textures.size()));
+}
+
+void SoftwareRasterizer::SetFontAtlas(
+    ImFontAtlas & _Atlas
+  )
+{
+  unsigned char * Pixels;
+  int             Width;
+  int             Height;
+
+  _Atlas.GetTexDataAsRGBA32(&Pixels, &Width, &Height);
+  _Atlas.SetTexID(AddTexture(reinterpret_cast<const ImU32 *>(Pixels), Width, Height));
+}
+
+void SoftwareRasterizer::Draw(
+    const ImDrawData & _DrawData
+  )
+{
+  m_Commands.clear();
+  m_Triangles.clear();
+
+  for (int ListIdx = 0; ListIdx < _DrawData.CmdListsCount; ++ListIdx)
+    BinList(*_DrawData.CmdLists[ListIdx], _DrawData.DisplayPos, _DrawData.FramebufferScale);
+
+  RasterizeTiles();
+}
+
+void SoftwareRasterizer::Draw(
+    const ImDrawList & _DrawList
+  )
+{
+  m_Commands.clear();
+  m_Triangles.clear();
+
+  BinList(_DrawList, ImVec2(0, 0), ImVec2(1, 1));
+
+  RasterizeTiles();
+}
+
+int SoftwareRasterizer::GetWidth() const
+{
+  return m_Width;
+}
+
+int SoftwareRasterizer::GetHeight() const
+{
+  return m_Height;
+}
+
+const std::vector<ImU32> & SoftwareRasterizer::GetPixels() const
+{
+  return m_Pixels;
+}
+
+//
+// Service
+//
+
+void SoftwareRasterizer::BinList(
+    const ImDrawList & _DrawList,
+    ImVec2             _Offset,
+    ImVec2             _Scale
+  )
+{
+  for (const auto & Cmd : _DrawList.CmdBuffer)
+  {
+    if (Cmd.UserCallback != nullptr || Cmd.ElemCount == 0)
+      continue;
+
+    Command Command;
+    Command.ClipMinX = std::max(0,        static_cast<int>(std::floor((Cmd.ClipRect.x - _Offset.x) * _Scale.x)));
+    Command.ClipMinY = std::max(0,        static_cast<int>(std::floor((Cmd.ClipRect.y - _Offset.y) * _Scale.y)));
+    Command.ClipMaxX = std::min(m_Width,  static_cast<int>(std::ceil((Cmd.ClipRect.z - _Offset.x) * _Scale.x)));
+    Command.ClipMaxY = std::min(m_Height, static_cast<int>(std::ceil((Cmd.ClipRect.w - _Offset.y) * _Scale.y)));
+    Command.Image    = FindTexture(Cmd.TextureId);
+    Command.Offset   = _Offset;
+    Command.Scale    = _Scale;
+
+    if (Command.ClipMinX >= Command.ClipMaxX || Command.ClipMinY >= Command.ClipMaxY)
+      continue;
+
+    const auto CommandIdx = static_cast<uint32_t>(m_Commands.size());
+    m_Commands.push_back(Command);
+
+    const ImDrawVert * Vertices = _DrawList.VtxBuffer.Data + Cmd.VtxOffset;
+    const ImDrawIdx *  Indices  = _DrawList.IdxBuffer.Data + Cmd.IdxOffset;
+
+    for (unsigned int Elem = 0; Elem + 2 < Cmd.ElemCount; Elem += 3)
+    {
+      const Triangle Triangle {
+          { &Vertices[Indices[Elem]], &Vertices[Indices[Elem + 1]], &Vertices[Indices[Elem + 2]] },
+          CommandIdx
+        };
+
+      float MinX = Triangle.Vertices[0]->pos.x, MaxX = MinX;
+      float MinY = Triangle.Vertices[0]->pos.y, MaxY = MinY;
+
+      for (const auto * Vertex : Triangle.Vertices)
+      {
+        MinX = std::min(MinX, Vertex->pos.x);
+        MaxX = std::max(MaxX, Vertex->pos.x);
+        MinY = std::min(MinY, Vertex->pos.y);
+        MaxY = std::max(MaxY, Vertex->pos.y);
+      }
+
+      // Conservative pixel bounds, the tiles do the exact coverage
+      const int PixelMinX = std::max(Command.ClipMinX,     static_cast<int>(std::floor((MinX - _Offset.x) * _Scale.x)) - 1);
+      const int PixelMinY = std::max(Command.ClipMinY,     static_cast<int>(std::floor((MinY - _Offset.y) * _Scale.y)) - 1);
+      const int PixelMaxX = std::min(Command.ClipMaxX - 1, static_cast<int>(std::ceil((MaxX - _Offset.x) * _Scale.x)) + 1);
+      const int PixelMaxY = std::min(Command.ClipMaxY - 1, static_cast<int>(std::ceil((MaxY - _Offset.y) * _Scale.y)) + 1);
+
+      if (PixelMinX > PixelMaxX || PixelMinY > PixelMaxY)
+        continue;
+
+      const auto TriangleIdx = static_cast<uint32_t>(m_Triangles.size());
+      m_Triangles.push_back(Triangle);
+
+      for (int TileY = PixelMinY / TILE_SIZE; TileY <= PixelMaxY / TILE_SIZE; ++TileY)
+        for (int TileX = PixelMinX / TILE_SIZE; TileX <= PixelMaxX / TILE_SIZE; ++TileX)
+          m_TileBins[TileY * m_TileColumns + TileX].push_back(TriangleIdx);
+    }
+  }
+}
+
+void SoftwareRasterizer::RasterizeTiles()
+{
+  const int TileCount = static_cast<int>(m_TileBins.size());
+
+  const auto ThreadCount = std::min<unsigned int>(
+      m_ThreadCount != 0 ? m_ThreadCount : std::max(1u, std::thread::hardware_concurrency()),
+      static_cast<unsigned int>(TileCount)
+    );
+
+  if (ThreadCount <= 1)
+  {
+    for (int TileIdx = 0; TileIdx < TileCount; ++TileIdx)
+      RasterizeTile(TileIdx);
+
+    return;
+  }
+
+  std::atomic<int>               NextTile { 0 };
+  std::vector<std::future<void>> Workers;
+
+  for (unsigned int ThreadIdx = 0; ThreadIdx < ThreadCount; ++ThreadIdx)
+    Workers.push_back(std::async(std::launch::async, [&]
+      {
+        for (int TileIdx = NextTile++; TileIdx < TileCount; TileIdx = NextTile++)
+          RasterizeTile(TileIdx);
+      }));
+
+  for (auto & Worker : Workers)
+    Worker.wait();
+}
+
+void SoftwareRasterizer::RasterizeTile(
+    int _TileIdx
+  )
+{
+  auto & Bin = m_TileBins[_TileIdx];
+
+  const int TileMinX = (_TileIdx % m_TileColumns) * TILE_SIZE;
+  const int TileMinY = (_TileIdx / m_TileColumns) * TILE_SIZE;
+  const int TileMaxX = std::min(TileMinX + TILE_SIZE, m_Width);
+  const int TileMaxY = std::min(TileMinY + TILE_SIZE, m_Height);
+
+  for (const auto TriangleIdx : Bin)
+  {
+    const auto & Triangle = m_Triangles[TriangleIdx];
+    const auto & Command  = m_Commands[Triangle.CommandIdx];
+
+    DrawTriangle(
+        Triangle,
+        Command,
+        std::max(TileMinX, Command.ClipMinX),
+        std::max(TileMinY, Command.ClipMinY),
+        std::min(TileMaxX, Command.ClipMaxX),
+        std::min(TileMaxY, Command.ClipMaxY)
+      );
+  }
+
+  Bin.clear();
+}
+
+void SoftwareRasterizer::DrawTriangle(
+    const Triangle & _Triangle,
+    const Command  & _Command,
+    int              _ClipMinX,
+    int              _ClipMinY,
+    int              _ClipMaxX,
+    int              _ClipMaxY
+  )
+{
+  auto V0 = Snap(*_Triangle.Vertices[0], _Command.Offset, _Command.Scale);
+  auto V1 = Snap(*_Triangle.Vertices[1], _Command.Offset, _Command.Scale);
+  auto V2 = Snap(*_Triangle.Vertices[2], _Command.Offset, _Command.Scale);
+
+  auto Area = (V1.X - V0.X) * (V2.Y - V0.Y) - (V1.Y - V0.Y) * (V2.X - V0.X);
+
+  if (Area == 0)
+    return;
+
+  if (Area < 0)
+  {
+    std::swap(V1, V2);
+    Area = -Area;
+  }
+
+  // Pixel range whose centers may be inside the triangle
+  const auto MinX = std::max<int64_t>(_ClipMinX, (std::min({ V0.X, V1.X, V2.X }) - SUBPIXEL / 2) >> SUBPIXEL_BITS);
+  const auto MinY = std::max<int64_t>(_ClipMinY, (std::min({ V0.Y, V1.Y, V2.Y }) - SUBPIXEL / 2) >> SUBPIXEL_BITS);
+  const auto MaxX = std::min<int64_t>(_ClipMaxX, ((std::max({ V0.X, V1.X, V2.X }) - SUBPIXEL / 2) >> SUBPIXEL_BITS) + 1);
+  const auto MaxY = std::min<int64_t>(_ClipMaxY, ((std::max({ V0.Y, V1.Y, V2.Y }) - SUBPIXEL / 2) >> SUBPIXEL_BITS) + 1);
+
+  if (MinX >= MaxX || MinY >= MaxY)
+    return;
+
+  // Edge functions of the first pixel center, stepped exactly per pixel.
+  // W0 is opposite to V0, and so on
+  const auto Edge = [](const SnappedVertex & _A, const SnappedVertex & _B, int64_t _X, int64_t _Y)
+  {
+    return (_B.X - _A.X) * (_Y - _A.Y) - (_B.Y - _A.Y) * (_X - _A.X);
+  };
+
+  const auto StartX = MinX * SUBPIXEL + SUBPIXEL / 2;
+  const auto StartY = MinY * SUBPIXEL + SUBPIXEL / 2;
+
+  const int64_t StepX0 = -(V2.Y - V1.Y) * SUBPIXEL, StepY0 = (V2.X - V1.X) * SUBPIXEL;
+  const int64_t StepX1 = -(V0.Y - V2.Y) * SUBPIXEL, StepY1 = (V0.X - V2.X) * SUBPIXEL;
+  const int64_t StepX2 = -(V1.Y - V0.Y) * SUBPIXEL, StepY2 = (V1.X - V0.X) * SUBPIXEL;
+
+  // Pixels exactly on an edge belong to the triangle only for top-left
+  // edges, so test W >= Bias with a bias of 0 or 1
+  const int64_t Bias0 = IsTopLeft(V1, V2) ? 0 : 1;
+  const int64_t Bias1 = IsTopLeft(V2, V0) ? 0 : 1;
+  const int64_t Bias2 = IsTopLeft(V0, V1) ? 0 : 1;
+
+  auto Row0 = Edge(V1, V2, StartX, StartY);
+  auto Row1 = Edge(V2, V0, StartX, StartY);
+  auto Row2 = Edge(V0, V1, StartX, StartY);
+
+  const auto * Image = _Command.Image;
+
+  const auto Sample = [Image](float _U, float _V)
+  {
+    const int x = std::clamp(static_cast<int>(_U * Image->Width),  0, Image->Width - 1);
+    const int y = std::clamp(static_cast<int>(_V * Image->Height), 0, Image->Height - 1);
+
+    return Image->Pixels[static_cast<std::size_t>(y) * Image->Width + x];
+  };
+
+  const ImU32 Color0    = _Triangle.Vertices[0]->col;
+  const bool  IsFlat    = Color0 == _Triangle.Vertices[1]->col && Color0 == _Triangle.Vertices[2]->col;
+  const bool  IsUvFlat  = V0.U == V1.U && V0.U == V2.U && V0.V == V1.V && V0.V == V2.V;
+  const float InvArea   = 1.0f / static_cast<float>(Area);
+
+  // Solid fills, the white pixel of the font atlas included, use one color
+  const bool  IsSolid    = IsFlat && (Image == nullptr || IsUvFlat);
+  const ImU32 SolidColor = IsSolid && Image != nullptr ? Modulate(Color0, Sample(V0.U, V0.V)) : Color0;
+
+  for (auto y = MinY; y < MaxY; ++y)
+  {
+    auto W0 = Row0;
+    auto W1 = Row1;
+    auto W2 = Row2;
+
+    ImU32 * Row = m_Pixels.data() + y * m_Width;
+
+    for (auto x = MinX; x < MaxX; ++x)
+    {
+      if (W0 >= Bias0 && W1 >= Bias1 && W2 >= Bias2)
+      {
+        ImU32 Color = SolidColor;
+
+        if (!IsSolid)
+        {
+          const float B0 = W0 * InvArea;
+          const float B1 = W1 * InvArea;
+          const float B2 = W2 * InvArea;
+
+          const auto Channel = [&](float _C0, float _C1, float _C2)
+          {
+            return static_cast<ImU32>(std::min(255.0f, _C0 * B0 + _C1 * B1 + _C2 * B2 + 0.5f));
+          };
+
+          Color = IsFlat ? Color0
+            : Channel(V0.R, V1.R, V2.R)
+            | (Channel(V0.G, V1.G, V2.G) << 8)
+            | (Channel(V0.B, V1.B, V2.B) << 16)
+            | (Channel(V0.A, V1.A, V2.A) << 24);
+
+          if (Image != nullptr)
+            Color = Modulate(Color, Sample(V0.U * B0 + V1.U * B1 + V2.U * B2, V0.V * B0 + V1.V * B1 + V2.V * B2));
+        }
+
+        Row[x] = Blend(Row[x], Color);
+      }
+
+      W0 += StepX0;
+      W1 += StepX1;
+      W2 += StepX2;
+    }
+
+    Row0 += StepY0;
+    Row1 += StepY1;
+    Row2 += StepY2;
+  }
+}
+
+const SoftwareRasterizer::Texture * SoftwareRasterizer::FindTexture(
+    ImTextureID _TextureId
+  ) const
+{
+  const auto TextureIdx = reinterpret_cast<uintptr_t>(_TextureId);
+
+  if (TextureIdx == 0 || TextureIdx > m_Textures.size())
+    return nullptr;
+
+  return m_Textures[TextureIdx - 1].get();
+}
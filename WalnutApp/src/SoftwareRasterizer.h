@@ -0,0 +1,135 @@
+#pragma once
+
+#include "imgui.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//
+// Draws ImGui draw data into an RGBA buffer on the CPU, for rendering
+// without a window or GPU. Triangles are first sorted into bins of
+// TILE_SIZE square tiles in submission order, then the tiles are filled
+// independently, on worker threads if requested, so the result does not
+// depend on the thread count. Vertices are snapped to a 1/16 pixel grid
+// and triangles are filled with the top-left rule, so triangles sharing an
+// edge never cover a pixel twice. Colors are interpolated across the
+// triangle, modulated by the nearest texel and blended like the ImGui
+// backends do. User callbacks of draw commands are skipped.
+//
+class SoftwareRasterizer
+{
+public: // Constants
+
+  static constexpr int TILE_SIZE = 64;
+
+public: // Interface
+
+  void Resize(
+      int _Width,
+      int _Height
+    );
+
+  void Clear(
+      ImU32 _Color
+    );
+
+  // 1 (the default) fills the tiles on the calling thread; 0 uses one
+  // thread per hardware core
+  void SetThreadCount(
+      unsigned int _ThreadCount
+    );
+
+  // Copies RGBA pixels into a texture, returns its id for draw commands
+  ImTextureID AddTexture(
+      const ImU32 * _Pixels,
+      int           _Width,
+      int           _Height
+    );
+
+  // Adds the font atlas as a texture and sets its id in the atlas
+  void SetFontAtlas(
+      ImFontAtlas & _Atlas
+    );
+
+  void Draw(
+      const ImDrawData & _DrawData
+    );
+
+  void Draw(
+      const ImDrawList & _DrawList
+    );
+
+  int GetWidth() const;
+
+  int GetHeight() const;
+
+  // Row-major pixels in ImU32 layout, which is R, G, B, A in memory
+  const std::vector<ImU32> & GetPixels() const;
+
+private: // Types
+
+  struct Texture
+  {
+    std::vector<ImU32> Pixels;
+    int                Width;
+    int                Height;
+  };
+
+  struct Command
+  {
+    int             ClipMinX;
+    int             ClipMinY;
+    int             ClipMaxX;
+    int             ClipMaxY;
+    const Texture * Image;   // nullptr draws the vertex colors only
+    ImVec2          Offset;  // subtracted from vertex positions
+    ImVec2          Scale;   // then applied to them
+  };
+
+  struct Triangle
+  {
+    const ImDrawVert * Vertices[3];
+    uint32_t           CommandIdx;
+  };
+
+private: // Service
+
+  void BinList(
+      const ImDrawList & _DrawList,
+      ImVec2             _Offset,
+      ImVec2             _Scale
+    );
+
+  void RasterizeTiles();
+
+  void RasterizeTile(
+      int _TileIdx
+    );
+
+  void DrawTriangle(
+      const Triangle & _Triangle,
+      const Command  & _Command,
+      int              _ClipMinX,
+      int              _ClipMinY,
+      int              _ClipMaxX,
+      int              _ClipMaxY
+    );
+
+  const Texture * FindTexture(
+      ImTextureID _TextureId
+    ) const;
+
+private: // Members
+
+  std::vector<ImU32>                    m_Pixels;
+  int                                   m_Width       = 0;
+  int                                   m_Height      = 0;
+  int                                   m_TileColumns = 0;
+  int                                   m_TileRows    = 0;
+  unsigned int                          m_ThreadCount = 1;
+  std::vector<std::unique_ptr<Texture>> m_Textures;
+  std::vector<Command>                  m_Commands;
+  std::vector<Triangle>                 m_Triangles;
+  std::vector<std::vector<uint32_t>>    m_TileBins;
+};
@@ -0,0 +1,112 @@
+#include "Song.h"
+
+#include <algorithm>
+#include <optional>
+
+//
+// Interface
+//
+
+void Song::Build(
+    smf::MidiFile & _MidiFile
+  )
+{
+  Clear();
+
+  Notes.Build(_MidiFile);
+
+  const auto TrackCount = _MidiFile.getTrackCount();
+
+  TrackNoteRange.assign(TrackCount, { 0.0f, 0.0f });
+  TrackMetaMessage.assign(TrackCount, "");
+  TrackHasNote.assign(TrackCount, false);
+  Duration = static_cast<float>(_MidiFile.getFileDurationInSeconds());
+
+  std::optional<float> GlobalMinNote;
+  std::optional<float> GlobalMaxNote;
+
+  for (int TrackIdx = 0; TrackIdx < TrackCount; ++TrackIdx)
+  {
+    std::optional<float> TrackMinNote;
+    std::optional<float> TrackMaxNote;
+
+    for (int EventIdx = 0; EventIdx < _MidiFile[TrackIdx].size(); ++EventIdx)
+    {
+      auto & Event = _MidiFile[TrackIdx][EventIdx];
+
+      if (Event.isNoteOn())
+      {
+        TrackHasNote[TrackIdx] = true;
+
+        if (Event.seconds < FirstNoteTime)
+          FirstNoteTime = Event.seconds;
+
+        const auto Note = Event.getKeyNumber();
+
+        if (!TrackMinNote.has_value() || Note < TrackMinNote.value())
+          TrackMinNote = Note;
+
+        if (!TrackMaxNote.has_value() || Note > TrackMaxNote.value())
+          TrackMaxNote = Note;
+      }
+
+      if (Event.isTempo())
+        TempoMap.push_back({ Event.tick, Event.seconds, Event.getTempoSPT(_MidiFile.getTicksPerQuarterNote()) });
+
+      if (Event.isMeta())
+      {
+        const std::string EventMessage = Event.getMetaContent().c_str();
+
+        if (!EventMessage.empty())
+        {
+          if (!TrackMetaMessage[TrackIdx].empty())
+            TrackMetaMessage[TrackIdx].append("\n");
+          TrackMetaMessage[TrackIdx].append(EventMessage);
+        }
+      }
+    }
+
+    if (TrackMinNote.has_value() && TrackMaxNote.has_value())
+    {
+      TrackNoteRange[TrackIdx] = { TrackMinNote.value(), TrackMaxNote.value() };
+
+      if (!GlobalMinNote.has_value() || TrackMinNote.value() < GlobalMinNote.value())
+        GlobalMinNote = TrackMinNote.value();
+
+      if (!GlobalMaxNote.has_value() || TrackMaxNote.value() > GlobalMaxNote.value())
+        GlobalMaxNote = TrackMaxNote.value();
+    }
+  }
+
+  if (GlobalMinNote.has_value() && GlobalMaxNote.has_value())
+  {
+    MinNote = GlobalMinNote.value();
+    MaxNote = GlobalMaxNote.value();
+  }
+
+  std::stable_sort(TempoMap.begin(), TempoMap.end(),
+      [](const TempoPoint & _Lhs, const TempoPoint & _Rhs) { return _Lhs.Tick < _Rhs.Tick; });
+}
+
+void Song::Clear()
+{
+  Notes.Clear();
+  TempoMap.clear();
+  TrackNoteRange.clear();
+  TrackMetaMessage.clear();
+  TrackHasNote.clear();
+  FirstNoteTime = FLT_MAX;
+  MinNote       = -1;
+  MaxNote       = -1;
+  Duration      = 0;
+}
+
+int Song::GetTrackCount() const
+{
+  return static_cast<int>(TrackNoteRange.size());
+}
+
+bool Song::HasNotes() const
+{
+  return MinNote >= 0 && MaxNote >= 0;
+}
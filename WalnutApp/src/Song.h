@@ -0,0 +1,47 @@
+#pragma once
+
+#include "MidiFile.h"
+#include "NoteTable.h"
+
+#include <cfloat>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct TempoPoint
+{
+  int    Tick;
+  double Seconds;
+  double SecondsPerTick;
+};
+
+//
+// Everything the views need from a MIDI file, resolved once after loading.
+//
+class Song
+{
+public: // Members
+
+  NoteTable                            Notes;
+  std::vector<TempoPoint>              TempoMap;
+  std::vector<std::pair<float, float>> TrackNoteRange;
+  std::vector<std::string>             TrackMetaMessage;
+  std::vector<bool>                    TrackHasNote;
+  float                                FirstNoteTime = FLT_MAX;
+  float                                MinNote       = -1;
+  float                                MaxNote       = -1;
+  float                                Duration      = 0;
+
+public: // Interface
+
+  // Expects doTimeAnalysis and linkNotePairs to have been run
+  void Build(
+      smf::MidiFile & _MidiFile
+    );
+
+  void Clear();
+
+  int GetTrackCount() const;
+
+  bool HasNotes() const;
+};
@@ -0,0 +1,419 @@
+#include "SongCache.h"
+#include "Hash.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+
+//
+// Service
+//
+
+namespace
+{
+
+constexpr char     CACHE_MAGIC[4] = { 'W', 'M', 'S', 'C' };
+constexpr uint32_t CACHE_VERSION  = 3;
+
+struct CacheHeader
+{
+  char     Magic[4];
+  uint32_t Version;
+  uint64_t MidiSize;
+  int64_t  MidiModifiedTime;
+  uint64_t MidiHash;
+  uint64_t PayloadSize;
+  uint64_t PayloadHash;
+};
+
+class PayloadWriter
+{
+public:
+
+  template <typename T>
+  void Put(const T & _Value)
+  {
+    const auto * Bytes = reinterpret_cast<const char *>(&_Value);
+    Data.insert(Data.end(), Bytes, Bytes + sizeof(T));
+  }
+
+  // Arithmetic elements only, structs are written field by field so no
+  // padding bytes end up in the file
+  template <typename T>
+  void PutArray(const std::vector<T> & _Values)
+  {
+    static_assert(std::is_arithmetic_v<T>, "PutArray writes the bytes of T");
+
+    Put<uint64_t>(_Values.size());
+
+    const auto * Bytes = reinterpret_cast<const char *>(_Values.data());
+    Data.insert(Data.end(), Bytes, Bytes + _Values.size() * sizeof(T));
+  }
+
+  void PutString(const std::string & _Value)
+  {
+    Put<uint64_t>(_Value.size());
+    Data.insert(Data.end(), _Value.begin(), _Value.end());
+  }
+
+  std::vector<char> Data;
+};
+
+class PayloadReader
+{
+public:
+
+  PayloadReader(const unsigned char * _Begin, const unsigned char * _End)
+    : m_Ptr(_Begin)
+    , m_End(_End)
+  {
+  }
+
+  template <typename T>
+  bool Get(T & _Value)
+  {
+    if (static_cast<std::size_t>(m_End - m_Ptr) < sizeof(T))
+      return false;
+
+    std::memcpy(&_Value, m_Ptr, sizeof(T));
+    m_Ptr += sizeof(T);
+    return true;
+  }
+
+  // Reads an element count, rejecting counts the rest of the payload
+  // cannot hold at _ItemSize bytes per element
+  bool GetCount(uint64_t & _Count, std::size_t _ItemSize)
+  {
+    return Get(_Count) && _Count <= static_cast<uint64_t>(m_End - m_Ptr) / _ItemSize;
+  }
+
+  template <typename T>
+  bool GetArray(std::vector<T> & _Values)
+  {
+    static_assert(std::is_arithmetic_v<T>, "GetArray reads the bytes of T");
+
+    uint64_t Count = 0;
+
+    if (!GetCount(Count, sizeof(T)))
+      return false;
+
+    _Values.resize(static_cast<std::size_t>(Count));
+
+    if (!_Values.empty())
+      std::memcpy(_Values.data(), m_Ptr, _Values.size() * sizeof(T));
+
+    m_Ptr += _Values.size() * sizeof(T);
+    return true;
+  }
+
+  bool GetString(std::string & _Value)
+  {
+    uint64_t Size = 0;
+
+    if (!Get(Size) || Size > static_cast<uint64_t>(m_End - m_Ptr))
+      return false;
+
+    _Value.assign(reinterpret_cast<const char *>(m_Ptr), static_cast<std::size_t>(Size));
+    m_Ptr += Size;
+    return true;
+  }
+
+  bool IsAtEnd() const
+  {
+    return m_Ptr == m_End;
+  }
+
+private:
+
+  const unsigned char * m_Ptr;
+  const unsigned char * m_End;
+};
+
+void WriteTempoMap(PayloadWriter & _Writer, const std::vector<TempoPoint> & _TempoMap)
+{
+  _Writer.Put<uint64_t>(_TempoMap.size());
+
+  for (const auto & Point : _TempoMap)
+  {
+    _Writer.Put(Point.Tick);
+    _Writer.Put(Point.Seconds);
+    _Writer.Put(Point.SecondsPerTick);
+  }
+}
+
+bool ReadTempoMap(PayloadReader & _Reader, std::vector<TempoPoint> & _TempoMap)
+{
+  uint64_t Count = 0;
+
+  if (!_Reader.GetCount(Count, sizeof(int) + 2 * sizeof(double)))
+    return false;
+
+  _TempoMap.resize(static_cast<std::size_t>(Count));
+
+  for (auto & Point : _TempoMap)
+    if (!_Reader.Get(Point.Tick) || !_Reader.Get(Point.Seconds) || !_Reader.Get(Point.SecondsPerTick))
+      return false;
+
+  return true;
+}
+
+void WriteNoteRanges(PayloadWriter & _Writer, const std::vector<std::pair<float, float>> & _Ranges)
+{
+  _Writer.Put<uint64_t>(_Ranges.size());
+
+  for (const auto & Range : _Ranges)
+  {
+    _Writer.Put(Range.first);
+    _Writer.Put(Range.second);
+  }
+}
+
+bool ReadNoteRanges(PayloadReader & _Reader, std::vector<std::pair<float, float>> & _Ranges)
+{
+  uint64_t Count = 0;
+
+  if (!_Reader.GetCount(Count, 2 * sizeof(float)))
+    return false;
+
+  _Ranges.resize(static_cast<std::size_t>(Count));
+
+  for (auto & Range : _Ranges)
+    if (!_Reader.Get(Range.first) || !_Reader.Get(Range.second))
+      return false;
+
+  return true;
+}
+
+void WritePayload(PayloadWriter & _Writer, const Song & _Song)
+{
+  const auto & Notes = _Song.Notes;
+
+  _Writer.PutArray(Notes.Start);
+  _Writer.PutArray(Notes.Duration);
+  _Writer.PutArray(Notes.Key);
+  _Writer.PutArray(Notes.Velocity);
+  _Writer.PutArray(Notes.Channel);
+  _Writer.PutArray(Notes.Track);
+
+  std::vector<uint64_t> TrackBegin(Notes.TrackBegin.begin(), Notes.TrackBegin.end());
+  _Writer.PutArray(TrackBegin);
+  _Writer.PutArray(Notes.TrackMaxDuration);
+
+  WriteTempoMap(_Writer, _Song.TempoMap);
+  WriteNoteRanges(_Writer, _Song.TrackNoteRange);
+
+  std::vector<uint8_t> TrackHasNote(_Song.TrackHasNote.begin(), _Song.TrackHasNote.end());
+  _Writer.PutArray(TrackHasNote);
+
+  for (const auto & Message : _Song.TrackMetaMessage)
+    _Writer.PutString(Message);
+
+  _Writer.Put(_Song.FirstNoteTime);
+  _Writer.Put(_Song.MinNote);
+  _Writer.Put(_Song.MaxNote);
+  _Writer.Put(_Song.Duration);
+}
+
+bool ReadPayload(PayloadReader & _Reader, Song & _Song)
+{
+  auto & Notes = _Song.Notes;
+
+  std::vector<uint64_t> TrackBegin;
+  std::vector<uint8_t>  TrackHasNote;
+
+  if (!_Reader.GetArray(Notes.Start)    ||
+      !_Reader.GetArray(Notes.Duration) ||
+      !_Reader.GetArray(Notes.Key)      ||
+      !_Reader.GetArray(Notes.Velocity) ||
+      !_Reader.GetArray(Notes.Channel)  ||
+      !_Reader.GetArray(Notes.Track)    ||
+      !_Reader.GetArray(TrackBegin)     ||
+      !_Reader.GetArray(Notes.TrackMaxDuration) ||
+      !ReadTempoMap(_Reader, _Song.TempoMap) ||
+      !ReadNoteRanges(_Reader, _Song.TrackNoteRange) ||
+      !_Reader.GetArray(TrackHasNote))
+    return false;
+
+  const auto NoteCount  = Notes.Start.size();
+  const auto TrackCount = _Song.TrackNoteRange.size();
+
+  if (Notes.Duration.size() != NoteCount ||
+      Notes.Key.size()      != NoteCount ||
+      Notes.Velocity.size() != NoteCount ||
+      Notes.Channel.size()  != NoteCount ||
+      Notes.Track.size()    != NoteCount ||
+      TrackBegin.size()     != TrackCount + 1 ||
+      Notes.TrackMaxDuration.size() != TrackCount ||
+      TrackHasNote.size()   != TrackCount)
+    return false;
+
+  for (std::size_t TrackIdx = 0; TrackIdx < TrackCount; ++TrackIdx)
+    if (TrackBegin[TrackIdx] > TrackBegin[TrackIdx + 1] || TrackBegin[TrackIdx + 1] > NoteCount)
+      return false;
+
+  Notes.TrackBegin.assign(TrackBegin.begin(), TrackBegin.end());
+  _Song.TrackHasNote.assign(TrackHasNote.begin(), TrackHasNote.end());
+
+  _Song.TrackMetaMessage.resize(TrackCount);
+
+  for (auto & Message : _Song.TrackMetaMessage)
+    if (!_Reader.GetString(Message))
+      return false;
+
+  return _Reader.Get(_Song.FirstNoteTime) &&
+         _Reader.Get(_Song.MinNote)       &&
+         _Reader.Get(_Song.MaxNote)       &&
+         _Reader.Get(_Song.Duration)      &&
+         _Reader.IsAtEnd();
+}
+
+} // namespace
+
+//
+// Construction
+//
+
+SongCache::SongCache(
+    const std::string & _Directory
+  )
+  : m_Directory(_Directory)
+{
+}
+
+//
+// Interface
+//
+
+bool SongCache::Load(
+    const std::string & _MidiPath,
+    Song              & _Song
+  ) const
+{
+  Key MidiKey;
+
+  if (!MakeKey(_MidiPath, MidiKey))
+    return false;
+
+  smf::MappedFile Cache(GetCachePath(_MidiPath));
+
+  if (!Cache.isOpen() || Cache.size() < sizeof(CacheHeader))
+    return false;
+
+  CacheHeader Header;
+  std::memcpy(&Header, Cache.data(), sizeof(Header));
+
+  if (std::memcmp(Header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+      Header.Version          != CACHE_VERSION                        ||
+      Header.MidiSize         != MidiKey.Size                         ||
+      Header.MidiModifiedTime != MidiKey.ModifiedTime                 ||
+      Header.MidiHash         != MidiKey.Hash                         ||
+      Header.PayloadSize      != Cache.size() - sizeof(CacheHeader))
+    return false;
+
+  const auto * Payload = Cache.data() + sizeof(CacheHeader);
+
+  if (HashBytes(Payload, Header.PayloadSize) != Header.PayloadHash)
+    return false;
+
+  PayloadReader Reader(Payload, Payload + Header.PayloadSize);
+
+  _Song.Clear();
+
+  if (!ReadPayload(Reader, _Song))
+  {
+    _Song.Clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool SongCache::Store(
+    const std::string & _MidiPath,
+    const Song        & _Song
+  ) const
+{
+  Key MidiKey;
+
+  if (!MakeKey(_MidiPath, MidiKey))
+    return false;
+
+  std::error_code Error;
+  std::filesystem::create_directories(m_Directory, Error);
+
+  if (Error)
+    return false;
+
+  PayloadWriter Writer;
+  WritePayload(Writer, _Song);
+
+  CacheHeader Header;
+  std::memcpy(Header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  Header.Version          = CACHE_VERSION;
+  Header.MidiSize         = MidiKey.Size;
+  Header.MidiModifiedTime = MidiKey.ModifiedTime;
+  Header.MidiHash         = MidiKey.Hash;
+  Header.PayloadSize      = Writer.Data.size();
+  Header.PayloadHash      = HashBytes(Writer.Data.data(), Writer.Data.size());
+
+  // Written under a temporary name and renamed, so a reader never sees
+  // a partially written entry
+  const auto CachePath = GetCachePath(_MidiPath);
+  const auto TempPath  = CachePath + ".tmp";
+
+  {
+    std::ofstream Output(TempPath, std::ios::binary | std::ios::trunc);
+
+    Output.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+    Output.write(Writer.Data.data(), Writer.Data.size());
+
+    if (!Output)
+    {
+      Output.close();
+      std::filesystem::remove(TempPath, Error);
+      return false;
+    }
+  }
+
+  std::filesystem::rename(TempPath, CachePath, Error);
+
+  return !Error;
+}
+
+//
+// Service
+//
+
+bool SongCache::MakeKey(
+    const std::string & _MidiPath,
+    Key               & _Key
+  )
+{
+  std::error_code Error;
+
+  const auto ModifiedTime = std::filesystem::last_write_time(_MidiPath, Error);
+
+  if (Error)
+    return false;
+
+  smf::MappedFile Midi(_MidiPath);
+
+  if (!Midi.isOpen())
+    return false;
+
+  _Key.Size         = Midi.size();
+  _Key.ModifiedTime = ModifiedTime.time_since_epoch().count();
+  _Key.Hash         = HashBytes(Midi.data(), Midi.size());
+
+  return true;
+}
+
+std::string SongCache::GetCachePath(
+    const std::string & _MidiPath
+  ) const
+{
+  return m_Directory + "\\" + std::filesystem::path(_MidiPath).filename().string() + ".cache";
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Song.h"
+
+#include <cstdint>
+#include <string>
+
+//
+// Binary cache of resolved songs, one file per MIDI file. An entry is used
+// only if the size, modification time and content hash of the MIDI file
+// still match, and its payload checksum is intact.
+//
+class SongCache
+{
+public: // Construction
+
+  SongCache(
+      const std::string & _Directory
+    );
+
+public: // Interface
+
+  bool Load(
+      const std::string & _MidiPath,
+      Song              & _Song
+    ) const;
+
+  bool Store(
+      const std::string & _MidiPath,
+      const Song        & _Song
+    ) const;
+
+private: // Types
+
+  struct Key
+  {
+    uint64_t Size;
+    int64_t  ModifiedTime;
+    uint64_t Hash;
+  };
+
+private: // Service
+
+  static bool MakeKey(
+      const std::string & _MidiPath,
+      Key               & _Key
+    );
+
+  std::string GetCachePath(
+      const std::string & _MidiPath
+    ) const;
+
+private: // Members
+
+  std::string m_Directory;
+};
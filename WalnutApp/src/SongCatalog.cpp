@@ -0,0 +1,137 @@
+#include "SongCatalog.h"
+#include "SmfEventStream.h"
+
+#include <algorithm>
+#include <thread>
+
+//
+// Construction
+//
+
+SongCatalog::~SongCatalog()
+{
+  Stop();
+}
+
+//
+// Interface
+//
+
+void SongCatalog::Start(
+    const std::string              & _Directory,
+    const std::vector<std::string> & _FileNames
+  )
+{
+  Stop();
+
+  m_Directory = _Directory;
+  m_FileNames = _FileNames;
+  m_Entries.assign(_FileNames.size(), SongInfo{});
+  m_IsReady = std::make_unique<std::atomic<bool>[]>(_FileNames.size());
+
+  for (std::size_t EntryIdx = 0; EntryIdx < _FileNames.size(); ++EntryIdx)
+    m_IsReady[EntryIdx] = false;
+
+  m_NextEntry     = 0;
+  m_ScannedCount  = 0;
+  m_StopRequested = false;
+
+  const auto ThreadCount = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), _FileNames.size());
+
+  for (std::size_t ThreadIdx = 0; ThreadIdx < ThreadCount; ++ThreadIdx)
+    m_Workers.push_back(std::async(std::launch::async, &SongCatalog::ScanWorker, this));
+}
+
+void SongCatalog::Stop()
+{
+  m_StopRequested = true;
+
+  for (auto & Worker : m_Workers)
+    Worker.wait();
+
+  m_Workers.clear();
+}
+
+bool SongCatalog::IsBuilding() const
+{
+  return !m_Workers.empty() && GetScannedCount() < GetFileCount();
+}
+
+std::size_t SongCatalog::GetFileCount() const
+{
+  return m_Entries.size();
+}
+
+std::size_t SongCatalog::GetScannedCount() const
+{
+  return m_ScannedCount;
+}
+
+const SongInfo * SongCatalog::GetInfo(
+    std::size_t _FileIdx
+  ) const
+{
+  if (_FileIdx >= m_Entries.size() || !m_IsReady[_FileIdx].load(std::memory_order_acquire))
+    return nullptr;
+
+  return &m_Entries[_FileIdx];
+}
+
+SongInfo SongCatalog::ScanFile(
+    const std::string & _FilePath
+  )
+{
+  SongInfo Info;
+
+  smf::SmfEventStream Stream(_FilePath);
+
+  if (!Stream.isOpen())
+    return Info;
+
+  smf::MidiEvent Event;
+
+  while (Stream.next(Event))
+  {
+    if (!Event.isNoteOn())
+      continue;
+
+    const auto Key = Event.getKeyNumber();
+
+    if (Info.MinKey < 0 || Key < Info.MinKey)
+      Info.MinKey = Key;
+
+    if (Info.MaxKey < 0 || Key > Info.MaxKey)
+      Info.MaxKey = Key;
+
+    ++Info.NoteCount;
+  }
+
+  Info.Duration   = static_cast<float>(Stream.getCurrentSeconds());
+  Info.TrackCount = Stream.getTrackCount();
+  Info.IsValid    = Stream.status();
+
+  return Info;
+}
+
+//
+// Service
+//
+
+void SongCatalog::ScanWorker()
+{
+  while (!m_StopRequested)
+  {
+    const auto EntryIdx = m_NextEntry++;
+
+    if (EntryIdx >= m_Entries.size())
+      return;
+
+    const auto & FileName = m_FileNames[EntryIdx];
+
+    m_Entries[EntryIdx] = ScanFile(m_Directory + "\\" + FileName);
+    m_Entries[EntryIdx].FileName = FileName;
+
+    m_IsReady[EntryIdx].store(true, std::memory_order_release);
+    ++m_ScannedCount;
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SongInfo
+{
+  std::string FileName;
+  float       Duration   = 0;
+  int         TrackCount = 0;
+  int         NoteCount  = 0;
+  int         MinKey     = -1;
+  int         MaxKey     = -1;
+  bool        IsValid    = false;
+};
+
+//
+// Summary of every song in a directory, collected on background threads.
+// Each file is streamed once with smf::SmfEventStream, without building
+// its tracks in memory.
+//
+class SongCatalog
+{
+public: // Construction
+
+  ~SongCatalog();
+
+public: // Interface
+
+  // Stops a previous scan and starts scanning _FileNames in _Directory
+  void Start(
+      const std::string              & _Directory,
+      const std::vector<std::string> & _FileNames
+    );
+
+  void Stop();
+
+  bool IsBuilding() const;
+
+  std::size_t GetFileCount() const;
+
+  std::size_t GetScannedCount() const;
+
+  // Returns nullptr while the file has not been scanned yet. _FileIdx is
+  // the index of the file in the list given to Start
+  const SongInfo * GetInfo(
+      std::size_t _FileIdx
+    ) const;
+
+  static SongInfo ScanFile(
+      const std::string & _FilePath
+    );
+
+private: // Service
+
+  void ScanWorker();
+
+private: // Members
+
+  std::string                          m_Directory;
+  std::vector<std::string>             m_FileNames;
+  std::vector<SongInfo>                m_Entries;
+  std::unique_ptr<std::atomic<bool>[]> m_IsReady;
+  std::atomic<std::size_t>             m_NextEntry     { 0 };
+  std::atomic<std::size_t>             m_ScannedCount  { 0 };
+  std::atomic<bool>                    m_StopRequested { false };
+  std::vector<std::future<void>>       m_Workers;
+};
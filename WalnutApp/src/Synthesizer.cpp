@@ -0,0 +1,562 @@
+#include "Synthesizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__AVX2__)
+  #define SYNTHESIZER_AVX2
+  #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define SYNTHESIZER_SSE2
+  #include <emmintrin.h>
+#endif
+
+//
+// Service
+//
+
+namespace
+{
+
+constexpr int   TABLE_SIZE       = 2048;
+constexpr int   HARMONIC_COUNT   = 8;
+constexpr int   DRUM_CHANNEL     = 9;
+constexpr float ATTACK_SECONDS   = 0.005f;
+constexpr float RELEASE_SECONDS  = 0.08f;
+constexpr float DRUM_SECONDS     = 0.12f;
+constexpr float SILENT_GAIN      = 0.0001f;
+constexpr float MASTER_GAIN      = 0.15f;
+constexpr float TABLE_SCALE      = 1.0f / TABLE_SIZE;
+
+// Per lane constants of a group
+constexpr float LANE_INDEX[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+constexpr float LANE_ONES[8]  = { 1, 1, 1, 1, 1, 1, 1, 1 };
+constexpr float LANE_ZEROS[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+// One cycle of the voice waveform, with a guard sample for interpolation
+const std::array<float, TABLE_SIZE + 1> & GetWavetable()
+{
+  static const auto TABLE = []
+  {
+    std::array<float, TABLE_SIZE + 1> Table {};
+
+    float Peak = 0;
+
+    for (int SampleIdx = 0; SampleIdx < TABLE_SIZE; ++SampleIdx)
+    {
+      const double Angle = 2 * 3.14159265358979 * SampleIdx / TABLE_SIZE;
+
+      double Sample = 0;
+
+      for (int Harmonic = 1; Harmonic <= HARMONIC_COUNT; ++Harmonic)
+        Sample += std::sin(Angle * Harmonic) / std::pow(Harmonic, 1.5);
+
+      Table[SampleIdx] = static_cast<float>(Sample);
+      Peak = std::max(Peak, std::abs(Table[SampleIdx]));
+    }
+
+    for (auto & Sample : Table)
+      Sample /= Peak;
+
+    Table[TABLE_SIZE] = Table[0];
+
+    return Table;
+  }();
+
+  return TABLE;
+}
+
+float GetDecayPerFrame(
+    float _Seconds
+  )
+{
+  return std::exp(-1.0f / (_Seconds * Synthesizer::SAMPLE_RATE));
+}
+
+// Powers of the per frame decay, the gain multiplier after each lane
+void GetDecayScales(
+    float         _Seconds,
+    float       * _Scales,
+    std::size_t   _LaneCount
+  )
+{
+  const float Decay = GetDecayPerFrame(_Seconds);
+
+  _Scales[0] = Decay;
+
+  for (std::size_t Lane = 1; Lane < _LaneCount; ++Lane)
+    _Scales[Lane] = _Scales[Lane - 1] * Decay;
+}
+
+// Table position of a phase which may be past the end of the table
+inline float WrapPhase(
+    float _Phase
+  )
+{
+  return _Phase - static_cast<float>(static_cast<int>(_Phase * TABLE_SCALE)) * TABLE_SIZE;
+}
+
+} // namespace
+
+//
+// Interface
+//
+
+void Synthesizer::SetNotes(
+    const NoteTable & _Notes
+  )
+{
+  m_Notes = &_Notes;
+
+  m_Order.resize(_Notes.Start.size());
+
+  for (std::size_t NoteIdx = 0; NoteIdx < m_Order.size(); ++NoteIdx)
+    m_Order[NoteIdx] = NoteIdx;
+
+  std::stable_sort(m_Order.begin(), m_Order.end(), [&](std::size_t _Lhs, std::size_t _Rhs)
+    {
+      return _Notes.Start[_Lhs] < _Notes.Start[_Rhs];
+    });
+
+  Start(0);
+}
+
+double Synthesizer::GetTime() const
+{
+  return m_StartTime + static_cast<double>(m_Frame) / SAMPLE_RATE;
+}
+
+const char * Synthesizer::GetVectorName()
+{
+#if defined(SYNTHESIZER_AVX2)
+  return "AVX2";
+#elif defined(SYNTHESIZER_SSE2)
+  return "SSE2";
+#else
+  return "none";
+#endif
+}
+
+//
+// AudioSource
+//
+
+void Synthesizer::Start(
+    double _Time
+  )
+{
+  m_StartTime  = _Time;
+  m_StartFrame = GetSongFrame(_Time);
+  m_Frame      = 0;
+
+  m_VoiceCount = 0;
+
+  if (m_Notes == nullptr)
+    return;
+
+  const auto & Notes = *m_Notes;
+
+  m_NextNote = std::lower_bound(m_Order.begin(), m_Order.end(), _Time, [&](std::size_t _NoteIdx, double _Value)
+    {
+      return Notes.Start[_NoteIdx] < _Value;
+    }) - m_Order.begin();
+
+  // Notes which started earlier and still sound join mid-envelope
+  for (std::size_t OrderIdx = 0; OrderIdx < m_NextNote; ++OrderIdx)
+  {
+    const auto NoteIdx = m_Order[OrderIdx];
+
+    if (Notes.Start[NoteIdx] + Notes.Duration[NoteIdx] + TAIL_SECONDS < _Time)
+      continue;
+
+    StartVoice(NoteIdx, static_cast<uint64_t>(std::max<int64_t>(0, m_StartFrame - GetSongFrame(Notes.Start[NoteIdx]))));
+  }
+}
+
+void Synthesizer::Render(
+    float       * _Output,
+    std::size_t   _FrameCount
+  )
+{
+  for (std::size_t BlockBegin = 0; BlockBegin < _FrameCount; BlockBegin += BLOCK_FRAMES)
+    RenderBlock(_Output + BlockBegin * CHANNEL_COUNT, std::min(BLOCK_FRAMES, _FrameCount - BlockBegin));
+}
+
+//
+// Service
+//
+
+void Synthesizer::RenderBlock(
+    float       * _Output,
+    std::size_t   _FrameCount
+  )
+{
+  std::fill(m_Mono.begin(), m_Mono.begin() + _FrameCount, 0.0f);
+
+  // Render in spans between note starts, so voices begin on their frame
+  for (std::size_t SpanBegin = 0; SpanBegin < _FrameCount; )
+  {
+    while (m_Notes != nullptr && m_NextNote < m_Order.size() && GetFrame(m_Notes->Start[m_Order[m_NextNote]]) <= m_Frame + SpanBegin)
+      StartVoice(m_Order[m_NextNote++]);
+
+    std::size_t SpanEnd = _FrameCount;
+
+    if (m_Notes != nullptr && m_NextNote < m_Order.size())
+      SpanEnd = static_cast<std::size_t>(std::min<uint64_t>(_FrameCount, GetFrame(m_Notes->Start[m_Order[m_NextNote]]) - m_Frame));
+
+    for (std::size_t VoiceIdx = 0; VoiceIdx < m_VoiceCount; )
+    {
+      // Faded voices are swapped out, the others keep their slot
+      if (RenderVoice(m_Voices[VoiceIdx], m_Frame + SpanBegin, m_Mono.data() + SpanBegin, SpanEnd - SpanBegin))
+        ++VoiceIdx;
+      else
+        m_Voices[VoiceIdx] = m_Voices[--m_VoiceCount];
+    }
+
+    SpanBegin = SpanEnd;
+  }
+
+  for (std::size_t FrameIdx = 0; FrameIdx < _FrameCount; ++FrameIdx)
+    for (int Channel = 0; Channel < CHANNEL_COUNT; ++Channel)
+      _Output[FrameIdx * CHANNEL_COUNT + Channel] = m_Mono[FrameIdx] * MASTER_GAIN;
+
+  m_Frame += _FrameCount;
+}
+
+void Synthesizer::StartVoice(
+    std::size_t _NoteIdx,
+    uint64_t    _ElapsedFrames
+  )
+{
+  const auto & Notes = *m_Notes;
+
+  const float Key      = Notes.Key[_NoteIdx];
+  const bool  IsDrum   = Notes.Channel[_NoteIdx] == DRUM_CHANNEL;
+  const float Velocity = Notes.Velocity[_NoteIdx] / 127.0f;
+
+  // Higher keys fade faster, like piano strings
+  const float DecaySeconds = std::clamp(3.0f * std::exp2((60 - Key) / 24), 0.3f, 6.0f);
+  const float Frequency    = 440.0f * std::exp2((Key - 69) / 12);
+
+  Voice Voice;
+  Voice.Phase     = 0;
+  Voice.PhaseStep = IsDrum ? 0 : Frequency * TABLE_SIZE / SAMPLE_RATE;
+  Voice.Gain      = 0;
+  Voice.Peak      = Velocity * Velocity;
+  Voice.OffFrame  = GetFrame(Notes.Start[_NoteIdx] + Notes.Duration[_NoteIdx]);
+  Voice.Noise     = static_cast<uint32_t>(_NoteIdx) * 2654435761u + 1;
+  Voice.Note      = static_cast<uint32_t>(_NoteIdx);
+  Voice.State     = Stage::Attack;
+
+  const float AttackStep = Voice.Peak / (ATTACK_SECONDS * SAMPLE_RATE);
+
+  for (std::size_t Lane = 0; Lane < GROUP_FRAMES; ++Lane)
+    Voice.AttackGains[Lane] = (Lane + 1) * AttackStep;
+
+  GetDecayScales(IsDrum ? DRUM_SECONDS : DecaySeconds, Voice.DecayScales, GROUP_FRAMES);
+
+  if (_ElapsedFrames > 0)
+  {
+    // Frames on the grid of the song, as a voice started on its frame sees them
+    const auto HeldFrames = GetSongFrame(Notes.Start[_NoteIdx] + Notes.Duration[_NoteIdx]) - GetSongFrame(Notes.Start[_NoteIdx]);
+
+    AdvanceVoice(Voice, _ElapsedFrames, HeldFrames);
+
+    if (Voice.State != Stage::Attack && Voice.Gain < SILENT_GAIN)
+      return;
+  }
+
+  if (m_VoiceCount < MAX_VOICES)
+  {
+    m_Voices[m_VoiceCount++] = Voice;
+    return;
+  }
+
+  auto Quietest = std::min_element(m_Voices.begin(), m_Voices.end(), [](const auto & _Lhs, const auto & _Rhs)
+    {
+      // Ties by note, not by slot, whose order depends on when the stream started
+      return _Lhs.Gain < _Rhs.Gain || (_Lhs.Gain == _Rhs.Gain && _Lhs.Note < _Rhs.Note);
+    });
+
+  // A voice which already sounds only replaces a quieter one
+  if (Voice.State == Stage::Attack || Quietest->Gain < Voice.Gain)
+    *Quietest = Voice;
+}
+
+void Synthesizer::AdvanceVoice(
+    Voice    & _Voice,
+    uint64_t   _Frames,
+    int64_t    _HeldFrames
+  )
+{
+  const double AttackStep   = _Voice.AttackGains[0];
+  const auto   AttackFrames = static_cast<int64_t>(std::ceil(_Voice.Peak / AttackStep));
+  const auto   Frames       = static_cast<int64_t>(_Frames);
+  const auto   Held         = std::min(Frames, _HeldFrames);
+
+  double Gain = Held < AttackFrames
+    ? Held * AttackStep
+    : _Voice.Peak * std::pow(static_cast<double>(_Voice.DecayScales[0]), static_cast<double>(Held - AttackFrames));
+
+  if (Frames >= _HeldFrames)
+  {
+    Gain *= std::pow(static_cast<double>(GetDecayPerFrame(RELEASE_SECONDS)), static_cast<double>(Frames - _HeldFrames));
+    _Voice.State = Stage::Release;
+  }
+  else
+    _Voice.State = Held < AttackFrames ? Stage::Attack : Stage::Decay;
+
+  _Voice.Gain  = static_cast<float>(Gain);
+  _Voice.Phase = static_cast<float>(std::fmod(Frames * static_cast<double>(_Voice.PhaseStep), TABLE_SIZE));
+
+  // Jumps the noise generator ahead by composing its affine step
+  uint32_t Multiplier = 1664525u;
+  uint32_t Increment  = 1013904223u;
+
+  for (auto Steps = _Frames; Steps != 0; Steps >>= 1)
+  {
+    if (Steps & 1)
+      _Voice.Noise = _Voice.Noise * Multiplier + Increment;
+
+    Increment  *= Multiplier + 1;
+    Multiplier *= Multiplier;
+  }
+}
+
+bool Synthesizer::RenderVoice(
+    Voice       & _Voice,
+    uint64_t      _Frame,
+    float       * _Output,
+    std::size_t   _FrameCount
+  ) const
+{
+  for (std::size_t FrameIdx = 0; FrameIdx < _FrameCount; )
+  {
+    if (_Voice.State != Stage::Release && _Frame + FrameIdx >= _Voice.OffFrame)
+      _Voice.State = Stage::Release;
+
+    auto GroupFrames = std::min(GROUP_FRAMES, _FrameCount - FrameIdx);
+
+    // A group ends at the note-off, so the release starts on its frame
+    if (_Voice.State != Stage::Release)
+      GroupFrames = static_cast<std::size_t>(std::min<uint64_t>(GroupFrames, _Voice.OffFrame - (_Frame + FrameIdx)));
+
+    MixGroup(_Voice, _Output + FrameIdx, GroupFrames);
+
+    FrameIdx += GroupFrames;
+
+    if (_Voice.State != Stage::Attack && _Voice.Gain < SILENT_GAIN)
+      return false;
+  }
+
+  return true;
+}
+
+void Synthesizer::MixGroup(
+    Voice       & _Voice,
+    float       * _Output,
+    std::size_t   _FrameCount
+  ) const
+{
+  static_assert(GROUP_FRAMES == std::size(LANE_INDEX), "a lane constant per group frame");
+
+  static const auto RELEASE_SCALES = []
+  {
+    std::array<float, GROUP_FRAMES> Scales;
+    GetDecayScales(RELEASE_SECONDS, Scales.data(), Scales.size());
+    return Scales;
+  }();
+
+  // The gain of lane i is min(Gain * Scales[i] + Offsets[i], Peak) in every
+  // stage: a ramp during the attack and powers of the decay after it
+  const float * Scales  = LANE_ONES;
+  const float * Offsets = _Voice.AttackGains;
+
+  if (_Voice.State != Stage::Attack)
+  {
+    Scales  = _Voice.State == Stage::Decay ? _Voice.DecayScales : RELEASE_SCALES.data();
+    Offsets = LANE_ZEROS;
+  }
+
+  // Noise is a serial recurrence, it is generated ahead of the lanes
+  float         NoiseSamples[GROUP_FRAMES];
+  const float * Noise = nullptr;
+
+  if (_Voice.PhaseStep == 0)
+  {
+    for (std::size_t Lane = 0; Lane < _FrameCount; ++Lane)
+    {
+      _Voice.Noise = _Voice.Noise * 1664525u + 1013904223u;
+      NoiseSamples[Lane] = static_cast<int32_t>(_Voice.Noise) / 2147483648.0f;
+    }
+
+    Noise = NoiseSamples;
+  }
+
+  if (_FrameCount < GROUP_FRAMES || !MixGroupVector(_Voice, Scales, Offsets, Noise, _Output))
+    MixGroupScalar(_Voice, Scales, Offsets, Noise, _Output, _FrameCount);
+
+  const auto LastLane = _FrameCount - 1;
+
+  _Voice.Gain  = std::min(_Voice.Gain * Scales[LastLane] + Offsets[LastLane], _Voice.Peak);
+  _Voice.Phase = WrapPhase(_Voice.Phase + _FrameCount * _Voice.PhaseStep);
+
+  if (_Voice.State == Stage::Attack && _Voice.Gain >= _Voice.Peak)
+    _Voice.State = Stage::Decay;
+}
+
+void Synthesizer::MixGroupScalar(
+    const Voice & _Voice,
+    const float * _Scales,
+    const float * _Offsets,
+    const float * _Noise,
+    float       * _Output,
+    std::size_t   _FrameCount
+  )
+{
+  const auto & Table = GetWavetable();
+
+  for (std::size_t Lane = 0; Lane < _FrameCount; ++Lane)
+  {
+    const float Gain = std::min(_Voice.Gain * _Scales[Lane] + _Offsets[Lane], _Voice.Peak);
+
+    float Sample;
+
+    if (_Noise != nullptr)
+      Sample = _Noise[Lane];
+    else
+    {
+      const float Phase    = WrapPhase(_Voice.Phase + LANE_INDEX[Lane] * _Voice.PhaseStep);
+      const int   Index    = static_cast<int>(Phase);
+      const float Fraction = Phase - static_cast<float>(Index);
+
+      Sample = Table[Index] + (Table[Index + 1] - Table[Index]) * Fraction;
+    }
+
+    _Output[Lane] = _Output[Lane] + Sample * Gain;
+  }
+}
+
+#if defined(SYNTHESIZER_AVX2)
+
+bool Synthesizer::MixGroupVector(
+    const Voice & _Voice,
+    const float * _Scales,
+    const float * _Offsets,
+    const float * _Noise,
+    float       * _Output
+  )
+{
+  const __m256 Gain = _mm256_min_ps(
+    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(_Voice.Gain), _mm256_loadu_ps(_Scales)), _mm256_loadu_ps(_Offsets)),
+    _mm256_set1_ps(_Voice.Peak));
+
+  __m256 Sample;
+
+  if (_Noise != nullptr)
+    Sample = _mm256_loadu_ps(_Noise);
+  else
+  {
+    const float * Table = GetWavetable().data();
+
+    __m256 Phase = _mm256_add_ps(_mm256_set1_ps(_Voice.Phase), _mm256_mul_ps(_mm256_loadu_ps(LANE_INDEX), _mm256_set1_ps(_Voice.PhaseStep)));
+
+    const __m256 Wraps = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(Phase, _mm256_set1_ps(TABLE_SCALE))));
+    Phase = _mm256_sub_ps(Phase, _mm256_mul_ps(Wraps, _mm256_set1_ps(TABLE_SIZE)));
+
+    const __m256i Index    = _mm256_cvttps_epi32(Phase);
+    const __m256  Fraction = _mm256_sub_ps(Phase, _mm256_cvtepi32_ps(Index));
+    const __m256  Low      = _mm256_i32gather_ps(Table, Index, 4);
+    const __m256  High     = _mm256_i32gather_ps(Table + 1, Index, 4);
+
+    Sample = _mm256_add_ps(Low, _mm256_mul_ps(_mm256_sub_ps(High, Low), Fraction));
+  }
+
+  _mm256_storeu_ps(_Output, _mm256_add_ps(_mm256_loadu_ps(_Output), _mm256_mul_ps(Sample, Gain)));
+
+  return true;
+}
+
+#elif defined(SYNTHESIZER_SSE2)
+
+bool Synthesizer::MixGroupVector(
+    const Voice & _Voice,
+    const float * _Scales,
+    const float * _Offsets,
+    const float * _Noise,
+    float       * _Output
+  )
+{
+  const float * Table = GetWavetable().data();
+
+  const __m128 VoiceGain  = _mm_set1_ps(_Voice.Gain);
+  const __m128 Peak       = _mm_set1_ps(_Voice.Peak);
+  const __m128 VoicePhase = _mm_set1_ps(_Voice.Phase);
+  const __m128 PhaseStep  = _mm_set1_ps(_Voice.PhaseStep);
+  const __m128 TableScale = _mm_set1_ps(TABLE_SCALE);
+  const __m128 TableSize  = _mm_set1_ps(TABLE_SIZE);
+
+  // Two halves of the group
+  for (std::size_t Lane = 0; Lane < GROUP_FRAMES; Lane += 4)
+  {
+    const __m128 Gain = _mm_min_ps(_mm_add_ps(_mm_mul_ps(VoiceGain, _mm_loadu_ps(_Scales + Lane)), _mm_loadu_ps(_Offsets + Lane)), Peak);
+
+    __m128 Sample;
+
+    if (_Noise != nullptr)
+      Sample = _mm_loadu_ps(_Noise + Lane);
+    else
+    {
+      __m128 Phase = _mm_add_ps(VoicePhase, _mm_mul_ps(_mm_loadu_ps(LANE_INDEX + Lane), PhaseStep));
+
+      const __m128 Wraps = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(Phase, TableScale)));
+      Phase = _mm_sub_ps(Phase, _mm_mul_ps(Wraps, TableSize));
+
+      const __m128i Index    = _mm_cvttps_epi32(Phase);
+      const __m128  Fraction = _mm_sub_ps(Phase, _mm_cvtepi32_ps(Index));
+
+      // SSE2 has no gather
+      alignas(16) int32_t Indices[4];
+      _mm_store_si128(reinterpret_cast<__m128i *>(Indices), Index);
+
+      const __m128 Low  = _mm_setr_ps(Table[Indices[0]],     Table[Indices[1]],     Table[Indices[2]],     Table[Indices[3]]);
+      const __m128 High = _mm_setr_ps(Table[Indices[0] + 1], Table[Indices[1] + 1], Table[Indices[2] + 1], Table[Indices[3] + 1]);
+
+      Sample = _mm_add_ps(Low, _mm_mul_ps(_mm_sub_ps(High, Low), Fraction));
+    }
+
+    _mm_storeu_ps(_Output + Lane, _mm_add_ps(_mm_loadu_ps(_Output + Lane), _mm_mul_ps(Sample, Gain)));
+  }
+
+  return true;
+}
+
+#else
+
+bool Synthesizer::MixGroupVector(
+    const Voice & /*_Voice*/,
+    const float * /*_Scales*/,
+    const float * /*_Offsets*/,
+    const float * /*_Noise*/,
+    float       * /*_Output*/
+  )
+{
+  return false;
+}
+
+#endif
+
+uint64_t Synthesizer::GetFrame(
+    double _Time
+  ) const
+{
+  return static_cast<uint64_t>(std::max<int64_t>(0, GetSongFrame(_Time) - m_StartFrame));
+}
+
+int64_t Synthesizer::GetSongFrame(
+    double _Time
+  )
+{
+  return static_cast<int64_t>(std::floor(_Time * SAMPLE_RATE + 0.5));
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "AudioSource.h"
+#include "NoteTable.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// Renders the notes of a song to audio in the process, as a stream which
+// can start at any time of the song. Every note plays a wavetable voice
+// with a short attack, a key dependent decay and a release after its
+// note-off; the percussion channel plays decaying noise instead. Voices
+// come from a fixed pool, the quietest one is replaced when it is full.
+// Rendering runs in blocks and never allocates; envelopes and oscillators
+// are computed for a group of frames at once, with SIMD where available.
+//
+class Synthesizer : public AudioSource
+{
+public: // Constants
+
+  static constexpr int SAMPLE_RATE   = 48000;
+  static constexpr int CHANNEL_COUNT = 2;
+  static constexpr int MAX_VOICES    = 128;
+
+  static constexpr std::size_t BLOCK_FRAMES = 128;
+
+  // Changes whenever the same notes would sound different
+  static constexpr uint32_t VERSION = 3;
+
+  // Longest a voice sounds after its note-off, the release fading to silence
+  static constexpr double TAIL_SECONDS = 0.75;
+
+public: // Interface
+
+  // Orders the notes for playback. _Notes must outlive the synthesizer or
+  // the next call to SetNotes
+  void SetNotes(
+      const NoteTable & _Notes
+    );
+
+  // Song time of the next frame to render
+  double GetTime() const;
+
+  // Instruction set of the vector mixer in this build, "none" without one
+  static const char * GetVectorName();
+
+public: // AudioSource
+
+  // Restarts the stream at _Time seconds of the song. Notes which started
+  // before and still sound are picked up mid-envelope
+  void Start(
+      double _Time
+    ) override;
+
+  void Render(
+      float       * _Output,
+      std::size_t   _FrameCount
+    ) override;
+
+private: // Constants
+
+  // Frames per envelope and oscillator step, the lanes of the vector paths
+  static constexpr std::size_t GROUP_FRAMES = 8;
+
+private: // Types
+
+  enum class Stage : uint8_t
+  {
+    Attack,
+    Decay,
+    Release
+  };
+
+  struct Voice
+  {
+    float    Phase;
+    float    PhaseStep;                  // table samples per frame, 0 for noise
+    float    Gain;
+    float    Peak;
+    float    AttackGains[GROUP_FRAMES];  // gain added after each frame of a group
+    float    DecayScales[GROUP_FRAMES];  // gain multiplier after each frame of a group
+    uint64_t OffFrame;                   // first frame of the release
+    uint32_t Noise;
+    uint32_t Note;                       // index of the note, orders voices of equal gain
+    Stage    State;
+  };
+
+private: // Service
+
+  // Starts the voice of a note which has already sounded for
+  // _ElapsedFrames frames, or none if it has faded out by then
+  void StartVoice(
+      std::size_t _NoteIdx,
+      uint64_t    _ElapsedFrames = 0
+    );
+
+  // Moves the envelope, oscillator and noise of a new voice _Frames frames
+  // ahead, with the note-off after _HeldFrames frames
+  static void AdvanceVoice(
+      Voice    & _Voice,
+      uint64_t   _Frames,
+      int64_t    _HeldFrames
+    );
+
+  void RenderBlock(
+      float       * _Output,
+      std::size_t   _FrameCount
+    );
+
+  // Adds _FrameCount frames of the voice, starting at stream frame _Frame,
+  // to _Output. Returns false once the voice has faded out
+  bool RenderVoice(
+      Voice       & _Voice,
+      uint64_t      _Frame,
+      float       * _Output,
+      std::size_t   _FrameCount
+    ) const;
+
+  // Adds a group of up to GROUP_FRAMES frames of the voice to _Output and
+  // advances its envelope and oscillator
+  void MixGroup(
+      Voice       & _Voice,
+      float       * _Output,
+      std::size_t   _FrameCount
+    ) const;
+
+  // Lanes of a full group with SIMD, returns false without SIMD support
+  static bool MixGroupVector(
+      const Voice & _Voice,
+      const float * _Scales,
+      const float * _Offsets,
+      const float * _Noise,
+      float       * _Output
+    );
+
+  static void MixGroupScalar(
+      const Voice & _Voice,
+      const float * _Scales,
+      const float * _Offsets,
+      const float * _Noise,
+      float       * _Output,
+      std::size_t   _FrameCount
+    );
+
+  // Frame of the stream at which _Time sounds, 0 before the start
+  uint64_t GetFrame(
+      double _Time
+    ) const;
+
+  // Frames count from the beginning of the song whatever the start time,
+  // so a stream started late renders the same frames as one from the top
+  static int64_t GetSongFrame(
+      double _Time
+    );
+
+private: // Members
+
+  const NoteTable *               m_Notes      = nullptr;
+  std::vector<std::size_t>        m_Order;       // note indices by start time
+  std::size_t                     m_NextNote   = 0;
+  double                          m_StartTime  = 0;
+  int64_t                         m_StartFrame = 0;  // song frame of the first rendered frame
+  uint64_t                        m_Frame      = 0;  // frames rendered since Start
+  std::array<Voice, MAX_VOICES>   m_Voices;
+  std::size_t                     m_VoiceCount = 0;
+  std::array<float, BLOCK_FRAMES> m_Mono;
+};
@@ -1,10 +1,161 @@
 #include "Walnut/Application.h"
 #include "Walnut/EntryPoint.h"
 
+#include "Benchmark.h"
 #include "MidiVisualization.h"
+#include "OfflineAudioRenderer.h"
+#include "OfflineRenderer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+constexpr unsigned long long DEFAULT_BENCH_FIGURES = 10000;
+constexpr unsigned long long DEFAULT_BENCH_VOICES  = Synthesizer::MAX_VOICES;
+constexpr unsigned long long DEFAULT_BENCH_THREADS = 0;  // one per core
+constexpr double             DEFAULT_BENCH_SECONDS = 60;
+
+bool LoadSong(
+    const std::string & _MidiPath,
+    Song              & _Song
+  )
+{
+  smf::MidiFile MidiFile;
+  MidiFile.setReadThreadCount(0);
+
+  if (!MidiFile.read(_MidiPath))
+  {
+    std::cerr << "Cannot read " << _MidiPath << std::endl;
+    return false;
+  }
+
+  MidiFile.doTimeAnalysis();
+  MidiFile.linkNotePairs();
+
+  _Song.Build(MidiFile);
+  return true;
+}
+
+// WalnutApp --render-animation <file.mid> <file.y4m|file.rgba>
+int RenderAnimationOffline(
+    const std::string & _MidiPath,
+    const std::string & _OutputPath
+  )
+{
+  Song Song;
+
+  if (!LoadSong(_MidiPath, Song))
+    return 1;
+
+  auto Settings = OfflineRenderer::GetDefaultSettings(Song);
+
+  if (_OutputPath.size() < 5 || _OutputPath.compare(_OutputPath.size() - 4, 4, ".y4m") != 0)
+    Settings.OutputFormat = OfflineRenderer::Format::Rgba;
+
+  if (!OfflineRenderer::Render(Song, Settings, _OutputPath))
+  {
+    std::cerr << "Cannot write " << _OutputPath << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+// WalnutApp --render-audio <file.mid> <file.wav>
+int RenderAudioOffline(
+    const std::string & _MidiPath,
+    const std::string & _OutputPath
+  )
+{
+  Song Song;
+
+  if (!LoadSong(_MidiPath, Song))
+    return 1;
+
+  if (!OfflineAudioRenderer::Render(Song.Notes, OfflineAudioRenderer::GetDefaultSettings(Song), _OutputPath))
+  {
+    std::cerr << "Cannot write " << _OutputPath << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+// WalnutApp --bench-figures [count]
+int BenchmarkFigures(
+    int     _ArgCount,
+    char ** _Args
+  )
+{
+  const auto FigureCount = _ArgCount > 2 ? std::strtoull(_Args[2], nullptr, 10) : DEFAULT_BENCH_FIGURES;
+
+  return Benchmark::RunFigureLayout(static_cast<std::size_t>(FigureCount));
+}
+
+// WalnutApp --bench-synth [voices]
+int BenchmarkSynth(
+    int     _ArgCount,
+    char ** _Args
+  )
+{
+  const auto VoiceCount = _ArgCount > 2 ? std::strtoull(_Args[2], nullptr, 10) : DEFAULT_BENCH_VOICES;
+
+  return Benchmark::RunSynthesizer(static_cast<std::size_t>(VoiceCount));
+}
+
+// WalnutApp --bench-raster [threads]
+int BenchmarkRaster(
+    int     _ArgCount,
+    char ** _Args
+  )
+{
+  const auto ThreadCount = _ArgCount > 2 ? std::strtoull(_Args[2], nullptr, 10) : DEFAULT_BENCH_THREADS;
+
+  return Benchmark::RunRasterizer(static_cast<unsigned int>(ThreadCount));
+}
+
+// WalnutApp --bench-playback <file.mid> [seconds] [file.wav]
+int BenchmarkPlayback(
+    int     _ArgCount,
+    char ** _Args
+  )
+{
+  Song Song;
+
+  if (!LoadSong(_Args[2], Song))
+    return 1;
+
+  const auto Seconds = _ArgCount > 3 ? std::strtod(_Args[3], nullptr) : DEFAULT_BENCH_SECONDS;
+
+  return Benchmark::RunPlayback(Song, Seconds, _ArgCount > 4 ? _Args[4] : "");
+}
+
+} // namespace
 
 Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
 {
+  // Headless mode, exits before any window or GPU device is created
+  if (argc == 4 && std::strcmp(argv[1], "--render-animation") == 0)
+    std::exit(RenderAnimationOffline(argv[2], argv[3]));
+
+  if (argc == 4 && std::strcmp(argv[1], "--render-audio") == 0)
+    std::exit(RenderAudioOffline(argv[2], argv[3]));
+
+  if (argc >= 2 && std::strcmp(argv[1], "--bench-figures") == 0)
+    std::exit(BenchmarkFigures(argc, argv));
+
+  if (argc >= 2 && std::strcmp(argv[1], "--bench-synth") == 0)
+    std::exit(BenchmarkSynth(argc, argv));
+
+  if (argc >= 2 && std::strcmp(argv[1], "--bench-raster") == 0)
+    std::exit(BenchmarkRaster(argc, argv));
+
+  if (argc >= 3 && std::strcmp(argv[1], "--bench-playback") == 0)
+    std::exit(BenchmarkPlayback(argc, argv));
+
   Walnut::ApplicationSpecification spec;
   spec.Name = "Walnut Example";
 